@@ -11,6 +11,8 @@
 #include <unordered_map>
 #include <functional>
 #include <string_view>
+#include <chrono>
+#include <atomic>
 #include <nlohmann/json.hpp>
 #include <thallium.hpp>
 
@@ -22,6 +24,149 @@ class __PoesieBackendRegistration;
 
 namespace poesie {
 
+/**
+ * @brief An ExecutionContext holds the constraints under which a request
+ * runs. While a script runs, backends periodically poll interrupted()
+ * (e.g. from an instruction-count hook) and abort the script when it
+ * returns true, reporting reason() as the error. A request is interrupted
+ * once its deadline has passed or once it has been cancelled, which may
+ * happen from another thread while the script runs.
+ */
+class ExecutionContext {
+
+    public:
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Constructor. The request has no deadline
+     * and can't be cancelled.
+     */
+    ExecutionContext() = default;
+
+    /**
+     * @brief Constructor. The request must complete within
+     * the specified timeout (0 meaning no deadline). Timeouts too
+     * long to be represented saturate to Clock::time_point::max().
+     *
+     * @param timeout Timeout.
+     * @param cancellable Whether the request may be cancelled.
+     */
+    explicit ExecutionContext(std::chrono::milliseconds timeout,
+                              bool cancellable = false)
+    : m_cancellable(cancellable) {
+        if(timeout.count() <= 0) return;
+        auto now = Clock::now();
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            Clock::time_point::max() - now);
+        if(timeout < remaining) m_deadline = now + timeout;
+    }
+
+    /**
+     * @brief Whether backends need to poll interrupted().
+     */
+    bool interruptible() const {
+        return m_cancellable || m_deadline != Clock::time_point::max();
+    }
+
+    /**
+     * @brief Deadline of the request (Clock::time_point::max() if none).
+     */
+    Clock::time_point deadline() const {
+        return m_deadline;
+    }
+
+    /**
+     * @brief Whether the request should stop running.
+     */
+    bool interrupted() const {
+        return cancelled() || Clock::now() >= m_deadline;
+    }
+
+    /**
+     * @brief Request the script to stop running.
+     */
+    void cancel() {
+        m_cancelled = true;
+    }
+
+    /**
+     * @brief Whether the request has been cancelled.
+     */
+    bool cancelled() const {
+        return m_cancelled;
+    }
+
+    /**
+     * @brief Error message to report when interrupted.
+     */
+    std::string reason() const {
+        if(cancelled()) return "Execution was cancelled";
+        return "Execution exceeded its deadline";
+    }
+
+    private:
+
+    Clock::time_point m_deadline = Clock::time_point::max();
+    bool              m_cancellable = false;
+    std::atomic<bool> m_cancelled = false;
+};
+
+/**
+ * @brief A Yielder makes long-running scripts periodically yield their
+ * execution stream, so that other ULTs (e.g. other providers' RPCs or
+ * the network progress loop) don't starve while a script runs. Backends
+ * call tick() from their instruction-count hooks with the number of
+ * instructions executed since the last call.
+ *
+ * The interval between yields is read from the "yield_interval" entry
+ * of the backend's configuration, in instructions (or lines, for
+ * backends that can't count instructions); 0, the default, disables
+ * yielding.
+ */
+class Yielder {
+
+    public:
+
+    static constexpr size_t DefaultInterval = 0;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param config Configuration of the backend.
+     */
+    explicit Yielder(const nlohmann::json& config) {
+        if(!config.is_object() || !config.contains("yield_interval")) return;
+        if(!config["yield_interval"].is_number_unsigned())
+            throw Exception{"\"yield_interval\" should be a positive integer"};
+        m_interval = config["yield_interval"].get<size_t>();
+    }
+
+    /**
+     * @brief Number of instructions between two yields (0 if disabled).
+     */
+    size_t interval() const {
+        return m_interval;
+    }
+
+    /**
+     * @brief Account for the specified number of instructions,
+     * yielding if the interval has elapsed.
+     */
+    void tick(size_t instructions) {
+        if(!m_interval) return;
+        m_count += instructions;
+        if(m_count < m_interval) return;
+        m_count = 0;
+        thallium::thread::yield();
+    }
+
+    private:
+
+    size_t m_interval = DefaultInterval;
+    size_t m_count    = 0;
+};
+
 /**
  * @brief Interface for vm backends. To build a new backend,
  * implement a class MyBackend that inherits from Backend, and put
@@ -47,6 +192,24 @@ class Backend {
     using ArgsType = std::vector<nlohmann::json>;
     using ForeignFn = std::function<ReturnType(const ArgsType&)>;
 
+    /**
+     * @brief Type of the functions that a plugin library may export
+     * to be installed as native functions (see the "natives" entry
+     * in the provider's configuration). Such functions should be
+     * declared extern "C" so that their symbol is not mangled. Plugin
+     * libraries are only loaded from the "directories" of the "plugins"
+     * entry of the provider's configuration.
+     */
+    using NativeFn = ReturnType(*)(const ArgsType&);
+
+    /**
+     * @brief An AsyncForeignFn is called with the script's arguments to
+     * start an operation and returns a ForeignFuture that, when invoked,
+     * waits for the operation to complete and returns its result.
+     */
+    using ForeignFuture = std::function<ReturnType()>;
+    using AsyncForeignFn = std::function<ForeignFuture(const ArgsType&)>;
+
     /**
      * @brief Constructor.
      */
@@ -94,22 +257,42 @@ class Backend {
      *
      * @param code Code to execute.
      * @param args Arguments to pass to the script.
+     * @param context Constraints on the execution (e.g. deadline).
      *
      * @return a Result containing the result.
      */
     virtual Result<nlohmann::json> execute(std::string_view code,
-                                           const std::vector<nlohmann::json>& args) = 0;
+                                           const std::vector<nlohmann::json>& args,
+                                           const ExecutionContext& context) = 0;
+
+    /**
+     * @brief Execute the provided code in the VM, without constraints.
+     */
+    Result<nlohmann::json> execute(std::string_view code,
+                                   const std::vector<nlohmann::json>& args) {
+        return execute(code, args, ExecutionContext{});
+    }
 
     /**
      * @brief Load the file in the VM and execute its content.
      *
      * @param filename File load load.
      * @param args Arguments to pass to the script.
+     * @param context Constraints on the execution (e.g. deadline).
      *
      * @return a Result containing the result.
      */
     virtual Result<nlohmann::json> load(std::string_view filename,
-                                        const std::vector<nlohmann::json>& args) = 0;
+                                        const std::vector<nlohmann::json>& args,
+                                        const ExecutionContext& context) = 0;
+
+    /**
+     * @brief Load the file in the VM and execute its content, without constraints.
+     */
+    Result<nlohmann::json> load(std::string_view filename,
+                                const std::vector<nlohmann::json>& args) {
+        return load(filename, args, ExecutionContext{});
+    }
 
     /**
      * @brief Invoke the designated function or method.
@@ -117,6 +300,7 @@ class Backend {
      * @param function Name of the function/method.
      * @param target Target object (may be empty for a global function).
      * @param args Array of positional arguments.
+     * @param context Constraints on the execution (e.g. deadline).
      *
      * @return A Result containing the JSON representation of the
      * function's return value.
@@ -124,7 +308,18 @@ class Backend {
     virtual Result<nlohmann::json> call(
             std::string_view function,
             std::string_view target,
-            const std::vector<nlohmann::json>& args) = 0;
+            const std::vector<nlohmann::json>& args,
+            const ExecutionContext& context) = 0;
+
+    /**
+     * @brief Invoke the designated function or method, without constraints.
+     */
+    Result<nlohmann::json> call(
+            std::string_view function,
+            std::string_view target,
+            const std::vector<nlohmann::json>& args) {
+        return call(function, target, args, ExecutionContext{});
+    }
 
     /**
      * @brief Install a foreign function that the backend will be able to use.
@@ -140,6 +335,33 @@ class Backend {
             ForeignFn function,
             size_t nargs) = 0;
 
+    /**
+     * @brief Install an asynchronous foreign function. Backends that
+     * support it will suspend the calling script and release the VM
+     * while waiting on the ForeignFuture returned by the function, so
+     * that other requests can use the VM in the meantime. Only the Lua
+     * backend does so, and only when the function is called from the
+     * script itself rather than from a coroutine the script created.
+     * The default implementation, used by the other backends (including
+     * Python, where awaitables are not supported), waits on the
+     * ForeignFuture from within the script.
+     *
+     * @param name Name of the function.
+     * @param function Function.
+     * @param nargs Number of expected arguments.
+     *
+     * @return Result.
+     */
+    virtual Result<bool> installAsync(
+            std::string_view name,
+            AsyncForeignFn function,
+            size_t nargs) {
+        return install(name,
+            [function=std::move(function)](const ArgsType& args) {
+                return function(args)();
+            }, nargs);
+    }
+
     /**
      * @brief Destroys the underlying vm.
      *
@@ -148,6 +370,20 @@ class Backend {
      */
     virtual Result<bool> destroy() = 0;
 
+    /**
+     * @brief Create a new VM of the same type, in the state this VM
+     * was in right after its creation (i.e. with its preamble run).
+     * The default implementation creates the new VM from the
+     * configuration of this one. Backends whose interpreter can
+     * snapshot or copy its heap may override it to copy that state
+     * instead of running the preamble again.
+     *
+     * @param engine Thallium engine.
+     *
+     * @return a unique_ptr to the new VM.
+     */
+    virtual std::unique_ptr<Backend> clone(const thallium::engine& engine) const;
+
 };
 
 /**
@@ -9,6 +9,7 @@
 #include <poesie/VmHandle.hpp>
 #include <thallium.hpp>
 #include <memory>
+#include <chrono>
 
 namespace poesie {
 
@@ -89,6 +90,84 @@ class Client {
                                       uint16_t provider_id,
                                       bool check = true) const;
 
+    /**
+     * @brief Creates a handle to one of the VMs listed in the "vms"
+     * entry of a provider's configuration. An empty name designates
+     * the VM of the "vm" entry, as the overload above does.
+     *
+     * @param address Address of the provider holding the database.
+     * @param provider_id Provider id.
+     * @param vm_name Name of the VM in the provider.
+     * @param check Checks if the Vm exists by issuing an RPC.
+     *
+     * @return a VmHandle instance.
+     */
+    VmHandle makeVmHandle(const std::string& address,
+                                      uint16_t provider_id,
+                                      const std::string& vm_name,
+                                      bool check = true) const;
+
+    /**
+     * @brief Same as above, so that string literals are not taken for "check".
+     */
+    VmHandle makeVmHandle(const std::string& address,
+                                      uint16_t provider_id,
+                                      const char* vm_name,
+                                      bool check = true) const;
+
+    /**
+     * @brief Creates a VM in a provider and returns a handle to it.
+     * The description has the same format as the entries of the
+     * "vms" field of the provider's configuration, and may contain
+     * "clone_from": name instead of "type" and "config" to create
+     * the VM as a clone of an existing VM of the provider.
+     *
+     * The provider must have "enabled": true in the "remote_vms" entry
+     * of its configuration, which also limits the number of VMs
+     * ("max_vms", replicas and warm pools included) and execution
+     * streams ("max_xstreams") that such VMs may use. Their description
+     * can't contain a "preamble_file".
+     *
+     * @param address Address of the provider.
+     * @param provider_id Provider id.
+     * @param vm_name Name of the VM to create.
+     * @param description Description of the VM.
+     *
+     * @return a VmHandle instance.
+     */
+    VmHandle createVm(const std::string& address,
+                      uint16_t provider_id,
+                      const std::string& vm_name,
+                      const nlohmann::json& description) const;
+
+    /**
+     * @brief Set how requests rejected by overloaded providers are
+     * retried. Each retry waits a random delay of up to a backoff that
+     * doubles after each attempt, up to max_backoff, and only gets what
+     * remains of the request's timeout. Setting max_retries to 0
+     * disables retries.
+     * Applies to the requests issued afterwards by all the VmHandles
+     * created by this Client.
+     *
+     * @param max_retries Maximum number of retries per request.
+     * @param initial_backoff Delay before the first retry.
+     * @param max_backoff Maximum delay between two attempts.
+     */
+    void setRetryPolicy(size_t max_retries,
+                        std::chrono::milliseconds initial_backoff = std::chrono::milliseconds{10},
+                        std::chrono::milliseconds max_backoff = std::chrono::milliseconds{1000});
+
+    /**
+     * @brief Set how many registrations of client buffers passed to
+     * MemoryViews are kept, so that a buffer passed in many consecutive
+     * calls is only exposed once. 0 (the default) disables the cache.
+     * The cache is shared with the providers using the same engine.
+     * See RegistrationCache for when it is not safe to enable it.
+     *
+     * @param capacity Maximum number of registrations kept.
+     */
+    void setRegistrationCacheCapacity(size_t capacity);
+
     /**
      * @brief Checks that the Client instance is valid.
      */
@@ -26,6 +26,18 @@ class Exception : public std::exception {
     }
 };
 
+/**
+ * @brief Exception thrown when a request was rejected without being
+ * processed, e.g. because the provider was overloaded, and may succeed
+ * if sent again later.
+ */
+class RetryableException : public Exception {
+
+    public:
+
+    using Exception::Exception;
+};
+
 }
 
 #endif
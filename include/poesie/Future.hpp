@@ -23,6 +23,13 @@ class Future {
 
     public:
 
+    /**
+     * @brief Type of the function called when the request was rejected
+     * with a retryable error. It sends the request again (after some delay)
+     * and replaces the response to wait on, or returns false to give up.
+     */
+    using RetryFn = std::function<bool(thallium::async_response&)>;
+
     /**
      * @brief Copy constructor.
      */
@@ -54,10 +61,15 @@ class Future {
     ~Future() = default;
 
     /**
-     * @brief Wait for the request to complete.
+     * @brief Wait for the request to complete. If the provider rejected
+     * the request because it was overloaded, the request is sent again
+     * according to the client's retry policy, and a RetryableException
+     * is thrown if it still gets rejected.
      */
     T wait() {
         Result<Wrapper> result = m_resp.wait();
+        while(!result.success() && result.retryable() && m_retry && m_retry(m_resp))
+            result = m_resp.wait();
         return std::move(result).valueOrThrow();
     }
 
@@ -68,15 +80,36 @@ class Future {
         return m_resp.received();
     }
 
+    /**
+     * @brief Ask the provider to stop working on the request, whether
+     * it is still queued or already running. The Future still has to
+     * be waited on; wait() will throw if the request got cancelled
+     * before it completed. Does nothing if the request has completed
+     * or if the operation can't be cancelled.
+     */
+    void cancel() {
+        if(m_cancel && !completed()) m_cancel();
+    }
+
     /**
      * @brief Constructor.
+     *
+     * @param resp Response to wait on.
+     * @param cancel Function that cancels the request.
+     * @param retry Function that sends the request again.
      */
-    Future(thallium::async_response resp)
-    : m_resp(std::move(resp)) {}
+    Future(thallium::async_response resp,
+           std::function<void()> cancel = {},
+           RetryFn retry = {})
+    : m_resp(std::move(resp))
+    , m_cancel(std::move(cancel))
+    , m_retry(std::move(retry)) {}
 
     private:
 
     thallium::async_response m_resp;
+    std::function<void()>    m_cancel;
+    RetryFn                  m_retry;
 };
 
 }
@@ -11,6 +11,9 @@
 #include <optional>
 #include <memory>
 #include <cstdint>
+#include <vector>
+#include <utility>
+#include <string>
 
 namespace poesie {
 
@@ -39,6 +42,15 @@ class MemoryView {
                size_t size,
                Intent intent);
 
+    /**
+     * @brief Constructor using a list of local (pointer, size) segments.
+     * The provider sees the segments as a single logical buffer, the
+     * boundaries of which are available through segments().
+     */
+    MemoryView(thallium::engine engine,
+               const std::vector<std::pair<const char*, size_t>>& segments,
+               Intent intent);
+
     /**
      * @brief Constructor using a serialized JSON object.
      */
@@ -97,6 +109,90 @@ class MemoryView {
      */
     size_t size() const;
 
+    /**
+     * @brief Return pointer to local data without waiting for the
+     * data to be fully received. If the view is streamed or lazy (i.e.
+     * its numChunks() is greater than 1), access or waitChunk must be
+     * called before accessing the content of a range or chunk. Code that
+     * hands the pointer to something that does not call access (e.g. a
+     * script indexing a buffer) should use data() instead, which fetches
+     * the whole view first (and marks it as modified).
+     */
+    char* rawData() const;
+
+    /**
+     * @brief Make the specified range of the view available locally,
+     * waiting for the chunks it spans if the view is streamed or fetching
+     * its missing pages if the view is lazy. If write is true, the range
+     * is marked as modified so that it is pushed back when the view is
+     * destroyed (for OUT and INOUT views). Contrary to access, data()
+     * makes the whole view available and marks it as modified.
+     *
+     * @return a pointer to the local data at the requested offset.
+     */
+    char* access(size_t offset, size_t size, bool write = false) const;
+
+    /**
+     * @brief Whether the view's pages are only fetched when accessed.
+     */
+    bool isLazy() const;
+
+    /**
+     * @brief Whether only the ranges marked as modified through access
+     * (or data()) are pushed back when the view is destroyed. This is
+     * the case of lazy views and, if "track_writes" is enabled, of OUT and
+     * INOUT views that keep a local copy of the data. Bindings exposing
+     * such a view to a script must call access for every write.
+     */
+    bool tracksWrites() const;
+
+    /**
+     * @brief Return the size of the chunks in which the data is
+     * received (the last chunk may be smaller), i.e. the chunk size
+     * of a streamed view or the page size of a lazy view. Other views
+     * consist of a single chunk.
+     */
+    size_t chunkSize() const;
+
+    /**
+     * @brief Return the number of chunks in which the data is received.
+     */
+    size_t numChunks() const;
+
+    /**
+     * @brief Make the specified chunk available (see access),
+     * and return a pointer to the chunk.
+     */
+    char* waitChunk(size_t index) const;
+
+    /**
+     * @brief Create a view of the specified range of this view. The slice
+     * shares the local data, and the streaming, lazy-fetching, and write
+     * tracking state of the view it is taken from, so creating and
+     * accessing it requires neither exposing memory nor extra transfers.
+     * Its modifications are written back with the parent view. A slice
+     * serialized with toJson refers to the corresponding range of the
+     * owner's memory.
+     */
+    MemoryView slice(size_t offset, size_t size) const;
+
+    /**
+     * @brief Start pushing the local data of an OUT or INOUT view back
+     * to its owner without waiting for the transfers to complete. The
+     * destruction of the last copy of the view waits for them (and starts
+     * them if writeBack was never called). The view must not be modified
+     * after this call, as later modifications may or may not be pushed.
+     * Calling writeBack on a slice has no effect.
+     */
+    void writeBack() const;
+
+    /**
+     * @brief Return the (offset, size) of the client memory segments that
+     * the view spans, relative to the beginning of the view. Views built
+     * from a single buffer, or from a bulk handle, have a single segment.
+     */
+    std::vector<std::pair<size_t, size_t>> segments() const;
+
     /**
      * @brief Get the intent of the MemoryView.
      */
@@ -117,11 +213,58 @@ class MemoryView {
      */
     nlohmann::json toJson() const;
 
+    /**
+     * @brief Create a MemoryView of a range of a local file by mapping it
+     * in memory. The view gives direct access to the mapped data and can be
+     * serialized with toJson for remote processes to access the range.
+     * Modifications made to an OUT or INOUT view are written to the file,
+     * those made to an IN view are private. The file is unmapped when the
+     * last copy of the view is destroyed.
+     *
+     * Only files under the directories listed in the "files" entry of the
+     * "memory_views" configuration of a provider can be mapped, and OUT and
+     * INOUT views require "writable" to be set to true in that entry.
+     *
+     * @param engine Engine.
+     * @param path Path of the file.
+     * @param offset Offset of the range in the file (default 0).
+     * @param size Size of the range (default = size of the file - offset).
+     * @param intent Intent of the view (default IN).
+     */
+    static MemoryView FromFile(thallium::engine engine,
+                               const std::string& path,
+                               size_t offset = 0,
+                               std::optional<size_t> size = std::nullopt,
+                               Intent intent = Intent::IN);
+
+    /**
+     * @brief Create a MemoryView of a newly allocated local buffer of the
+     * provided size. The buffer is freed when the last copy of the view is
+     * destroyed; like other views, it can be serialized with toJson for
+     * remote processes to access it in the meantime.
+     *
+     * @param engine Engine.
+     * @param size Size of the buffer.
+     * @param intent Intent of the view (default INOUT).
+     */
+    static MemoryView Allocate(thallium::engine engine,
+                               size_t size,
+                               Intent intent = Intent::INOUT);
+
     /**
      * @brief Checks if the JSON object is convertible to a MemoryView.
      */
     static bool IsMemoryView(const nlohmann::json& j);
 
+    /**
+     * @brief Find the streamed, lazy, write-tracking, or multi-segment
+     * MemoryView whose local data contains the provided pointer. This
+     * allows language bindings that only hold the pointer returned by
+     * rawData() to call access or segments.
+     * Returns an invalid MemoryView if no such view is found.
+     */
+    static MemoryView FromData(const void* ptr);
+
     private:
 
     std::shared_ptr<MemoryViewImpl> self;
@@ -70,9 +70,37 @@ class Provider {
     std::string getConfig() const;
 
     /**
-     * @brief Get a pointer to the internal backend.
+     * @brief Return JSON-formatted statistics about the provider
+     * (e.g. hit rate of the MemoryView staging buffer pool).
+     *
+     * @return JSON formatted string.
+     */
+    std::string getStatistics() const;
+
+    /**
+     * @brief Get a pointer to the internal backend of a VM.
+     *
+     * @deprecated The pointer dangles once the VM is destroyed
+     * (e.g. by a client), use getSharedBackend instead.
+     *
+     * @param vm_name Name of the VM in the "vms" entry of the
+     * configuration, or empty for the VM of the "vm" entry.
+     *
+     * @return The backend, or nullptr if there is no such VM.
+     */
+    [[deprecated("use getSharedBackend")]]
+    Backend* getBackend(const std::string& vm_name = "") const;
+
+    /**
+     * @brief Get the internal backend of a VM, which remains
+     * valid after the VM is destroyed.
+     *
+     * @param vm_name Name of the VM in the "vms" entry of the
+     * configuration, or empty for the VM of the "vm" entry.
+     *
+     * @return The backend, or nullptr if there is no such VM.
      */
-    Backend* getBackend() const;
+    std::shared_ptr<Backend> getSharedBackend(const std::string& vm_name = "") const;
 
     /**
      * @brief Checks whether the Provider instance is valid.
@@ -19,6 +19,11 @@ namespace poesie {
  * - error must be set to an error string if an error occured
  * - value must be set to the result of the request if it succeeded
  *
+ * A failed Result may additionally be flagged as retryable, meaning that
+ * the request was rejected without being processed (e.g. because the
+ * provider was overloaded) and may succeed if sent again later. check()
+ * then throws a RetryableException instead of an Exception.
+ *
  * This class is specialized for two types: bool and std::string.
  * If bool is used, both the value and the success fields will be
  * managed by the same underlying variable. If std::string is used,
@@ -40,30 +45,34 @@ class Result {
     template<typename U>
     Result(Result<U>&& other)
     : m_success{other.m_success}
+    , m_retryable{other.m_retryable}
     , m_error{std::move(other.m_error)}
     , m_value{std::move(other.m_value)} {}
 
     template<typename U>
     Result(const Result<U>& other)
     : m_success{other.m_success}
+    , m_retryable{other.m_retryable}
     , m_error{other.m_error}
     , m_value{other.m_value} {}
 
     template<typename U>
     Result& operator=(Result<U>&& other) {
         if(this == reinterpret_cast<decltype(this)>(&other)) return *this;
-        m_success = other.m_success;
-        m_error   = std::move(other.m_error);
-        m_value   = std::move(other.m_value);
+        m_success   = other.m_success;
+        m_retryable = other.m_retryable;
+        m_error     = std::move(other.m_error);
+        m_value     = std::move(other.m_value);
         return *this;
     }
 
     template<typename U>
     Result& operator=(const Result<U>& other) {
         if(this == reinterpret_cast<decltype(this)>(&other)) return *this;
-        m_success = other.m_success;
-        m_error   = other.m_error;
-        m_value   = other.m_value;
+        m_success   = other.m_success;
+        m_retryable = other.m_retryable;
+        m_error     = other.m_error;
+        m_value     = other.m_value;
         return *this;
     }
 
@@ -81,6 +90,20 @@ class Result {
         return m_success;
     }
 
+    /**
+     * @brief Whether the failed request may be sent again.
+     */
+    bool& retryable() {
+        return m_retryable;
+    }
+
+    /**
+     * @brief Whether the failed request may be sent again.
+     */
+    const bool& retryable() const {
+        return m_retryable;
+    }
+
     /**
      * @brief Error string if the request failed.
      */
@@ -152,8 +175,10 @@ class Result {
      * contains an error.
      */
     void check() const {
-        if(!m_success)
-            throw Exception(m_error);
+        if(m_success) return;
+        if(m_retryable)
+            throw RetryableException(m_error);
+        throw Exception(m_error);
     }
 
     /**
@@ -168,14 +193,16 @@ class Result {
         if(m_success) {
             a & m_value;
         } else {
+            a & m_retryable;
             a & m_error;
         }
     }
 
     private:
 
-    bool        m_success = true;
-    std::string m_error   = "";
+    bool        m_success   = true;
+    bool        m_retryable = false;
+    std::string m_error     = "";
     T           m_value;
 };
 
@@ -198,6 +225,14 @@ class Result<std::string> {
         return m_success;
     }
 
+    bool& retryable() {
+        return m_retryable;
+    }
+
+    const bool& retryable() const {
+        return m_retryable;
+    }
+
     std::string& error() {
         return m_content;
     }
@@ -235,20 +270,25 @@ class Result<std::string> {
     }
 
     void check() const {
-        if(!m_success)
-            throw Exception(m_content);
+        if(m_success) return;
+        if(m_retryable)
+            throw RetryableException(m_content);
+        throw Exception(m_content);
     }
 
     template<typename Archive>
     void serialize(Archive& a) {
         a & m_success;
+        if(!m_success)
+            a & m_retryable;
         a & m_content;
     }
 
     private:
 
-    bool        m_success = true;
-    std::string m_content = "";
+    bool        m_success   = true;
+    bool        m_retryable = false;
+    std::string m_content   = "";
 };
 
 template<>
@@ -270,6 +310,14 @@ class Result<bool> {
         return m_success;
     }
 
+    bool& retryable() {
+        return m_retryable;
+    }
+
+    const bool& retryable() const {
+        return m_retryable;
+    }
+
     std::string& error() {
         return m_error;
     }
@@ -298,21 +346,26 @@ class Result<bool> {
     }
 
     void check() const {
-        if(!m_success)
-            throw Exception(m_error);
+        if(m_success) return;
+        if(m_retryable)
+            throw RetryableException(m_error);
+        throw Exception(m_error);
     }
 
     template<typename Archive>
     void serialize(Archive& a) {
         a & m_success;
-        if(!m_success)
+        if(!m_success) {
+            a & m_retryable;
             a & m_error;
+        }
     }
 
     private:
 
-    bool        m_success = true;
-    std::string m_error   = "";
+    bool        m_success   = true;
+    bool        m_retryable = false;
+    std::string m_error     = "";
 };
 
 }
@@ -8,6 +8,7 @@
 
 #include <thallium.hpp>
 #include <memory>
+#include <chrono>
 #include <string_view>
 #include <unordered_set>
 #include <nlohmann/json.hpp>
@@ -72,33 +73,60 @@ class VmHandle {
      */
     Client client() const;
 
+    /**
+     * @brief Returns the name of the VM this handle targets
+     * in its provider (empty for the VM of the "vm" entry).
+     */
+    const std::string& vmName() const;
 
     /**
      * @brief Checks if the VmHandle instance is valid.
      */
     operator bool() const;
 
+    /**
+     * @brief Set the priority class of the requests sent through
+     * this VmHandle (see the "scheduler" entry of the provider's
+     * configuration). An empty string lets the provider choose
+     * the class. Copies of this VmHandle are not affected.
+     *
+     * @param priority_class Name of the priority class.
+     */
+    void setPriorityClass(std::string_view priority_class);
+
+    /**
+     * @brief Returns the priority class of the requests sent
+     * through this VmHandle.
+     */
+    const std::string& priorityClass() const;
+
     /**
      * @brief Requests the target vm to execute the provided code.
      *
      * @param[in] code Code to execute.
      * @param[in] args Arguments to pass to the script.
+     * @param[in] timeout Time after which the provider interrupts
+     * the request (0 for no timeout).
      *
      * @return a Future that the caller can wait on.
      */
     FutureType execute(std::string_view code,
-                       const ArgsType& args = ArgsType{}) const;
+                       const ArgsType& args = ArgsType{},
+                       std::chrono::milliseconds timeout = std::chrono::milliseconds{0}) const;
 
     /**
      * @brief Requests the target vm to load the specified file.
      *
      * @param[in] filename File to load.
      * @param[in] args Arguments to pass to the script.
+     * @param[in] timeout Time after which the provider interrupts
+     * the request (0 for no timeout).
      *
      * @return a Future that the caller can wait on.
      */
     FutureType load(std::string_view filename,
-                    const ArgsType& args = ArgsType{}) const;
+                    const ArgsType& args = ArgsType{},
+                    std::chrono::milliseconds timeout = std::chrono::milliseconds{0}) const;
 
     /**
      * @brief Requests the target vm to call the specified
@@ -108,13 +136,52 @@ class VmHandle {
      * @param[in] function Function to call.
      * @param[in] target Target object (may be empty).
      * @param[in] args array of arguments.
+     * @param[in] read_only Whether the function only reads the state
+     * of the vm. If the provider replicates its vm, such calls may run
+     * concurrently on any replica.
+     * @param[in] timeout Time after which the provider interrupts
+     * the request (0 for no timeout).
      *
      * @return a Future that the caller can wait on.
      */
     FutureType call(
         std::string_view function,
         std::string_view target,
-        const ArgsType& args) const;
+        const ArgsType& args,
+        bool read_only = false,
+        std::chrono::milliseconds timeout = std::chrono::milliseconds{0}) const;
+
+    /**
+     * @brief Requests the target vm to load the specified library
+     * and install the function it exports under the specified symbol
+     * as a foreign function with the specified name. The symbol should
+     * have the signature of a poesie::Backend::NativeFn.
+     *
+     * The provider must have "remote_install": true in the "plugins"
+     * entry of its configuration, and the library must be in one of
+     * the "directories" of that entry.
+     *
+     * @param[in] library Shared library to load on the provider.
+     * @param[in] symbol Symbol of the function in the library.
+     * @param[in] name Name under which to install the function.
+     * @param[in] nargs Number of arguments the function expects.
+     *
+     * @return a Future that the caller can wait on.
+     */
+    Future<bool> installNative(
+        std::string_view library,
+        std::string_view symbol,
+        std::string_view name,
+        size_t nargs) const;
+
+    /**
+     * @brief Requests the provider to destroy the target vm, which
+     * should have been created with Client::createVm. Requests already
+     * running on the vm complete normally.
+     *
+     * @return a Future that the caller can wait on.
+     */
+    Future<bool> destroy() const;
 
     private:
 
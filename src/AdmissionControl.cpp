@@ -0,0 +1,112 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "poesie/Exception.hpp"
+#include "AdmissionControl.hpp"
+
+namespace poesie {
+
+using json = nlohmann::json;
+
+// Approximate memory held by a JSON value, dominated by
+// strings and binary data for large payloads.
+static size_t payloadSize(const json& value) {
+    switch(value.type()) {
+        case json::value_t::string:
+            return value.get_ref<const json::string_t&>().size();
+        case json::value_t::binary:
+            return value.get_binary().size();
+        case json::value_t::array: {
+            size_t size = 0;
+            for(auto& item : value) size += payloadSize(item);
+            return size;
+        }
+        case json::value_t::object: {
+            size_t size = 0;
+            for(auto& [key, item] : value.items())
+                size += key.size() + payloadSize(item);
+            return size;
+        }
+        default:
+            return sizeof(json);
+    }
+}
+
+void AdmissionControl::configure(const json& config) {
+    if(!config.is_object())
+        throw Exception{"Admission configuration should be an object"};
+    for(auto& field : {"max_in_flight", "max_queued_bytes"}) {
+        if(config.contains(field) && !config[field].is_number_unsigned())
+            throw Exception{std::string{"\""} + field + "\" should be a positive integer"};
+    }
+    m_max_in_flight    = config.value("max_in_flight", size_t{0});
+    m_max_queued_bytes = config.value("max_queued_bytes", size_t{0});
+    m_enabled          = true;
+}
+
+json AdmissionControl::getConfig() const {
+    return json{
+        {"max_in_flight", m_max_in_flight},
+        {"max_queued_bytes", m_max_queued_bytes}
+    };
+}
+
+json AdmissionControl::getStatistics() const {
+    return json{
+        {"in_flight", m_in_flight.load()},
+        {"queued_bytes", m_queued_bytes.load()},
+        {"admitted", m_admitted.load()},
+        {"rejected", m_rejected.load()}
+    };
+}
+
+bool AdmissionControl::admit(Permit& permit, std::string_view code,
+                             const std::vector<json>& args) {
+    if(!m_enabled) return true;
+    size_t bytes = code.size();
+    for(auto& arg : args) bytes += payloadSize(arg);
+    auto in_flight = m_in_flight.fetch_add(1) + 1;
+    auto queued_bytes = m_queued_bytes.fetch_add(bytes) + bytes;
+    // a request is always admitted when nothing else is in flight,
+    // otherwise a request larger than the limit could never run
+    if(in_flight > 1
+    && ((m_max_in_flight && in_flight > m_max_in_flight)
+     || (m_max_queued_bytes && queued_bytes > m_max_queued_bytes))) {
+        m_in_flight -= 1;
+        m_queued_bytes -= bytes;
+        m_rejected += 1;
+        return false;
+    }
+    m_admitted += 1;
+    permit.m_admission = this;
+    permit.m_bytes     = bytes;
+    return true;
+}
+
+void AdmissionControl::release(Permit& permit) {
+    m_in_flight -= 1;
+    m_queued_bytes -= permit.m_bytes;
+}
+
+AdmissionControl::Permit::Permit(Permit&& other)
+: m_admission(other.m_admission)
+, m_bytes(other.m_bytes) {
+    other.m_admission = nullptr;
+}
+
+AdmissionControl::Permit& AdmissionControl::Permit::operator=(Permit&& other) {
+    if(this == &other) return *this;
+    if(m_admission) m_admission->release(*this);
+    m_admission = other.m_admission;
+    m_bytes     = other.m_bytes;
+    other.m_admission = nullptr;
+    return *this;
+}
+
+AdmissionControl::Permit::~Permit() {
+    if(m_admission) m_admission->release(*this);
+}
+
+}
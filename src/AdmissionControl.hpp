@@ -0,0 +1,107 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __POESIE_ADMISSION_CONTROL_H
+#define __POESIE_ADMISSION_CONTROL_H
+
+#include <nlohmann/json.hpp>
+#include <string_view>
+#include <vector>
+#include <atomic>
+
+namespace poesie {
+
+/**
+ * @brief The AdmissionControl bounds the amount of work a provider accepts,
+ * so that under overload requests are rejected right away instead of
+ * piling up (along with their arguments) while waiting for the VM.
+ * It is configured through the "admission" entry of the provider's
+ * configuration:
+ *
+ * {
+ *    "max_in_flight": 64,
+ *    "max_queued_bytes": 67108864
+ * }
+ *
+ * "max_in_flight" bounds the number of execute, load, and call requests
+ * being handled at the same time, whether waiting for the VM or running.
+ * "max_queued_bytes" bounds the total size of the code and arguments held
+ * by these requests. Both are optional; a limit of 0 means no limit.
+ * Rejected requests fail with a retryable error (see Result::retryable),
+ * which clients respond to by sending the request again after a delay.
+ */
+class AdmissionControl {
+
+    public:
+
+    /**
+     * @brief A Permit accounts for an admitted request until it is destroyed.
+     */
+    class Permit {
+
+        friend class AdmissionControl;
+
+        AdmissionControl* m_admission = nullptr;
+        size_t            m_bytes     = 0;
+
+        public:
+
+        Permit() = default;
+        Permit(Permit&& other);
+        Permit& operator=(Permit&& other);
+        Permit(const Permit&) = delete;
+        Permit& operator=(const Permit&) = delete;
+        ~Permit();
+    };
+
+    AdmissionControl() = default;
+
+    /**
+     * @brief Enable admission control with the provided configuration.
+     */
+    void configure(const nlohmann::json& config);
+
+    /**
+     * @brief Whether admission control has been configured.
+     */
+    bool enabled() const {
+        return m_enabled;
+    }
+
+    /**
+     * @brief Get the configuration of the admission control.
+     */
+    nlohmann::json getConfig() const;
+
+    /**
+     * @brief Get the number of admitted and rejected requests,
+     * and the current load.
+     */
+    nlohmann::json getStatistics() const;
+
+    /**
+     * @brief Try to admit a request carrying the provided code and
+     * arguments. Returns false if admitting it would exceed a limit.
+     * If admission control is disabled, always returns true.
+     */
+    bool admit(Permit& permit, std::string_view code,
+               const std::vector<nlohmann::json>& args);
+
+    private:
+
+    void release(Permit& permit);
+
+    bool                m_enabled          = false;
+    size_t              m_max_in_flight    = 0;
+    size_t              m_max_queued_bytes = 0;
+    std::atomic<size_t> m_in_flight        = 0;
+    std::atomic<size_t> m_queued_bytes     = 0;
+    std::atomic<size_t> m_admitted         = 0;
+    std::atomic<size_t> m_rejected         = 0;
+};
+
+}
+
+#endif
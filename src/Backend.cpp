@@ -23,4 +23,8 @@ std::unique_ptr<Backend> VmFactory::createVm(const std::string& backend_name,
     return f(engine, config);
 }
 
+std::unique_ptr<Backend> Backend::clone(const tl::engine& engine) const {
+    return VmFactory::createVm(m_name, engine, json::parse(getConfig()));
+}
+
 }
@@ -0,0 +1,149 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "poesie/Exception.hpp"
+#include "BufferPool.hpp"
+#include "MemoryViewContext.hpp"
+
+namespace poesie {
+
+void BufferPool::configure(const nlohmann::json& config) {
+    if(!config.is_object())
+        throw Exception{"BufferPool configuration should be an object"};
+    auto getSize = [&config](const char* key, size_t current) -> size_t {
+        if(!config.contains(key)) return current;
+        if(!config[key].is_number_unsigned())
+            throw Exception{std::string{"\""} + key + "\" should be a positive integer"};
+        return config[key].get<size_t>();
+    };
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    m_max_pinned_bytes = getSize("max_pinned_bytes", m_max_pinned_bytes);
+    m_min_buffer_size  = getSize("min_buffer_size", m_min_buffer_size);
+    m_max_buffer_size  = getSize("max_buffer_size", m_max_buffer_size);
+    if(m_min_buffer_size == 0 || m_min_buffer_size > m_max_buffer_size)
+        throw Exception{"Invalid \"min_buffer_size\" and \"max_buffer_size\" in BufferPool configuration"};
+    for(auto& p : m_free) {
+        for(auto& buffer : p.second) freeBuffer(buffer);
+    }
+    m_free.clear();
+}
+
+nlohmann::json BufferPool::getConfig() const {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    return nlohmann::json{
+        {"max_pinned_bytes", m_max_pinned_bytes},
+        {"min_buffer_size", m_min_buffer_size},
+        {"max_buffer_size", m_max_buffer_size}
+    };
+}
+
+nlohmann::json BufferPool::getStatistics() const {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    auto total = m_hits + m_misses + m_bypasses;
+    return nlohmann::json{
+        {"pinned_bytes", m_pinned_bytes},
+        {"hits", m_hits},
+        {"misses", m_misses},
+        {"bypasses", m_bypasses},
+        {"hit_rate", total ? (double)m_hits/total : 0.0}
+    };
+}
+
+bool BufferPool::acquire(const tl::engine& engine, size_t size, Buffer& buffer) {
+    {
+        std::unique_lock<tl::mutex> lock{m_mtx};
+        auto capacity = sizeClass(size);
+        if(m_closed || capacity == 0 || capacity > m_max_pinned_bytes) {
+            m_bypasses += 1;
+            return false;
+        }
+        auto& free_list = m_free[capacity];
+        if(!free_list.empty()) {
+            buffer = std::move(free_list.back());
+            free_list.pop_back();
+            m_hits += 1;
+            return true;
+        }
+        // evict unused buffers of other size classes, largest first,
+        // until the new buffer fits under the cap on pinned memory
+        for(auto it = m_free.rbegin(); it != m_free.rend(); ++it) {
+            auto& buffers = it->second;
+            while(!buffers.empty() && m_pinned_bytes + capacity > m_max_pinned_bytes) {
+                freeBuffer(buffers.back());
+                buffers.pop_back();
+            }
+        }
+        if(m_pinned_bytes + capacity > m_max_pinned_bytes) {
+            m_bypasses += 1;
+            return false;
+        }
+        m_pinned_bytes += capacity;
+        m_misses += 1;
+        buffer.capacity = capacity;
+    }
+    // allocate and register the new buffer outside of the lock
+    try {
+        buffer.data = new char[buffer.capacity];
+        buffer.bulk = engine.expose({{buffer.data, buffer.capacity}}, tl::bulk_mode::read_write);
+    } catch(...) {
+        delete[] buffer.data;
+        std::unique_lock<tl::mutex> lock{m_mtx};
+        m_pinned_bytes -= buffer.capacity;
+        buffer = Buffer{};
+        throw;
+    }
+    return true;
+}
+
+void BufferPool::release(Buffer&& buffer) {
+    if(!buffer.data) return;
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    if(m_closed || m_pinned_bytes > m_max_pinned_bytes
+    || buffer.capacity != sizeClass(buffer.capacity)) {
+        freeBuffer(buffer);
+        return;
+    }
+    m_free[buffer.capacity].push_back(std::move(buffer));
+    buffer = Buffer{};
+}
+
+BufferPool::~BufferPool() {
+    // no locking here: the pool may outlive the
+    // engine, and nothing else can be using it
+    for(auto& p : m_free) {
+        for(auto& buffer : p.second) freeBuffer(buffer);
+    }
+}
+
+void BufferPool::clear() {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    m_closed = true;
+    for(auto& p : m_free) {
+        for(auto& buffer : p.second) freeBuffer(buffer);
+    }
+    m_free.clear();
+}
+
+std::shared_ptr<BufferPool> BufferPool::Get(const tl::engine& engine) {
+    auto context = MemoryViewContext::Get(engine);
+    // the pool shares the ownership of its context
+    return std::shared_ptr<BufferPool>{context, &context->pool};
+}
+
+size_t BufferPool::sizeClass(size_t size) const {
+    if(size > m_max_buffer_size) return 0;
+    size_t capacity = m_min_buffer_size;
+    while(capacity < size) capacity <<= 1;
+    return capacity;
+}
+
+void BufferPool::freeBuffer(Buffer& buffer) {
+    buffer.bulk = tl::bulk{};
+    delete[] buffer.data;
+    m_pinned_bytes -= buffer.capacity;
+    buffer = Buffer{};
+}
+
+}
@@ -0,0 +1,107 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __POESIE_BUFFER_POOL_H
+#define __POESIE_BUFFER_POOL_H
+
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+#include <vector>
+#include <map>
+#include <memory>
+
+namespace poesie {
+
+namespace tl = thallium;
+
+/**
+ * @brief The BufferPool keeps buffers that have already been exposed
+ * as bulk handles, so that MemoryViews needing a local staging buffer
+ * can borrow one instead of allocating and registering memory for every
+ * request. Buffers are organized in power-of-two size classes between
+ * "min_buffer_size" and "max_buffer_size", and the total amount of memory
+ * held by the pool is capped by "max_pinned_bytes" (0, the default,
+ * disables the pool). A single BufferPool is shared by all the MemoryViews
+ * using a given engine (see MemoryViewContext).
+ */
+class BufferPool {
+
+    public:
+
+    struct Buffer {
+        char*    data     = nullptr;
+        size_t   capacity = 0;
+        tl::bulk bulk;
+    };
+
+    BufferPool() = default;
+
+    ~BufferPool();
+
+    /**
+     * @brief Change the configuration of the pool. Buffers currently
+     * in the pool are released.
+     */
+    void configure(const nlohmann::json& config);
+
+    /**
+     * @brief Get the configuration of the pool.
+     */
+    nlohmann::json getConfig() const;
+
+    /**
+     * @brief Get the usage statistics of the pool.
+     */
+    nlohmann::json getStatistics() const;
+
+    /**
+     * @brief Borrow a buffer of at least the requested size, exposed
+     * in read-write mode, allocating it with the provided engine if no
+     * buffer of the right size class is available. Returns false if the
+     * request cannot be served by the pool (pool disabled, size too large,
+     * or cap on pinned memory reached), in which case the caller should
+     * allocate its own buffer.
+     */
+    bool acquire(const tl::engine& engine, size_t size, Buffer& buffer);
+
+    /**
+     * @brief Give back a buffer obtained from acquire.
+     */
+    void release(Buffer&& buffer);
+
+    /**
+     * @brief Free all the buffers currently in the pool. Buffers
+     * released after this call will be freed instead of pooled.
+     */
+    void clear();
+
+    /**
+     * @brief Get the BufferPool associated with the engine, creating it
+     * if needed (this is the pool of the engine's MemoryViewContext).
+     * The pool is cleared when the engine is finalized.
+     */
+    static std::shared_ptr<BufferPool> Get(const tl::engine& engine);
+
+    private:
+
+    size_t sizeClass(size_t size) const;
+    void freeBuffer(Buffer& buffer);
+
+    mutable tl::mutex                     m_mtx;
+    bool                                  m_closed           = false;
+    size_t                                m_max_pinned_bytes = 0;
+    size_t                                m_min_buffer_size  = 4096;
+    size_t                                m_max_buffer_size  = 64*1024*1024;
+    size_t                                m_pinned_bytes     = 0;
+    std::map<size_t, std::vector<Buffer>> m_free;
+    // statistics
+    size_t m_hits     = 0; // served from a free buffer
+    size_t m_misses   = 0; // served by registering a new buffer
+    size_t m_bypasses = 0; // could not be served by the pool
+};
+
+}
+
+#endif
@@ -10,6 +10,7 @@
 
 #include "ClientImpl.hpp"
 #include "VmHandleImpl.hpp"
+#include "MemoryViewContext.hpp"
 
 #include <thallium/serialization/stl/string.hpp>
 
@@ -51,6 +52,14 @@ VmHandle Client::makeVmHandle(
         const std::string& address,
         uint16_t provider_id,
         bool check) const {
+    return makeVmHandle(address, provider_id, std::string{}, check);
+}
+
+VmHandle Client::makeVmHandle(
+        const std::string& address,
+        uint16_t provider_id,
+        const std::string& vm_name,
+        bool check) const {
     auto endpoint  = self->m_engine.lookup(address);
     auto ph        = tl::provider_handle(endpoint, provider_id);
     if(check) {
@@ -62,11 +71,49 @@ VmHandle Client::makeVmHandle(
             throw Exception{ex.what()};
         }
     }
-    return std::make_shared<VmHandleImpl>(self, std::move(ph));
+    return std::make_shared<VmHandleImpl>(self, std::move(ph), vm_name);
+}
+
+VmHandle Client::makeVmHandle(
+        const std::string& address,
+        uint16_t provider_id,
+        const char* vm_name,
+        bool check) const {
+    return makeVmHandle(address, provider_id, std::string{vm_name}, check);
+}
+
+VmHandle Client::createVm(
+        const std::string& address,
+        uint16_t provider_id,
+        const std::string& vm_name,
+        const nlohmann::json& description) const {
+    if(not self) throw Exception("Invalid poesie::Client object");
+    auto endpoint  = self->m_engine.lookup(address);
+    auto ph        = tl::provider_handle(endpoint, provider_id);
+    Result<bool> result = self->m_create_vm.on(ph)(vm_name, description.dump());
+    result.check();
+    return std::make_shared<VmHandleImpl>(self, std::move(ph), vm_name);
+}
+
+void Client::setRetryPolicy(size_t max_retries,
+                            std::chrono::milliseconds initial_backoff,
+                            std::chrono::milliseconds max_backoff) {
+    if(not self) throw Exception("Invalid poesie::Client object");
+    self->m_max_retries     = max_retries;
+    self->m_initial_backoff = initial_backoff;
+    self->m_max_backoff     = max_backoff;
+}
+
+void Client::setRegistrationCacheCapacity(size_t capacity) {
+    MemoryViewContext::Get(self->m_engine)->registrations.configure(
+        nlohmann::json{{"capacity", capacity}});
 }
 
 std::string Client::getConfig() const {
-    return "{}";
+    auto config = nlohmann::json::object();
+    config["registration_cache"] =
+        MemoryViewContext::Get(self->m_engine)->registrations.getConfig();
+    return config.dump();
 }
 
 }
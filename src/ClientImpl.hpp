@@ -10,6 +10,9 @@
 #include <thallium/serialization/stl/unordered_set.hpp>
 #include <thallium/serialization/stl/unordered_map.hpp>
 #include <thallium/serialization/stl/string.hpp>
+#include <atomic>
+#include <chrono>
+#include <random>
 
 namespace poesie {
 
@@ -23,14 +26,36 @@ class ClientImpl {
     tl::remote_procedure m_execute;
     tl::remote_procedure m_load;
     tl::remote_procedure m_call;
+    tl::remote_procedure m_install;
+    tl::remote_procedure m_cancel;
+    tl::remote_procedure m_create_vm;
+    tl::remote_procedure m_destroy_vm;
+    // ids identifying requests to the provider when cancelling them,
+    // starting at a random value so that clients don't share them
+    std::atomic<uint64_t> m_next_request_id;
+    // retries of the requests rejected by overloaded providers
+    size_t                    m_max_retries     = 5;
+    std::chrono::milliseconds m_initial_backoff = std::chrono::milliseconds{10};
+    std::chrono::milliseconds m_max_backoff     = std::chrono::milliseconds{1000};
 
     ClientImpl(const tl::engine& engine)
     : m_engine(engine)
     , m_execute(m_engine.define("poesie_execute"))
     , m_load(m_engine.define("poesie_load"))
     , m_call(m_engine.define("poesie_call"))
+    , m_install(m_engine.define("poesie_install"))
+    , m_cancel(m_engine.define("poesie_cancel"))
+    , m_create_vm(m_engine.define("poesie_create_vm"))
+    , m_destroy_vm(m_engine.define("poesie_destroy_vm"))
+    , m_next_request_id(std::mt19937_64{std::random_device{}()}())
     {}
 
+    uint64_t newRequestId() {
+        uint64_t id;
+        do { id = m_next_request_id++; } while(id == 0); // 0 means "no id"
+        return id;
+    }
+
     ClientImpl(margo_instance_id mid)
     : ClientImpl(tl::engine(mid)) {}
 
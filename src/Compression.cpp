@@ -0,0 +1,175 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "config.h"
+#include "poesie/Exception.hpp"
+#include "Compression.hpp"
+#include "MemoryViewContext.hpp"
+
+#ifdef POESIE_HAS_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef POESIE_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#include <memory>
+
+namespace poesie {
+namespace compression {
+
+[[noreturn]] static void unavailable(std::string_view codec) {
+    throw Exception{"Compression codec \"" + std::string{codec} + "\" is not available"};
+}
+
+#ifdef POESIE_HAS_LZ4
+static LZ4F_preferences_t lz4Preferences(size_t size, int level) {
+    LZ4F_preferences_t prefs = LZ4F_INIT_PREFERENCES;
+    prefs.frameInfo.contentSize = size;
+    prefs.compressionLevel = level;
+    return prefs;
+}
+
+struct LZ4DecompressionContext {
+    LZ4F_dctx* dctx = nullptr;
+    LZ4DecompressionContext() {
+        if(LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION)))
+            throw Exception{"Could not create LZ4 decompression context"};
+    }
+    ~LZ4DecompressionContext() {
+        LZ4F_freeDecompressionContext(dctx);
+    }
+};
+#endif
+
+std::vector<std::string> codecs() {
+    std::vector<std::string> result;
+#ifdef POESIE_HAS_LZ4
+    result.push_back("lz4");
+#endif
+#ifdef POESIE_HAS_ZSTD
+    result.push_back("zstd");
+#endif
+    return result;
+}
+
+size_t compressBound(std::string_view codec, size_t size) {
+#ifdef POESIE_HAS_LZ4
+    if(codec == "lz4") {
+        auto prefs = lz4Preferences(size, 0);
+        return LZ4F_compressFrameBound(size, &prefs);
+    }
+#endif
+#ifdef POESIE_HAS_ZSTD
+    if(codec == "zstd") return ZSTD_compressBound(size);
+#endif
+    (void)size;
+    unavailable(codec);
+}
+
+size_t compress(std::string_view codec,
+                const char* src, size_t src_size,
+                char* dst, size_t dst_capacity,
+                int level) {
+#ifdef POESIE_HAS_LZ4
+    if(codec == "lz4") {
+        auto prefs = lz4Preferences(src_size, level);
+        auto ret = LZ4F_compressFrame(dst, dst_capacity, src, src_size, &prefs);
+        if(LZ4F_isError(ret))
+            throw Exception{std::string{"LZ4 compression failed: "} + LZ4F_getErrorName(ret)};
+        return ret;
+    }
+#endif
+#ifdef POESIE_HAS_ZSTD
+    if(codec == "zstd") {
+        auto ret = ZSTD_compress(dst, dst_capacity, src, src_size,
+                                 level ? level : ZSTD_CLEVEL_DEFAULT);
+        if(ZSTD_isError(ret))
+            throw Exception{std::string{"zstd compression failed: "} + ZSTD_getErrorName(ret)};
+        return ret;
+    }
+#endif
+    (void)src; (void)src_size; (void)dst; (void)dst_capacity; (void)level;
+    unavailable(codec);
+}
+
+size_t decompressedSize(std::string_view codec, const char* src, size_t src_size) {
+#ifdef POESIE_HAS_LZ4
+    if(codec == "lz4") {
+        LZ4DecompressionContext context;
+        LZ4F_frameInfo_t info;
+        size_t consumed = src_size;
+        auto ret = LZ4F_getFrameInfo(context.dctx, &info, src, &consumed);
+        if(LZ4F_isError(ret))
+            throw Exception{std::string{"Invalid LZ4 frame: "} + LZ4F_getErrorName(ret)};
+        if(info.contentSize == 0)
+            throw Exception{"LZ4 frame does not record the size of its content"};
+        return info.contentSize;
+    }
+#endif
+#ifdef POESIE_HAS_ZSTD
+    if(codec == "zstd") {
+        auto size = ZSTD_getFrameContentSize(src, src_size);
+        if(size == ZSTD_CONTENTSIZE_ERROR)
+            throw Exception{"Invalid zstd frame"};
+        if(size == ZSTD_CONTENTSIZE_UNKNOWN)
+            throw Exception{"zstd frame does not record the size of its content"};
+        return size;
+    }
+#endif
+    (void)src; (void)src_size;
+    unavailable(codec);
+}
+
+size_t decompress(std::string_view codec,
+                  const char* src, size_t src_size,
+                  char* dst, size_t dst_capacity) {
+#ifdef POESIE_HAS_LZ4
+    if(codec == "lz4") {
+        LZ4DecompressionContext context;
+        size_t read = 0, written = 0;
+        while(true) {
+            size_t src_chunk = src_size - read;
+            size_t dst_chunk = dst_capacity - written;
+            auto ret = LZ4F_decompress(context.dctx, dst + written, &dst_chunk,
+                                       src + read, &src_chunk, nullptr);
+            if(LZ4F_isError(ret))
+                throw Exception{std::string{"LZ4 decompression failed: "} + LZ4F_getErrorName(ret)};
+            read += src_chunk;
+            written += dst_chunk;
+            if(ret == 0) return written;
+            if(src_chunk == 0 && dst_chunk == 0)
+                throw Exception{read == src_size ? "Truncated LZ4 frame"
+                                                 : "Destination too small for decompressed data"};
+        }
+    }
+#endif
+#ifdef POESIE_HAS_ZSTD
+    if(codec == "zstd") {
+        auto ret = ZSTD_decompress(dst, dst_capacity, src, src_size);
+        if(ZSTD_isError(ret))
+            throw Exception{std::string{"zstd decompression failed: "} + ZSTD_getErrorName(ret)};
+        return ret;
+    }
+#endif
+    (void)src; (void)src_size; (void)dst; (void)dst_capacity;
+    unavailable(codec);
+}
+
+MemoryView decompress(const thallium::engine& engine,
+                      std::string_view codec,
+                      const char* src, size_t src_size) {
+    auto size = decompressedSize(codec, src, src_size);
+    auto max_size = MemoryViewContext::Get(engine)->max_decompressed_size.load();
+    if(size > max_size)
+        throw Exception{"Decompressed size (" + std::to_string(size)
+                        + " bytes) exceeds the maximum of " + std::to_string(max_size) + " bytes"};
+    auto view = MemoryView::Allocate(engine, size);
+    decompress(codec, src, src_size, view.rawData(), size);
+    return view;
+}
+
+}
+}
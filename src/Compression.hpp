@@ -0,0 +1,77 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __POESIE_COMPRESSION_H
+#define __POESIE_COMPRESSION_H
+
+#include <poesie/MemoryView.hpp>
+#include <thallium.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+namespace poesie {
+
+/**
+ * @brief Native compression and decompression of buffers, exposed to
+ * scripts as memory_view_compress, memory_view_decompress, and
+ * memory_view_compress_bound. The available codecs depend on the
+ * libraries found when poesie was built: "lz4" (LZ4 frame format) if
+ * liblz4 was found, "zstd" if libzstd was found. Both formats record
+ * the size of the uncompressed data. These functions throw a
+ * poesie::Exception if the codec is not available or on failure.
+ */
+namespace compression {
+
+/**
+ * @brief Names of the codecs available in this build.
+ */
+std::vector<std::string> codecs();
+
+/**
+ * @brief Maximum size of the compressed form of size bytes.
+ */
+size_t compressBound(std::string_view codec, size_t size);
+
+/**
+ * @brief Compress the source buffer into the destination buffer and
+ * return the size of the compressed data. A level of 0 selects the
+ * codec's default level.
+ */
+size_t compress(std::string_view codec,
+                const char* src, size_t src_size,
+                char* dst, size_t dst_capacity,
+                int level = 0);
+
+/**
+ * @brief Size of the uncompressed data recorded in the compressed buffer.
+ */
+size_t decompressedSize(std::string_view codec, const char* src, size_t src_size);
+
+/**
+ * @brief Decompress the source buffer into the destination buffer and
+ * return the size of the uncompressed data.
+ */
+size_t decompress(std::string_view codec,
+                  const char* src, size_t src_size,
+                  char* dst, size_t dst_capacity);
+
+/**
+ * @brief Decompress the source buffer into a new MemoryView (see
+ * MemoryView::Allocate) of the size recorded in the compressed buffer.
+ * Since this size comes from the (possibly untrusted) compressed data,
+ * it may not exceed the "max_decompressed_size" of the "compression"
+ * entry of the MemoryView configuration (see MemoryViewContext).
+ */
+MemoryView decompress(const thallium::engine& engine,
+                      std::string_view codec,
+                      const char* src, size_t src_size);
+
+}
+
+}
+
+#endif
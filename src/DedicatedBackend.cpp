@@ -0,0 +1,83 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "poesie/Exception.hpp"
+#include "DedicatedBackend.hpp"
+#include <optional>
+
+namespace poesie {
+
+using json = nlohmann::json;
+
+namespace {
+
+const Backend& checked(const std::shared_ptr<Backend>& backend) {
+    if(!backend)
+        throw Exception{"Invalid VM passed to DedicatedBackend"};
+    return *backend;
+}
+
+}
+
+DedicatedBackend::DedicatedBackend(std::shared_ptr<Backend> backend, int cpu)
+: Backend(checked(backend)) // copies the name of the backend type
+, m_backend(std::move(backend))
+, m_pool(tl::pool::create(tl::pool::access::mpmc))
+, m_xstream(tl::xstream::create(tl::scheduler::predef::basic_wait, *m_pool))
+, m_cpu(cpu) {
+    if(m_cpu >= 0) m_xstream->set_cpubind(m_cpu);
+}
+
+template<typename Operation>
+auto DedicatedBackend::run(Operation&& op) {
+    std::optional<decltype(op())> result;
+    auto ult = m_pool->make_thread([&]() { result.emplace(op()); });
+    ult->join();
+    return std::move(*result);
+}
+
+std::string DedicatedBackend::getConfig() const {
+    return m_backend->getConfig();
+}
+
+Result<json> DedicatedBackend::execute(std::string_view code,
+                                       const std::vector<json>& args,
+                                       const ExecutionContext& context) {
+    return run([&]() { return m_backend->execute(code, args, context); });
+}
+
+Result<json> DedicatedBackend::load(std::string_view filename,
+                                    const std::vector<json>& args,
+                                    const ExecutionContext& context) {
+    return run([&]() { return m_backend->load(filename, args, context); });
+}
+
+Result<json> DedicatedBackend::call(
+        std::string_view function,
+        std::string_view target,
+        const std::vector<json>& args,
+        const ExecutionContext& context) {
+    return run([&]() { return m_backend->call(function, target, args, context); });
+}
+
+Result<bool> DedicatedBackend::install(
+        std::string_view name,
+        ForeignFn function,
+        size_t nargs) {
+    return run([&]() { return m_backend->install(name, std::move(function), nargs); });
+}
+
+Result<bool> DedicatedBackend::installAsync(
+        std::string_view name,
+        AsyncForeignFn function,
+        size_t nargs) {
+    return run([&]() { return m_backend->installAsync(name, std::move(function), nargs); });
+}
+
+Result<bool> DedicatedBackend::destroy() {
+    return run([&]() { return m_backend->destroy(); });
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __POESIE_DEDICATED_BACKEND_H
+#define __POESIE_DEDICATED_BACKEND_H
+
+#include <poesie/Backend.hpp>
+#include <thallium.hpp>
+#include <memory>
+
+namespace poesie {
+
+namespace tl = thallium;
+
+/**
+ * @brief A DedicatedBackend runs all the scripts of a VM on an execution
+ * stream of its own, optionally bound to a CPU, instead of the execution
+ * streams of the provider's pool. Requests handled by the provider's pool
+ * hand their script over to the VM's execution stream and wait for it to
+ * complete, so that the interpreter's heap and bytecode stay in the caches
+ * of one core rather than moving between the cores running the handlers.
+ *
+ * It is used when the "vm" entry of the provider's configuration contains
+ * "dedicated_xstreams": true, in which case each replica of the VM gets
+ * its own execution stream, or "cpus": [...], which additionally binds
+ * the execution stream of replica i to cpus[i % cpus.size()].
+ */
+class DedicatedBackend : public Backend {
+
+    std::shared_ptr<Backend> m_backend;
+    tl::managed<tl::pool>    m_pool;
+    tl::managed<tl::xstream> m_xstream;
+    int                      m_cpu;
+
+    template<typename Operation>
+    auto run(Operation&& op);
+
+    public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param backend VM to run on the dedicated execution stream.
+     * @param cpu CPU to bind the execution stream to (-1 for none).
+     */
+    DedicatedBackend(std::shared_ptr<Backend> backend, int cpu = -1);
+
+    /**
+     * @brief CPU the execution stream is bound to (-1 if none).
+     */
+    int cpu() const {
+        return m_cpu;
+    }
+
+    std::string getConfig() const override;
+
+    using Backend::execute;
+    using Backend::load;
+    using Backend::call;
+
+    Result<nlohmann::json> execute(std::string_view code,
+                                   const std::vector<nlohmann::json>& args,
+                                   const ExecutionContext& context) override;
+
+    Result<nlohmann::json> load(std::string_view filename,
+                                const std::vector<nlohmann::json>& args,
+                                const ExecutionContext& context) override;
+
+    Result<nlohmann::json> call(
+            std::string_view function,
+            std::string_view target,
+            const std::vector<nlohmann::json>& args,
+            const ExecutionContext& context) override;
+
+    Result<bool> install(
+            std::string_view name,
+            ForeignFn function,
+            size_t nargs) override;
+
+    Result<bool> installAsync(
+            std::string_view name,
+            AsyncForeignFn function,
+            size_t nargs) override;
+
+    Result<bool> destroy() override;
+};
+
+}
+
+#endif
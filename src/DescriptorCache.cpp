@@ -0,0 +1,90 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "poesie/Exception.hpp"
+#include "DescriptorCache.hpp"
+
+namespace poesie {
+
+void DescriptorCache::configure(const nlohmann::json& config) {
+    if(!config.is_object())
+        throw Exception{"DescriptorCache configuration should be an object"};
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    if(config.contains("capacity")) {
+        if(!config["capacity"].is_number_unsigned())
+            throw Exception{"\"capacity\" should be a positive integer"};
+        m_capacity = config["capacity"].get<size_t>();
+    }
+    m_lru.clear();
+    m_entries.clear();
+    m_endpoints.clear();
+}
+
+nlohmann::json DescriptorCache::getConfig() const {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    return nlohmann::json{
+        {"capacity", m_capacity}
+    };
+}
+
+nlohmann::json DescriptorCache::getStatistics() const {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    auto total = m_hits + m_misses;
+    return nlohmann::json{
+        {"size", m_entries.size()},
+        {"hits", m_hits},
+        {"misses", m_misses},
+        {"hit_rate", total ? (double)m_hits/total : 0.0}
+    };
+}
+
+bool DescriptorCache::find(const std::string& key, Descriptor& descriptor) {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    if(m_capacity == 0) return false;
+    auto it = m_entries.find(key);
+    if(it == m_entries.end()) {
+        m_misses += 1;
+        return false;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    descriptor = it->second->second;
+    m_hits += 1;
+    return true;
+}
+
+void DescriptorCache::insert(const std::string& key, const Descriptor& descriptor) {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    if(m_capacity == 0 || m_entries.count(key)) return;
+    while(m_entries.size() >= m_capacity) {
+        m_entries.erase(m_lru.back().first);
+        m_lru.pop_back();
+    }
+    m_lru.emplace_front(key, descriptor);
+    m_entries[key] = m_lru.begin();
+}
+
+tl::endpoint DescriptorCache::lookup(const tl::engine& engine, const std::string& address) {
+    {
+        std::unique_lock<tl::mutex> lock{m_mtx};
+        auto it = m_endpoints.find(address);
+        if(it != m_endpoints.end()) return it->second;
+    }
+    // look the address up outside of the lock
+    auto endpoint = engine.lookup(address);
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    if(m_capacity == 0) return endpoint;
+    if(m_endpoints.size() >= m_capacity) m_endpoints.clear();
+    m_endpoints.emplace(address, endpoint);
+    return endpoint;
+}
+
+void DescriptorCache::clear() {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    m_lru.clear();
+    m_entries.clear();
+    m_endpoints.clear();
+}
+
+}
@@ -0,0 +1,99 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __POESIE_DESCRIPTOR_CACHE_H
+#define __POESIE_DESCRIPTOR_CACHE_H
+
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+#include <poesie/MemoryView.hpp>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <list>
+
+namespace poesie {
+
+namespace tl = thallium;
+
+/**
+ * @brief The DescriptorCache keeps the MemoryView descriptors that have
+ * recently been decoded, keyed by their serialized bytes, so that a client
+ * buffer passed in many consecutive calls is only decoded once. It also
+ * memoizes the lookup of the owners' addresses. At most "capacity"
+ * descriptors are kept (0 disables the cache), the least recently used
+ * ones being evicted first. A single DescriptorCache is shared by all the
+ * MemoryViews using a given engine (see MemoryViewContext).
+ */
+class DescriptorCache {
+
+    public:
+
+    struct Descriptor {
+        MemoryView::Intent  intent;
+        tl::endpoint        owner;
+        tl::bulk            bulk;
+        size_t              offset;
+        size_t              size;
+        std::vector<size_t> segments;
+    };
+
+    DescriptorCache() = default;
+
+    /**
+     * @brief Change the configuration of the cache.
+     * Cached descriptors are dropped.
+     */
+    void configure(const nlohmann::json& config);
+
+    /**
+     * @brief Get the configuration of the cache.
+     */
+    nlohmann::json getConfig() const;
+
+    /**
+     * @brief Get the usage statistics of the cache.
+     */
+    nlohmann::json getStatistics() const;
+
+    /**
+     * @brief Look for the descriptor with the provided serialized bytes,
+     * copying it into descriptor if found.
+     */
+    bool find(const std::string& key, Descriptor& descriptor);
+
+    /**
+     * @brief Add a decoded descriptor to the cache.
+     */
+    void insert(const std::string& key, const Descriptor& descriptor);
+
+    /**
+     * @brief Look up the address of an owner, using the memoized
+     * endpoint if this address has already been looked up.
+     */
+    tl::endpoint lookup(const tl::engine& engine, const std::string& address);
+
+    /**
+     * @brief Drop all the cached descriptors and endpoints.
+     */
+    void clear();
+
+    private:
+
+    using Entry = std::pair<std::string, Descriptor>;
+
+    mutable tl::mutex                                            m_mtx;
+    size_t                                                       m_capacity = 1024;
+    std::list<Entry>                                             m_lru; // most recent first
+    std::unordered_map<std::string, std::list<Entry>::iterator> m_entries;
+    std::unordered_map<std::string, tl::endpoint>                m_endpoints;
+    // statistics
+    size_t m_hits   = 0;
+    size_t m_misses = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,301 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "poesie/Exception.hpp"
+#include "Hashing.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace poesie {
+namespace hashing {
+
+static std::string toHex(const uint8_t* bytes, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    std::string result(2*size, '0');
+    for(size_t i = 0; i < size; ++i) {
+        result[2*i]   = digits[bytes[i] >> 4];
+        result[2*i+1] = digits[bytes[i] & 0xf];
+    }
+    return result;
+}
+
+static std::string toHex(uint64_t value, size_t size) {
+    uint8_t bytes[8];
+    for(size_t i = 0; i < size; ++i)
+        bytes[i] = static_cast<uint8_t>(value >> (8*(size - 1 - i)));
+    return toHex(bytes, size);
+}
+
+template<typename T>
+static inline T load(const char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// XXH64, assuming a little-endian host
+class XXH64Hasher : public Hasher {
+
+    static constexpr uint64_t P1 = 11400714785074694791ULL;
+    static constexpr uint64_t P2 = 14029467366897019727ULL;
+    static constexpr uint64_t P3 = 1609587929392839161ULL;
+    static constexpr uint64_t P4 = 9650029242287828579ULL;
+    static constexpr uint64_t P5 = 2870177450012600261ULL;
+
+    uint64_t m_acc[4]  = {P1 + P2, P2, 0, 0 - P1};
+    uint64_t m_total   = 0;
+    char     m_buffer[32];
+    size_t   m_buffered = 0;
+
+    static inline uint64_t round(uint64_t acc, uint64_t input) {
+        acc += input*P2;
+        acc  = rotl64(acc, 31);
+        return acc*P1;
+    }
+
+    static inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+        acc ^= round(0, value);
+        return acc*P1 + P4;
+    }
+
+    void consumeStripes(const char* data, size_t count) {
+        for(size_t i = 0; i < count; ++i, data += 32) {
+            m_acc[0] = round(m_acc[0], load<uint64_t>(data));
+            m_acc[1] = round(m_acc[1], load<uint64_t>(data + 8));
+            m_acc[2] = round(m_acc[2], load<uint64_t>(data + 16));
+            m_acc[3] = round(m_acc[3], load<uint64_t>(data + 24));
+        }
+    }
+
+    public:
+
+    void update(const char* data, size_t size) override {
+        m_total += size;
+        if(m_buffered) {
+            auto n = std::min(size, 32 - m_buffered);
+            std::memcpy(m_buffer + m_buffered, data, n);
+            m_buffered += n;
+            data += n;
+            size -= n;
+            if(m_buffered < 32) return;
+            consumeStripes(m_buffer, 1);
+            m_buffered = 0;
+        }
+        consumeStripes(data, size/32);
+        data += size - size%32;
+        std::memcpy(m_buffer, data, size%32);
+        m_buffered = size%32;
+    }
+
+    std::string hexdigest() const override {
+        uint64_t h;
+        if(m_total >= 32) {
+            h = rotl64(m_acc[0], 1) + rotl64(m_acc[1], 7)
+              + rotl64(m_acc[2], 12) + rotl64(m_acc[3], 18);
+            for(auto acc : m_acc) h = mergeRound(h, acc);
+        } else {
+            h = m_acc[2] + P5;
+        }
+        h += m_total;
+        const char* p = m_buffer;
+        size_t remaining = m_buffered;
+        for(; remaining >= 8; remaining -= 8, p += 8) {
+            h ^= round(0, load<uint64_t>(p));
+            h  = rotl64(h, 27)*P1 + P4;
+        }
+        if(remaining >= 4) {
+            h ^= static_cast<uint64_t>(load<uint32_t>(p))*P1;
+            h  = rotl64(h, 23)*P2 + P3;
+            p += 4;
+            remaining -= 4;
+        }
+        for(; remaining; --remaining, ++p) {
+            h ^= static_cast<uint8_t>(*p)*P5;
+            h  = rotl64(h, 11)*P1;
+        }
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return toHex(h, 8);
+    }
+};
+
+// CRC-32C, using the SSE4.2 instruction when the compiler targets it
+// and slicing-by-8 tables otherwise
+class CRC32CHasher : public Hasher {
+
+    uint32_t m_crc = 0xffffffff;
+
+    using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+    static const Tables& tables() {
+        static const Tables t = []() {
+            Tables t{};
+            for(uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc = i;
+                for(int k = 0; k < 8; ++k)
+                    crc = (crc >> 1) ^ (0x82f63b78 & (0 - (crc & 1)));
+                t[0][i] = crc;
+            }
+            for(uint32_t i = 0; i < 256; ++i)
+                for(size_t k = 1; k < 8; ++k)
+                    t[k][i] = (t[k-1][i] >> 8) ^ t[0][t[k-1][i] & 0xff];
+            return t;
+        }();
+        return t;
+    }
+
+    public:
+
+    void update(const char* data, size_t size) override {
+        uint32_t crc = m_crc;
+#ifdef __SSE4_2__
+        uint64_t crc64 = crc;
+        for(; size >= 8; size -= 8, data += 8)
+            crc64 = _mm_crc32_u64(crc64, load<uint64_t>(data));
+        crc = static_cast<uint32_t>(crc64);
+        for(; size; --size, ++data)
+            crc = _mm_crc32_u8(crc, static_cast<uint8_t>(*data));
+#else
+        auto& t = tables();
+        for(; size >= 8; size -= 8, data += 8) {
+            auto lo = load<uint32_t>(data) ^ crc;
+            auto hi = load<uint32_t>(data + 4);
+            crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff]
+                ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24]
+                ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff]
+                ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        }
+        for(; size; --size, ++data)
+            crc = (crc >> 8) ^ t[0][(crc ^ static_cast<uint8_t>(*data)) & 0xff];
+#endif
+        m_crc = crc;
+    }
+
+    std::string hexdigest() const override {
+        return toHex(~m_crc, 4);
+    }
+};
+
+// SHA-256 (FIPS 180-4)
+class SHA256Hasher : public Hasher {
+
+    uint32_t m_state[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    uint64_t m_total = 0;
+    uint8_t  m_buffer[64];
+    size_t   m_buffered = 0;
+
+    static inline uint32_t rotr(uint32_t x, int r) {
+        return (x >> r) | (x << (32 - r));
+    }
+
+    static void compress(uint32_t state[8], const uint8_t* block) {
+        static const uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+        uint32_t w[64];
+        for(int i = 0; i < 16; ++i)
+            w[i] = (uint32_t(block[4*i]) << 24) | (uint32_t(block[4*i+1]) << 16)
+                 | (uint32_t(block[4*i+2]) << 8) | uint32_t(block[4*i+3]);
+        for(int i = 16; i < 64; ++i) {
+            auto s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15] >> 3);
+            auto s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2] >> 10);
+            w[i] = w[i-16] + s0 + w[i-7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for(int i = 0; i < 64; ++i) {
+            auto s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            auto ch = (e & f) ^ (~e & g);
+            auto t1 = h + s1 + ch + K[i] + w[i];
+            auto s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            auto maj = (a & b) ^ (a & c) ^ (b & c);
+            auto t2 = s0 + maj;
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+
+    public:
+
+    void update(const char* data, size_t size) override {
+        auto bytes = reinterpret_cast<const uint8_t*>(data);
+        m_total += size;
+        if(m_buffered) {
+            auto n = std::min(size, 64 - m_buffered);
+            std::memcpy(m_buffer + m_buffered, bytes, n);
+            m_buffered += n;
+            bytes += n;
+            size -= n;
+            if(m_buffered < 64) return;
+            compress(m_state, m_buffer);
+            m_buffered = 0;
+        }
+        for(; size >= 64; size -= 64, bytes += 64)
+            compress(m_state, bytes);
+        std::memcpy(m_buffer, bytes, size);
+        m_buffered = size;
+    }
+
+    std::string hexdigest() const override {
+        uint32_t state[8];
+        std::memcpy(state, m_state, sizeof(state));
+        uint8_t block[128] = {};
+        std::memcpy(block, m_buffer, m_buffered);
+        block[m_buffered] = 0x80;
+        size_t length = m_buffered < 56 ? 64 : 128;
+        uint64_t bits = m_total*8;
+        for(int i = 0; i < 8; ++i)
+            block[length - 1 - i] = static_cast<uint8_t>(bits >> (8*i));
+        for(size_t off = 0; off < length; off += 64)
+            compress(state, block + off);
+        uint8_t digest[32];
+        for(int i = 0; i < 8; ++i)
+            for(int k = 0; k < 4; ++k)
+                digest[4*i+k] = static_cast<uint8_t>(state[i] >> (24 - 8*k));
+        return toHex(digest, sizeof(digest));
+    }
+};
+
+std::unique_ptr<Hasher> Hasher::Create(std::string_view algorithm) {
+    if(algorithm == "xxh64")  return std::make_unique<XXH64Hasher>();
+    if(algorithm == "crc32c") return std::make_unique<CRC32CHasher>();
+    if(algorithm == "sha256") return std::make_unique<SHA256Hasher>();
+    throw Exception{"Invalid hash algorithm \"" + std::string{algorithm} + "\""};
+}
+
+std::string hash(std::string_view algorithm, const char* data, size_t size) {
+    auto hasher = Hasher::Create(algorithm);
+    hasher->update(data, size);
+    return hasher->hexdigest();
+}
+
+}
+}
@@ -0,0 +1,63 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __POESIE_HASHING_H
+#define __POESIE_HASHING_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace poesie {
+
+/**
+ * @brief Native hash functions, exposed to scripts as memory_view_hash and
+ * memory_view_hasher, so that scripts can hash the content of a MemoryView
+ * in place. The supported algorithms are "xxh64" (XXH64 with seed 0),
+ * "crc32c" (CRC-32 with the Castagnoli polynomial), and "sha256". Digests
+ * are returned as lowercase hexadecimal strings, in the canonical
+ * (big-endian) byte order of each algorithm.
+ */
+namespace hashing {
+
+/**
+ * @brief A Hasher computes a hash incrementally, e.g. over the chunks
+ * of a streamed MemoryView as they are received.
+ */
+class Hasher {
+
+    public:
+
+    virtual ~Hasher() = default;
+
+    /**
+     * @brief Add bytes to the hashed content.
+     */
+    virtual void update(const char* data, size_t size) = 0;
+
+    /**
+     * @brief Get the hash of the content added so far. More content
+     * may be added after this call.
+     */
+    virtual std::string hexdigest() const = 0;
+
+    /**
+     * @brief Create a Hasher for the provided algorithm.
+     * Throws a poesie::Exception if the algorithm is not supported.
+     */
+    static std::unique_ptr<Hasher> Create(std::string_view algorithm);
+};
+
+/**
+ * @brief Hash a buffer in one call.
+ */
+std::string hash(std::string_view algorithm, const char* data, size_t size);
+
+}
+
+}
+
+#endif
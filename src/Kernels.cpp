@@ -0,0 +1,179 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "poesie/Exception.hpp"
+#include "Kernels.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace poesie {
+namespace kernels {
+
+template<typename T>
+static inline T load(const char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+// reduction with several independent accumulators, so that the loop
+// does not serialize on a single one and can be vectorized
+template<typename T, typename Acc, typename Op>
+static Acc reduceElements(const char* data, size_t n, Acc init, Op op) {
+    constexpr size_t lanes = 8;
+    Acc acc[lanes];
+    std::fill(acc, acc + lanes, init);
+    size_t i = 0;
+    for(; i + lanes <= n; i += lanes)
+        for(size_t k = 0; k < lanes; ++k)
+            acc[k] = op(acc[k], static_cast<Acc>(load<T>(data + (i + k)*sizeof(T))));
+    for(; i < n; ++i)
+        acc[0] = op(acc[0], static_cast<Acc>(load<T>(data + i*sizeof(T))));
+    for(size_t k = 1; k < lanes; ++k)
+        acc[0] = op(acc[0], acc[k]);
+    return acc[0];
+}
+
+// signed sums wrap on overflow and count the wraps, so that an overflow
+// compensated by later elements does not fail: the exact sum is
+// carry*2^64 + sum, which only fits in 64 bits if carry is 0
+template<typename T>
+static int64_t sumSigned(const char* data, size_t n) {
+    int64_t sum = 0, carry = 0;
+    for(size_t i = 0; i < n; ++i) {
+        int64_t x = load<T>(data + i*sizeof(T));
+        if(__builtin_add_overflow(sum, x, &sum))
+            carry += x < 0 ? -1 : 1;
+    }
+    if(carry)
+        throw Exception{"Sum of the elements does not fit in a 64-bit integer"};
+    return sum;
+}
+
+// unsigned sums never decrease, so the first overflow is final
+template<typename T>
+static uint64_t sumUnsigned(const char* data, size_t n) {
+    uint64_t sum = 0;
+    for(size_t i = 0; i < n; ++i) {
+        if(__builtin_add_overflow(sum, static_cast<uint64_t>(load<T>(data + i*sizeof(T))), &sum))
+            throw Exception{"Sum of the elements does not fit in a 64-bit integer"};
+    }
+    return sum;
+}
+
+// integer sums are accumulated in 64-bit integers when the elements are
+// narrower and too few for the sum to overflow, and with overflow checks
+// otherwise
+template<typename T>
+static nlohmann::json sumIntegers(const char* data, size_t n) {
+    using Result = std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>;
+    if(sizeof(T) < sizeof(Result) && n <= (size_t{1} << 32))
+        return reduceElements<T, Result>(data, n, Result{0},
+            [](Result a, Result b) { return a + b; });
+    if constexpr(std::is_signed_v<T>)
+        return sumSigned<T>(data, n);
+    else
+        return sumUnsigned<T>(data, n);
+}
+
+template<typename T>
+static nlohmann::json reduceAs(const char* data, size_t size, std::string_view op) {
+    if(size % sizeof(T))
+        throw Exception{"Size of the buffer is not a multiple of the size of the elements"};
+    size_t n = size/sizeof(T);
+    // integers are returned as int64_t or uint64_t so that
+    // nlohmann::json stores them as integers rather than as doubles
+    using ResultType = std::conditional_t<std::is_floating_point_v<T>, double,
+                       std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>>;
+    if(op == "sum") {
+        if constexpr(std::is_floating_point_v<T>)
+            return reduceElements<T, double>(data, n, 0.0,
+                [](double a, double b) { return a + b; });
+        else
+            return sumIntegers<T>(data, n);
+    }
+    if(op == "min" || op == "max") {
+        if(n == 0)
+            throw Exception{"Cannot compute the " + std::string{op} + " of an empty buffer"};
+        auto first = load<T>(data);
+        if(op == "min")
+            return static_cast<ResultType>(reduceElements<T, T>(data, n, first,
+                [](T a, T b) { return b < a ? b : a; }));
+        return static_cast<ResultType>(reduceElements<T, T>(data, n, first,
+            [](T a, T b) { return a < b ? b : a; }));
+    }
+    throw Exception{"Invalid reduction operation \"" + std::string{op} + "\""};
+}
+
+nlohmann::json reduce(const char* data, size_t size, std::string_view type, std::string_view op) {
+    if(type == "i8")  return reduceAs<int8_t>(data, size, op);
+    if(type == "u8")  return reduceAs<uint8_t>(data, size, op);
+    if(type == "i16") return reduceAs<int16_t>(data, size, op);
+    if(type == "u16") return reduceAs<uint16_t>(data, size, op);
+    if(type == "i32") return reduceAs<int32_t>(data, size, op);
+    if(type == "u32") return reduceAs<uint32_t>(data, size, op);
+    if(type == "i64") return reduceAs<int64_t>(data, size, op);
+    if(type == "u64") return reduceAs<uint64_t>(data, size, op);
+    if(type == "f32") return reduceAs<float>(data, size, op);
+    if(type == "f64") return reduceAs<double>(data, size, op);
+    throw Exception{"Invalid element type \"" + std::string{type} + "\""};
+}
+
+size_t count(const char* data, size_t size, uint8_t value) {
+    auto bytes = reinterpret_cast<const uint8_t*>(data);
+    size_t result = 0;
+    for(size_t i = 0; i < size; ++i)
+        result += bytes[i] == value;
+    return result;
+}
+
+size_t find(const char* data, size_t size, std::string_view pattern, size_t start) {
+    if(start > size) return std::string_view::npos;
+    return std::string_view{data, size}.find(pattern, start);
+}
+
+std::array<size_t, 256> histogram(const char* data, size_t size) {
+    // four partial histograms avoid stalls on consecutive identical bytes
+    auto bytes = reinterpret_cast<const uint8_t*>(data);
+    std::array<std::array<size_t, 256>, 4> partial{};
+    size_t i = 0;
+    for(; i + 4 <= size; i += 4) {
+        partial[0][bytes[i]]   += 1;
+        partial[1][bytes[i+1]] += 1;
+        partial[2][bytes[i+2]] += 1;
+        partial[3][bytes[i+3]] += 1;
+    }
+    for(; i < size; ++i)
+        partial[0][bytes[i]] += 1;
+    for(size_t b = 0; b < 256; ++b)
+        partial[0][b] += partial[1][b] + partial[2][b] + partial[3][b];
+    return partial[0];
+}
+
+template<typename T, typename Swap>
+static void byteswapAs(char* data, size_t size, Swap swap) {
+    for(size_t i = 0; i < size; i += sizeof(T)) {
+        T value = swap(load<T>(data + i));
+        std::memcpy(data + i, &value, sizeof(T));
+    }
+}
+
+void byteswap(char* data, size_t size, size_t width) {
+    if(width != 2 && width != 4 && width != 8)
+        throw Exception{"Invalid width for byteswap (should be 2, 4, or 8)"};
+    if(size % width)
+        throw Exception{"Size of the buffer is not a multiple of the width"};
+    switch(width) {
+        case 2: byteswapAs<uint16_t>(data, size, [](uint16_t v) { return __builtin_bswap16(v); }); break;
+        case 4: byteswapAs<uint32_t>(data, size, [](uint32_t v) { return __builtin_bswap32(v); }); break;
+        case 8: byteswapAs<uint64_t>(data, size, [](uint64_t v) { return __builtin_bswap64(v); }); break;
+    }
+}
+
+}
+}
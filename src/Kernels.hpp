@@ -0,0 +1,71 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __POESIE_KERNELS_H
+#define __POESIE_KERNELS_H
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+namespace poesie {
+
+/**
+ * @brief Native implementations of the byte-level operations that the
+ * backends expose to scripts as memory_view_reduce, memory_view_count,
+ * memory_view_find, memory_view_histogram, and memory_view_byteswap,
+ * so that scripts don't have to loop over the bytes of a MemoryView in
+ * the interpreted language. The loops are written so that the compiler
+ * can vectorize them. Elements are read in the host's byte order and
+ * need not be aligned. These functions throw a poesie::Exception on
+ * invalid arguments.
+ */
+namespace kernels {
+
+/**
+ * @brief Reduce the elements of the buffer. The type of the elements
+ * is one of "i8", "u8", "i16", "u16", "i32", "u32", "i64", "u64", "f32",
+ * "f64", and the operation is one of "sum", "min", "max". The size of the
+ * buffer must be a multiple of the size of the elements, and min and max
+ * require at least one element.
+ *
+ * The result is a JSON number: a signed (resp. unsigned) integer for
+ * signed (resp. unsigned) integer types, so that it is exact, and a
+ * floating-point number for "f32" and "f64". Integer sums that don't fit
+ * in 64 bits throw a poesie::Exception instead of wrapping around.
+ */
+nlohmann::json reduce(const char* data, size_t size, std::string_view type, std::string_view op);
+
+/**
+ * @brief Count the occurrences of a byte value in the buffer.
+ */
+size_t count(const char* data, size_t size, uint8_t value);
+
+/**
+ * @brief Find the first occurrence of a pattern in the buffer, starting
+ * at offset start. Returns its offset, or std::string_view::npos.
+ */
+size_t find(const char* data, size_t size, std::string_view pattern, size_t start = 0);
+
+/**
+ * @brief Count the occurrences of each byte value in the buffer.
+ */
+std::array<size_t, 256> histogram(const char* data, size_t size);
+
+/**
+ * @brief Reverse in place the byte order of the elements of the buffer,
+ * of width 2, 4, or 8 bytes. The size of the buffer must be a multiple
+ * of the width.
+ */
+void byteswap(char* data, size_t size, size_t width);
+
+}
+
+}
+
+#endif
@@ -13,6 +13,15 @@
 
 #include <thallium/serialization/stl/string.hpp>
 
+#include <map>
+#include <mutex>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 namespace tl = thallium;
 
 namespace poesie {
@@ -20,10 +29,41 @@ namespace poesie {
 MemoryView::MemoryView() = default;
 
 MemoryView::MemoryView(tl::engine engine, const char* data, size_t size, Intent intent) {
-    auto bulk = engine.expose({{const_cast<char*>(data), size}}, tl::bulk_mode::read_write);
+    // buffers passed repeatedly are only registered once
+    auto context = MemoryViewContext::Get(engine);
+    RegistrationCache::Registration registration;
+    registration.data = const_cast<char*>(data);
+    registration.size = size;
+    registration.mode = tl::bulk_mode::read_write;
+    bool registered = context->registrations.acquire(engine, registration);
+    auto bulk = registered ? registration.bulk
+              : engine.expose({{registration.data, size}}, registration.mode);
     auto owner = engine.self();
     auto view = MemoryView{engine, bulk, owner, intent, 0, size};
     self = std::move(view).self;
+    if(registered) {
+        self->m_context      = std::move(context);
+        self->m_registered   = true;
+        self->m_registration = std::move(registration);
+    }
+}
+
+MemoryView::MemoryView(tl::engine engine,
+                       const std::vector<std::pair<const char*, size_t>>& segments,
+                       Intent intent) {
+    std::vector<std::pair<void*, size_t>> ptrs;
+    std::vector<size_t> sizes;
+    ptrs.reserve(segments.size());
+    sizes.reserve(segments.size());
+    for(auto& segment : segments) {
+        ptrs.emplace_back(const_cast<char*>(segment.first), segment.second);
+        sizes.push_back(segment.second);
+    }
+    auto bulk = engine.expose(ptrs, tl::bulk_mode::read_write);
+    auto owner = engine.self();
+    auto view = MemoryView{engine, bulk, owner, intent};
+    self = std::move(view).self;
+    self->m_segments = std::move(sizes);
 }
 
 MemoryView::MemoryView(tl::engine engine,
@@ -32,10 +72,10 @@ MemoryView::MemoryView(tl::engine engine,
                        Intent intent,
                        std::optional<size_t> offset_opt,
                        std::optional<size_t> size_opt) {
-    if(offset_opt.value_or(0) + size_opt.value_or(bulk.size()) > bulk.size())
-        throw Exception{"Invalid offset and/or size when exposing bulk handle as MemoryView"};
     size_t offset = offset_opt.value_or(0);
     size_t size  = size_opt.value_or(bulk.size());
+    if(offset > bulk.size() || size > bulk.size() - offset)
+        throw Exception{"Invalid offset and/or size when exposing bulk handle as MemoryView"};
     self = std::make_shared<MemoryViewImpl>();
     self->m_intent        = intent;
     self->m_engine        = engine;
@@ -45,6 +85,27 @@ MemoryView::MemoryView(tl::engine engine,
     self->m_remote_size   = size;
 }
 
+// MemoryView descriptors encode integers as LEB128 varints
+static void putVarint(nlohmann::json::binary_t& binary, uint64_t value) {
+    while(value >= 0x80) {
+        binary.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    binary.push_back(static_cast<uint8_t>(value));
+}
+
+static uint64_t getVarint(const nlohmann::json::binary_t& binary, size_t& off) {
+    uint64_t value = 0;
+    for(unsigned shift = 0; shift < 64; shift += 7) {
+        if(off >= binary.size())
+            throw Exception{"Truncated MemoryView representation"};
+        uint8_t byte = binary[off++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if(!(byte & 0x80)) return value;
+    }
+    throw Exception{"Invalid varint in MemoryView representation"};
+}
+
 MemoryView::MemoryView(tl::engine engine,
                        const nlohmann::json& j) {
     if(!IsMemoryView(j)) {
@@ -58,39 +119,57 @@ MemoryView::MemoryView(tl::engine engine,
         for(auto& b : j["bytes"])
             binary.push_back(b.get<std::uint8_t>());
     }
-    size_t owner_size;
-    std::string owner;
-    hg_bulk_t bulk = HG_BULK_NULL;
-    size_t bulk_size;
-    size_t remote_offset, remote_size;
-    size_t off = 0;
-    Intent intent;
-    std::memcpy(&intent, &binary[off], sizeof(intent));
-    off += sizeof(intent);
-    std::memcpy(&owner_size, &binary[off], sizeof(owner_size));
-    off += sizeof(owner_size);
-    owner.resize(owner_size);
-    std::memcpy(const_cast<char*>(owner.data()), &binary[off], owner_size);
-    off += owner_size;
-    std::memcpy(&bulk_size, &binary[off], sizeof(bulk_size));
-    off += sizeof(bulk_size);
-    margo_bulk_deserialize(
-            engine.get_margo_instance(),
-            &bulk, &binary[off], bulk_size);
-    off += bulk_size;
-    std::memcpy(&remote_offset, &binary[off], sizeof(remote_offset));
-    off += sizeof(remote_offset);
-    std::memcpy(&remote_size, &binary[off], sizeof(remote_size));
-    auto remote_ep = engine.lookup(owner);
+    // decoded descriptors are cached by the engine's context
+    auto context = MemoryViewContext::Get(engine);
+    std::string key{binary.begin(), binary.end()};
+    DescriptorCache::Descriptor descriptor;
+    if(!context->descriptors.find(key, descriptor)) {
+        size_t off = 0;
+        auto intent = getVarint(binary, off);
+        if(intent != static_cast<uint64_t>(Intent::IN)
+        && intent != static_cast<uint64_t>(Intent::OUT)
+        && intent != static_cast<uint64_t>(Intent::INOUT))
+            throw Exception{"Invalid intent in MemoryView representation"};
+        descriptor.intent = static_cast<Intent>(intent);
+        auto owner_size = getVarint(binary, off);
+        if(owner_size > binary.size() - off)
+            throw Exception{"Invalid owner in MemoryView representation"};
+        std::string owner{(const char*)&binary[off], owner_size};
+        off += owner_size;
+        auto bulk_size = getVarint(binary, off);
+        if(bulk_size > binary.size() - off)
+            throw Exception{"Invalid bulk handle in MemoryView representation"};
+        hg_bulk_t bulk = HG_BULK_NULL;
+        auto hret = margo_bulk_deserialize(
+                engine.get_margo_instance(),
+                &bulk, &binary[off], bulk_size);
+        if(hret != HG_SUCCESS)
+            throw Exception{"Could not deserialize bulk handle in MemoryView representation"};
+        off += bulk_size;
+        descriptor.offset = getVarint(binary, off);
+        descriptor.size   = getVarint(binary, off);
+        if(off < binary.size()) {
+            auto num_segments = getVarint(binary, off);
+            if(num_segments > binary.size() - off)
+                throw Exception{"Invalid segments in MemoryView representation"};
+            descriptor.segments.resize(num_segments);
+            for(auto& segment : descriptor.segments)
+                segment = getVarint(binary, off);
+        }
+        descriptor.owner = context->descriptors.lookup(engine, owner);
+        descriptor.bulk  = engine.wrap(bulk, descriptor.owner == engine.self());
+        context->descriptors.insert(key, descriptor);
+    }
     auto view = MemoryView{
         engine,
-            engine.wrap(bulk, remote_ep == engine.self()),
-            remote_ep,
-            intent,
-            remote_offset,
-            remote_size
+            descriptor.bulk,
+            descriptor.owner,
+            descriptor.intent,
+            descriptor.offset,
+            descriptor.size
     };
     self = std::move(view).self;
+    self->m_segments = std::move(descriptor.segments);
 }
 
 MemoryView::MemoryView(MemoryView&& other) = default;
@@ -107,18 +186,181 @@ MemoryView::operator bool() const {
     return static_cast<bool>(self);
 }
 
+bool MemoryView::operator==(const MemoryView& other) const {
+    return self == other.self;
+}
+
 MemoryView::Intent MemoryView::intent() const {
     return self ? self->m_intent : MemoryView::Intent::IN;
 }
 
 char* MemoryView::data() const {
+    return access(0, size(), true);
+}
+
+size_t MemoryView::size() const {
+    return self ? self->m_remote_size : 0;
+}
+
+char* MemoryView::rawData() const {
     if(!self) return nullptr;
     self->prepareLocalData();
     return self->m_local_data;
 }
 
-size_t MemoryView::size() const {
-    return self ? self->m_remote_size : 0;
+char* MemoryView::access(size_t offset, size_t size, bool write) const {
+    if(!self) return nullptr;
+    if(offset > self->m_remote_size || size > self->m_remote_size - offset)
+        throw Exception{"Invalid range in MemoryView::access"};
+    self->prepareLocalData();
+    self->access(offset, size, write);
+    return self->m_local_data + offset;
+}
+
+bool MemoryView::isLazy() const {
+    if(!self) return false;
+    self->prepareLocalData();
+    auto& root = self->m_parent ? self->m_parent : self;
+    return root->m_page_size != 0;
+}
+
+bool MemoryView::tracksWrites() const {
+    if(!self) return false;
+    self->prepareLocalData();
+    return self->tracksWrites();
+}
+
+size_t MemoryView::chunkSize() const {
+    if(!self) return 0;
+    self->prepareLocalData();
+    return self->chunkSize();
+}
+
+size_t MemoryView::numChunks() const {
+    if(!self) return 0;
+    self->prepareLocalData();
+    return self->numChunks();
+}
+
+std::vector<std::pair<size_t, size_t>> MemoryView::segments() const {
+    if(!self) return {};
+    return self->segments();
+}
+
+char* MemoryView::waitChunk(size_t index) const {
+    if(!self) return nullptr;
+    self->prepareLocalData();
+    if(index >= self->numChunks())
+        throw Exception{"Invalid chunk index in MemoryView::waitChunk"};
+    auto chunk_size = self->chunkSize();
+    auto offset = index*chunk_size;
+    return access(offset, std::min(chunk_size, self->m_remote_size - offset));
+}
+
+MemoryView MemoryView::slice(size_t offset, size_t size) const {
+    if(!self)
+        throw Exception{"Cannot slice an invalid MemoryView"};
+    if(offset > self->m_remote_size || size > self->m_remote_size - offset)
+        throw Exception{"Invalid offset and/or size in MemoryView::slice"};
+    MemoryView view;
+    view.self = std::make_shared<MemoryViewImpl>();
+    view.self->m_intent        = self->m_intent;
+    view.self->m_engine        = self->m_engine;
+    view.self->m_remote_bulk   = self->m_remote_bulk;
+    view.self->m_remote_ep     = self->m_remote_ep;
+    view.self->m_remote_offset = self->m_remote_offset + offset;
+    view.self->m_remote_size   = size;
+    view.self->m_segments      = self->m_segments;
+    // slices of slices refer to the root view
+    view.self->m_parent        = self->m_parent ? self->m_parent : self;
+    view.self->m_parent_offset = self->m_parent_offset + offset;
+    return view;
+}
+
+void MemoryView::writeBack() const {
+    if(!self) return;
+    self->startWriteBack();
+}
+
+static std::mutex s_deferred_mtx;
+static std::map<const char*, std::weak_ptr<MemoryViewImpl>> s_deferred;
+
+void MemoryViewImpl::RegisterDeferred(const char* data, const std::shared_ptr<MemoryViewImpl>& view) {
+    std::lock_guard<std::mutex> lock{s_deferred_mtx};
+    s_deferred[data] = view;
+}
+
+void MemoryViewImpl::UnregisterDeferred(const char* data) {
+    std::lock_guard<std::mutex> lock{s_deferred_mtx};
+    s_deferred.erase(data);
+}
+
+std::shared_ptr<MemoryViewImpl> MemoryViewImpl::FindDeferred(const void* ptr) {
+    auto p = static_cast<const char*>(ptr);
+    std::lock_guard<std::mutex> lock{s_deferred_mtx};
+    auto it = s_deferred.upper_bound(p);
+    if(it == s_deferred.begin()) return nullptr;
+    --it;
+    auto view = it->second.lock();
+    if(!view || p >= it->first + view->m_remote_size) return nullptr;
+    return view;
+}
+
+MemoryView MemoryView::FromFile(tl::engine engine,
+                                const std::string& path,
+                                size_t offset,
+                                std::optional<size_t> size_opt,
+                                Intent intent) {
+    bool shared = intent != Intent::IN;
+    auto resolved = MemoryViewContext::Get(engine)->checkFile(path, shared);
+    int fd = ::open(resolved.c_str(), (shared ? O_RDWR : O_RDONLY) | O_NOFOLLOW);
+    if(fd < 0)
+        throw Exception{"Could not open " + path + ": " + std::strerror(errno)};
+    struct stat st;
+    if(::fstat(fd, &st) != 0) {
+        auto err = errno;
+        ::close(fd);
+        throw Exception{"Could not stat " + path + ": " + std::strerror(err)};
+    }
+    size_t file_size = st.st_size;
+    size_t size = size_opt.value_or(offset < file_size ? file_size - offset : 0);
+    if(offset > file_size || size > file_size - offset || size == 0) {
+        ::close(fd);
+        throw Exception{"Invalid offset and/or size when mapping " + path};
+    }
+    // the offset of the mapping must be a multiple of the page size;
+    // IN views are mapped privately so that scripts can't modify the file
+    size_t delta  = offset % ::sysconf(_SC_PAGESIZE);
+    size_t length = size + delta;
+    void* addr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                        shared ? MAP_SHARED : MAP_PRIVATE, fd, offset - delta);
+    auto err = errno;
+    ::close(fd);
+    if(addr == MAP_FAILED)
+        throw Exception{"Could not map " + path + ": " + std::strerror(err)};
+    std::shared_ptr<void> mapping{addr, [length](void* p) { ::munmap(p, length); }};
+    auto data = static_cast<char*>(addr) + delta;
+    auto bulk = engine.expose({{data, size}},
+        shared ? tl::bulk_mode::read_write : tl::bulk_mode::read_only);
+    auto view = MemoryView{engine, bulk, engine.self(), intent, 0, size};
+    view.self->m_storage = std::move(mapping);
+    return view;
+}
+
+MemoryView MemoryView::Allocate(tl::engine engine, size_t size, Intent intent) {
+    if(size == 0)
+        throw Exception{"Cannot allocate an empty MemoryView"};
+    std::shared_ptr<char> storage{new char[size], std::default_delete<char[]>{}};
+    auto bulk = engine.expose({{storage.get(), size}}, tl::bulk_mode::read_write);
+    auto view = MemoryView{engine, bulk, engine.self(), intent, 0, size};
+    view.self->m_storage = std::move(storage);
+    return view;
+}
+
+MemoryView MemoryView::FromData(const void* ptr) {
+    MemoryView view;
+    view.self = MemoryViewImpl::FindDeferred(ptr);
+    return view;
 }
 
 // very arbitrary
@@ -130,33 +372,25 @@ nlohmann::json MemoryView::toJson() const {
     binary.set_subtype(MEMORY_VIEW_SUBTYPE_CODE);
     // get the owner as a string
     auto owner = static_cast<std::string>(self->m_remote_ep);
-    size_t owner_size = owner.size();
     // get the bulk's serialized size
     size_t bulk_size = HG_Bulk_get_serialize_size(self->m_remote_bulk.get_bulk(), 0);
-    // calculate the needed size
-    auto bin_size = sizeof(self->m_intent)
-                  + bulk_size + sizeof(bulk_size)
-                  + owner_size + sizeof(owner_size)
-                  + sizeof(self->m_remote_offset)
-                  + sizeof(self->m_remote_size);
-    // resize
-    binary.resize(bin_size);
-    // serialize
-    size_t off = 0;
-    std::memcpy(&binary[off], &self->m_intent, sizeof(self->m_intent));
-    off += sizeof(self->m_intent);
-    std::memcpy(&binary[off], &owner_size, sizeof(owner_size));
-    off += sizeof(owner_size);
-    std::memcpy(&binary[off], owner.data(), owner_size);
-    off += owner_size;
-    std::memcpy(&binary[off], &bulk_size, sizeof(bulk_size));
-    off += sizeof(bulk_size);
+    auto& segments = self->m_segments;
+    binary.reserve(owner.size() + bulk_size + 10*(5 + segments.size()));
+    // serialize the intent, owner, bulk handle, offset, and size,
+    // followed by the sizes of the segments if they are known
+    putVarint(binary, static_cast<uint64_t>(self->m_intent));
+    putVarint(binary, owner.size());
+    binary.insert(binary.end(), owner.begin(), owner.end());
+    putVarint(binary, bulk_size);
+    auto off = binary.size();
+    binary.resize(off + bulk_size);
     margo_bulk_serialize(&binary[off], bulk_size, 0, self->m_remote_bulk.get_bulk());
-    off += bulk_size;
-    std::memcpy(&binary[off], &self->m_remote_offset, sizeof(self->m_remote_offset));
-    off += sizeof(self->m_remote_offset);
-    std::memcpy(&binary[off], &self->m_remote_size, sizeof(self->m_remote_size));
-    off += sizeof(self->m_remote_size);
+    putVarint(binary, self->m_remote_offset);
+    putVarint(binary, self->m_remote_size);
+    if(segments.size() > 1) {
+        putVarint(binary, segments.size());
+        for(auto segment : segments) putVarint(binary, segment);
+    }
     return binary;
 }
 
@@ -0,0 +1,175 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "poesie/Exception.hpp"
+#include "MemoryViewContext.hpp"
+
+#include <unordered_map>
+#include <mutex>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace poesie {
+
+static std::string canonicalPath(const std::string& path) {
+    char* resolved = ::realpath(path.c_str(), nullptr);
+    if(!resolved)
+        throw Exception{"Could not resolve " + path + ": " + std::strerror(errno)};
+    std::string result{resolved};
+    std::free(resolved);
+    return result;
+}
+
+static std::mutex s_contexts_mtx;
+static std::unordered_map<margo_instance_id, std::shared_ptr<MemoryViewContext>> s_contexts;
+
+std::shared_ptr<MemoryViewContext> MemoryViewContext::Get(const tl::engine& engine) {
+    auto mid = engine.get_margo_instance();
+    std::lock_guard<std::mutex> lock{s_contexts_mtx};
+    auto it = s_contexts.find(mid);
+    if(it != s_contexts.end()) return it->second;
+    auto context = std::make_shared<MemoryViewContext>();
+    s_contexts[mid] = context;
+    tl::engine(engine).push_finalize_callback(context.get(), [mid]() {
+        std::shared_ptr<MemoryViewContext> context;
+        {
+            std::lock_guard<std::mutex> lock{s_contexts_mtx};
+            auto it = s_contexts.find(mid);
+            if(it == s_contexts.end()) return;
+            context = std::move(it->second);
+            s_contexts.erase(it);
+        }
+        context->pool.clear();
+        context->descriptors.clear();
+        context->registrations.clear();
+    });
+    return context;
+}
+
+void MemoryViewContext::configure(const nlohmann::json& config) {
+    if(!config.is_object())
+        throw Exception{"\"memory_views\" field in provider configuration should be an object"};
+    if(config.contains("pool"))
+        pool.configure(config["pool"]);
+    if(config.contains("descriptor_cache"))
+        descriptors.configure(config["descriptor_cache"]);
+    if(config.contains("registration_cache"))
+        registrations.configure(config["registration_cache"]);
+    if(config.contains("streaming")) {
+        auto& streaming = config["streaming"];
+        if(!streaming.is_object())
+            throw Exception{"\"streaming\" field in MemoryView configuration should be an object"};
+        if(streaming.contains("chunk_size")) {
+            if(!streaming["chunk_size"].is_number_unsigned())
+                throw Exception{"\"chunk_size\" should be a positive integer"};
+            chunk_size = streaming["chunk_size"].get<size_t>();
+        }
+        if(streaming.contains("pipeline_depth")) {
+            if(!streaming["pipeline_depth"].is_number_unsigned()
+            || streaming["pipeline_depth"].get<size_t>() == 0)
+                throw Exception{"\"pipeline_depth\" should be a strictly positive integer"};
+            pipeline_depth = streaming["pipeline_depth"].get<size_t>();
+        }
+    }
+    if(config.contains("lazy")) {
+        auto& lazy = config["lazy"];
+        if(!lazy.is_object())
+            throw Exception{"\"lazy\" field in MemoryView configuration should be an object"};
+        if(lazy.contains("page_size")) {
+            if(!lazy["page_size"].is_number_unsigned())
+                throw Exception{"\"page_size\" should be a positive integer"};
+            page_size = lazy["page_size"].get<size_t>();
+        }
+    }
+    if(config.contains("track_writes")) {
+        if(!config["track_writes"].is_boolean())
+            throw Exception{"\"track_writes\" field in MemoryView configuration should be a boolean"};
+        track_writes = config["track_writes"].get<bool>();
+    }
+    if(config.contains("files")) {
+        auto& files = config["files"];
+        if(!files.is_object())
+            throw Exception{"\"files\" field in MemoryView configuration should be an object"};
+        if(files.contains("directories")) {
+            if(!files["directories"].is_array())
+                throw Exception{"\"directories\" should be an array of strings"};
+            std::vector<std::string> directories;
+            for(auto& directory : files["directories"]) {
+                if(!directory.is_string())
+                    throw Exception{"\"directories\" should be an array of strings"};
+                directories.push_back(canonicalPath(directory.get<std::string>()));
+            }
+            std::unique_lock<tl::mutex> lock{files_mtx};
+            file_directories = std::move(directories);
+        }
+        if(files.contains("writable")) {
+            if(!files["writable"].is_boolean())
+                throw Exception{"\"writable\" field in MemoryView configuration should be a boolean"};
+            writable_files = files["writable"].get<bool>();
+        }
+    }
+    if(config.contains("compression")) {
+        auto& compression = config["compression"];
+        if(!compression.is_object())
+            throw Exception{"\"compression\" field in MemoryView configuration should be an object"};
+        if(compression.contains("max_decompressed_size")) {
+            if(!compression["max_decompressed_size"].is_number_unsigned())
+                throw Exception{"\"max_decompressed_size\" should be a positive integer"};
+            max_decompressed_size = compression["max_decompressed_size"].get<size_t>();
+        }
+    }
+}
+
+nlohmann::json MemoryViewContext::getConfig() const {
+    return nlohmann::json{
+        {"pool", pool.getConfig()},
+        {"descriptor_cache", descriptors.getConfig()},
+        {"registration_cache", registrations.getConfig()},
+        {"streaming", {
+            {"chunk_size", chunk_size.load()},
+            {"pipeline_depth", pipeline_depth.load()}
+        }},
+        {"lazy", {
+            {"page_size", page_size.load()}
+        }},
+        {"track_writes", track_writes.load()},
+        {"files", {
+            {"directories", [this]() {
+                std::unique_lock<tl::mutex> lock{files_mtx};
+                return file_directories;
+            }()},
+            {"writable", writable_files.load()}
+        }},
+        {"compression", {
+            {"max_decompressed_size", max_decompressed_size.load()}
+        }}
+    };
+}
+
+nlohmann::json MemoryViewContext::getStatistics() const {
+    return nlohmann::json{
+        {"pool", pool.getStatistics()},
+        {"descriptor_cache", descriptors.getStatistics()},
+        {"registration_cache", registrations.getStatistics()}
+    };
+}
+
+std::string MemoryViewContext::checkFile(const std::string& path, bool writable) const {
+    if(writable && !writable_files)
+        throw Exception{"Writable file mappings are not enabled"};
+    // resolving symbolic links and ".." prevents escaping the directories
+    auto resolved = canonicalPath(path);
+    std::unique_lock<tl::mutex> lock{files_mtx};
+    for(auto& directory : file_directories) {
+        if(resolved.compare(0, directory.size(), directory) != 0) continue;
+        if(directory.back() == '/' || resolved.size() == directory.size()
+        || resolved[directory.size()] == '/')
+            return resolved;
+    }
+    throw Exception{"Mapping " + path + " is not allowed"};
+}
+
+}
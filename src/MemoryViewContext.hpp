@@ -0,0 +1,116 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __POESIE_MEMORY_VIEW_CONTEXT_H
+#define __POESIE_MEMORY_VIEW_CONTEXT_H
+
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "BufferPool.hpp"
+#include "DescriptorCache.hpp"
+#include "RegistrationCache.hpp"
+
+namespace poesie {
+
+namespace tl = thallium;
+
+/**
+ * @brief The MemoryViewContext holds the state and settings shared
+ * by all the MemoryViews of a given engine. It is configured through
+ * the "memory_views" entry of the provider's configuration:
+ *
+ * {
+ *    "pool": { ... see BufferPool ... },
+ *    "descriptor_cache": { ... see DescriptorCache ... },
+ *    "registration_cache": { ... see RegistrationCache ... },
+ *    "streaming": {
+ *        "chunk_size": 0,
+ *        "pipeline_depth": 4
+ *    },
+ *    "lazy": {
+ *        "page_size": 0
+ *    },
+ *    "track_writes": false,
+ *    "files": {
+ *        "directories": [],
+ *        "writable": false
+ *    },
+ *    "compression": {
+ *        "max_decompressed_size": 67108864
+ *    }
+ * }
+ *
+ * A non-zero "chunk_size" enables streaming: the content of views larger
+ * than the chunk size is pulled in chunks of that size, with up to
+ * "pipeline_depth" transfers in flight.
+ *
+ * A non-zero "page_size" enables lazy views: views larger than the page
+ * size are split into pages that are pulled the first time they are
+ * accessed. Lazy views take precedence over streaming.
+ *
+ * Setting "track_writes" to true makes OUT and INOUT views that need a
+ * local copy of the data record the byte ranges that scripts modify, so
+ * that only these ranges are pushed back instead of the whole view. Lazy
+ * views always track writes. Note that with write tracking, modifications
+ * that do not go through MemoryView::access (or data()) are lost, so the
+ * bindings that give scripts direct access to the memory of a view (e.g.
+ * Javascript's buffers) use data(), which marks the whole view as modified.
+ *
+ * "files" restricts the files that can be mapped with MemoryView::FromFile
+ * (and the memory_view_from_file function of the scripts): only files under
+ * one of the "directories" can be mapped, and only with an IN intent unless
+ * "writable" is true. By default no file can be mapped.
+ *
+ * "max_decompressed_size" caps the size of the views that scripts create
+ * by decompressing data (see compression::decompress), as that size is
+ * read from the compressed data itself.
+ */
+struct MemoryViewContext {
+
+    BufferPool          pool;
+    DescriptorCache     descriptors;
+    RegistrationCache   registrations;
+    std::atomic<size_t> chunk_size     = 0;
+    std::atomic<size_t> pipeline_depth = 4;
+    std::atomic<size_t> page_size      = 0;
+    std::atomic<bool>   track_writes   = false;
+
+    std::vector<std::string> file_directories;
+    std::atomic<bool>        writable_files = false;
+    mutable tl::mutex        files_mtx;
+
+    std::atomic<size_t> max_decompressed_size = 64*1024*1024;
+
+    void configure(const nlohmann::json& config);
+
+    nlohmann::json getConfig() const;
+
+    nlohmann::json getStatistics() const;
+
+    /**
+     * @brief Check that the file can be mapped according to the "files"
+     * settings and return its canonical path, which the caller should
+     * open instead of the path it was given.
+     *
+     * @param path Path of the file.
+     * @param writable Whether modifications should be written to the file.
+     */
+    std::string checkFile(const std::string& path, bool writable) const;
+
+    /**
+     * @brief Get the MemoryViewContext associated with the engine,
+     * creating it if needed. The context's pool and caches
+     * are cleared when the engine is finalized.
+     */
+    static std::shared_ptr<MemoryViewContext> Get(const tl::engine& engine);
+};
+
+}
+
+#endif
@@ -9,6 +9,11 @@
 #include <thallium.hpp>
 #include <poesie/Exception.hpp>
 #include <poesie/MemoryView.hpp>
+#include "MemoryViewContext.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
 
 namespace poesie {
 
@@ -21,29 +26,135 @@ class MemoryViewImpl : public std::enable_shared_from_this<MemoryViewImpl> {
     tl::engine m_engine;
     // intent
     MemoryView::Intent m_intent;
+    // memory backing a file-backed or allocated view, released once
+    // the bulk handles below are released
+    std::shared_ptr<void> m_storage;
     // remote data
     tl::bulk     m_remote_bulk;
     tl::endpoint m_remote_ep;
     size_t       m_remote_offset;
     size_t       m_remote_size;
+    // sizes of the segments of the remote bulk handle, if known
+    std::vector<size_t> m_segments;
+    // view this view is a slice of, if any, and offset of the slice in it;
+    // slices share the local data, state, and write-back of their parent
+    std::shared_ptr<MemoryViewImpl> m_parent;
+    size_t                          m_parent_offset = 0;
     // local data, lazy-initialized
     char*    m_local_data = nullptr;
     tl::bulk m_local_bulk;
     bool     m_owns_local_data = false;
+    // context the view belongs to
+    std::shared_ptr<MemoryViewContext> m_context;
+    // buffer borrowed from the context's pool, if any
+    bool               m_pooled = false;
+    BufferPool::Buffer m_pool_buffer;
+    // registration of the client buffer borrowed from the
+    // context's registration cache, if any
+    bool                            m_registered = false;
+    RegistrationCache::Registration m_registration;
+    // streaming state: the local data is pulled in chunks of m_chunk_size
+    // bytes, chunks before m_ready_chunks have been received and chunks
+    // from m_ready_chunks to m_issued_chunks are in flight
+    tl::mutex                  m_mtx;
+    size_t                     m_chunk_size     = 0;
+    size_t                     m_pipeline_depth = 1;
+    size_t                     m_ready_chunks   = 0;
+    size_t                     m_issued_chunks  = 0;
+    std::vector<margo_request> m_chunk_requests;
+    // lazy state: the local data is pulled in pages of m_page_size bytes
+    // the first time they are accessed
+    size_t            m_page_size = 0;
+    std::vector<bool> m_pages;
+    // write tracking: for lazy views and views created while "track_writes"
+    // is enabled, m_dirty maps the beginning of each modified range of the
+    // local data to its end (ranges never overlap nor touch), and only these
+    // ranges are pushed back (see startWriteBack)
+    bool                     m_track_writes = false;
+    std::map<size_t, size_t> m_dirty;
+
+    // write-back state: the transfers pushing the local data back to
+    // the remote data are issued by startWriteBack and waited for when
+    // the view is destroyed
+    bool                       m_write_back_started = false;
+    std::vector<margo_request> m_push_requests;
 
     MemoryViewImpl() = default;
 
     ~MemoryViewImpl() {
         if(!m_engine) return;
+        if(m_registered) m_context->registrations.release(m_registration);
         if(m_local_bulk.is_null()) return;
-        if((m_intent == MemoryView::Intent::INOUT || m_intent == MemoryView::Intent::OUT)) {
-            m_remote_bulk.on(m_remote_ep)(m_remote_offset, m_remote_size) << m_local_bulk;
+        if(isDeferred()) UnregisterDeferred(m_local_data);
+        try {
+            startWriteBack();
+        } catch(...) {
+            // the transfers that could be issued are still waited for below
         }
-        if(m_owns_local_data) delete[] m_local_data;
+        for(auto& req : m_push_requests) margo_wait(req);
+        // drain the chunk transfers still in flight
+        for(; m_ready_chunks < m_issued_chunks; ++m_ready_chunks)
+            margo_wait(m_chunk_requests[m_ready_chunks]);
+        if(m_pooled) m_context->pool.release(std::move(m_pool_buffer));
+        else if(m_owns_local_data) delete[] m_local_data;
+    }
+
+    size_t chunkSize() const {
+        if(m_parent) return m_parent->chunkSize();
+        if(m_chunk_size) return m_chunk_size;
+        if(m_page_size) return m_page_size;
+        return m_remote_size;
+    }
+
+    size_t numChunks() const {
+        auto chunk_size = chunkSize();
+        if(!chunk_size) return 1;
+        return (m_remote_size + chunk_size - 1)/chunk_size;
     }
 
     void prepareLocalData() {
         if(m_local_data) return;
+        if(m_parent) {
+            m_parent->prepareLocalData();
+            m_local_data = m_parent->m_local_data + m_parent_offset;
+            return;
+        }
+        fetchLocalData();
+        if(isDeferred()) RegisterDeferred(m_local_data, shared_from_this());
+    }
+
+    /**
+     * @brief Whether the view is registered as a deferred view,
+     * i.e. whether scripts need to go through the view to access it.
+     */
+    bool isDeferred() const {
+        return m_chunk_size || tracksWrites() || numSegments() > 1;
+    }
+
+    /**
+     * @brief Return the (offset, size) of the client memory segments that
+     * the view spans, relative to the beginning of the view. A view built
+     * from a bulk handle of unknown segments consists of a single segment.
+     */
+    std::vector<std::pair<size_t, size_t>> segments() const {
+        std::vector<std::pair<size_t, size_t>> result;
+        size_t begin = 0;
+        for(auto size : m_segments) {
+            auto lo = std::max(begin, m_remote_offset);
+            auto hi = std::min(begin + size, m_remote_offset + m_remote_size);
+            if(lo < hi) result.emplace_back(lo - m_remote_offset, hi - lo);
+            begin += size;
+        }
+        if(result.empty()) result.emplace_back(0, m_remote_size);
+        return result;
+    }
+
+    size_t numSegments() const {
+        if(m_segments.size() <= 1) return 1;
+        return segments().size();
+    }
+
+    void fetchLocalData() {
         if(m_remote_ep == m_engine.self()) {
             // this is a local bulk handle, try to extract the underlying data
             void* buf_ptr = nullptr;
@@ -61,23 +172,209 @@ class MemoryViewImpl : public std::enable_shared_from_this<MemoryViewImpl> {
             return;
         }
         fetch_from_remote:
-        // this is a remove bulk handle or a non-contiguous local one
-        m_local_data = new char[m_remote_size];
-        if(m_intent == MemoryView::Intent::IN)
-            m_local_bulk = m_engine.expose({{m_local_data, m_remote_size}}, tl::bulk_mode::write_only);
-        else if(m_intent == MemoryView::Intent::INOUT)
-            m_local_bulk = m_engine.expose({{m_local_data, m_remote_size}}, tl::bulk_mode::read_write);
-        else
-            m_local_bulk = m_engine.expose({{m_local_data, m_remote_size}}, tl::bulk_mode::read_only);
-        m_owns_local_data = true;
-        if(m_intent == MemoryView::Intent::IN || m_intent == MemoryView::Intent::INOUT) {
+        // this is a remove bulk handle or a non-contiguous local one,
+        // try to borrow an already registered buffer from the engine's pool
+        m_context = MemoryViewContext::Get(m_engine);
+        if(m_context->pool.acquire(m_engine, m_remote_size, m_pool_buffer)) {
+            m_local_data = m_pool_buffer.data;
+            m_local_bulk = m_pool_buffer.bulk;
+            m_pooled = true;
+        } else {
+            m_local_data = new char[m_remote_size];
+            if(m_intent == MemoryView::Intent::IN)
+                m_local_bulk = m_engine.expose({{m_local_data, m_remote_size}}, tl::bulk_mode::write_only);
+            else if(m_intent == MemoryView::Intent::INOUT)
+                m_local_bulk = m_engine.expose({{m_local_data, m_remote_size}}, tl::bulk_mode::read_write);
+            else
+                m_local_bulk = m_engine.expose({{m_local_data, m_remote_size}}, tl::bulk_mode::read_only);
+            m_owns_local_data = true;
+        }
+        // the staging buffer may hold the data of a previous request,
+        // which the script must not see through an OUT view
+        if(m_intent == MemoryView::Intent::OUT)
+            std::memset(m_local_data, 0, m_remote_size);
+        m_track_writes = m_context->track_writes.load()
+                      && m_intent != MemoryView::Intent::IN;
+        auto page_size = m_context->page_size.load();
+        if(page_size && m_remote_size > page_size) {
+            // fetch pages on demand, see access
+            m_page_size = page_size;
+            m_pages.resize(numChunks(), m_intent == MemoryView::Intent::OUT);
+            return;
+        }
+        if(m_intent == MemoryView::Intent::OUT) return;
+        auto chunk_size = m_context->chunk_size.load();
+        if(chunk_size && m_remote_size > chunk_size) {
+            // stream the data in chunks, see waitChunk
+            m_chunk_size     = chunk_size;
+            m_pipeline_depth = m_context->pipeline_depth.load();
+            m_chunk_requests.resize(numChunks(), MARGO_REQUEST_NULL);
+            {
+                std::unique_lock<tl::mutex> lock{m_mtx};
+                issueChunks();
+            }
+            return;
+        }
+        try {
+            m_remote_bulk.on(m_remote_ep)(m_remote_offset, m_remote_size) >> m_local_bulk(0, m_remote_size);
+        } catch(const thallium::exception& ex) {
+            throw Exception{ex.what()};
+        }
+    }
+
+    /**
+     * @brief Make the specified range of the local data available,
+     * waiting for the chunks or fetching the pages it spans, and mark
+     * it as modified if write is true. Must be called after prepareLocalData.
+     */
+    void access(size_t offset, size_t size, bool write) {
+        if(size == 0) return;
+        if(m_parent) {
+            m_parent->access(m_parent_offset + offset, size, write);
+            return;
+        }
+        if(m_chunk_size)
+            waitChunk((offset + size - 1)/m_chunk_size);
+        if(!m_page_size && !(write && m_track_writes)) return;
+        std::unique_lock<tl::mutex> lock{m_mtx};
+        if(m_page_size) fetchPages(offset/m_page_size, (offset + size - 1)/m_page_size);
+        if(write && tracksWrites()) markDirty(offset, offset + size);
+    }
+
+    /**
+     * @brief Whether only the ranges marked as modified by access
+     * are pushed back when the view is destroyed.
+     */
+    bool tracksWrites() const {
+        if(m_parent) return m_parent->tracksWrites();
+        return m_page_size || m_track_writes;
+    }
+
+    /**
+     * @brief Fetch the missing pages among pages first to last (included),
+     * one transfer per contiguous run. Must be called with m_mtx locked.
+     */
+    void fetchPages(size_t first, size_t last) {
+        for(size_t p = first; p <= last;) {
+            if(m_pages[p]) {
+                ++p;
+                continue;
+            }
+            size_t q = p;
+            while(q <= last && !m_pages[q]) ++q;
+            auto begin = p*m_page_size;
+            auto end   = std::min(q*m_page_size, m_remote_size);
             try {
-                m_remote_bulk.on(m_remote_ep)(m_remote_offset, m_remote_size) >> m_local_bulk;
+                m_remote_bulk.on(m_remote_ep)(m_remote_offset + begin, end - begin)
+                    >> m_local_bulk(begin, end - begin);
             } catch(const thallium::exception& ex) {
                 throw Exception{ex.what()};
             }
+            for(; p < q; ++p) m_pages[p] = true;
+        }
+    }
+
+    /**
+     * @brief Add the [begin, end) range to the modified ranges, merging it
+     * with the ranges it overlaps or touches. Must be called with m_mtx locked.
+     */
+    void markDirty(size_t begin, size_t end) {
+        auto it = m_dirty.upper_bound(begin);
+        if(it != m_dirty.begin()) {
+            auto prev = std::prev(it);
+            if(prev->second >= begin) {
+                if(prev->second >= end) return;
+                begin = prev->first;
+                it = prev;
+            }
+        }
+        while(it != m_dirty.end() && it->first <= end) {
+            end = std::max(end, it->second);
+            it = m_dirty.erase(it);
+        }
+        m_dirty[begin] = end;
+    }
+
+    /**
+     * @brief Issue non-blocking transfers pushing the local data back to
+     * the remote data, if the view is an OUT or INOUT view with a local
+     * copy of the data: one transfer per modified range if the view tracks
+     * writes, a single one for the whole view otherwise. The transfers are
+     * waited for by the destructor. Only the first call has an effect,
+     * and slices are written back with their parent.
+     */
+    void startWriteBack() {
+        if(m_parent || m_write_back_started) return;
+        m_write_back_started = true;
+        if(!m_owns_local_data && !m_pooled) return;
+        if(m_intent == MemoryView::Intent::IN) return;
+        // don't push back partially received data (this throws if
+        // some of the chunks could not be received)
+        if(m_chunk_size) waitChunk(numChunks() - 1);
+        std::map<size_t, size_t> ranges;
+        if(tracksWrites()) {
+            std::unique_lock<tl::mutex> lock{m_mtx};
+            ranges = m_dirty;
+        } else {
+            ranges[0] = m_remote_size;
+        }
+        m_push_requests.reserve(ranges.size());
+        for(auto& range : ranges) {
+            margo_request req = MARGO_REQUEST_NULL;
+            auto hret = margo_bulk_itransfer(
+                m_engine.get_margo_instance(), HG_BULK_PUSH,
+                m_remote_ep.get_addr(), m_remote_bulk.get_bulk(), m_remote_offset + range.first,
+                m_local_bulk.get_bulk(), range.first, range.second - range.first, &req);
+            if(hret != HG_SUCCESS)
+                throw Exception{"margo_bulk_itransfer failed when writing back MemoryView data"};
+            m_push_requests.push_back(req);
         }
     }
+
+    /**
+     * @brief Wait for all the chunks up to (and including) the specified
+     * one to be available. Must be called after prepareLocalData.
+     */
+    void waitChunk(size_t index) {
+        if(!m_chunk_size) return;
+        std::unique_lock<tl::mutex> lock{m_mtx};
+        while(m_ready_chunks <= index && m_ready_chunks < m_chunk_requests.size()) {
+            auto hret = margo_wait(m_chunk_requests[m_ready_chunks]);
+            m_ready_chunks += 1;
+            if(hret != HG_SUCCESS)
+                throw Exception{"margo_wait failed when streaming MemoryView data"};
+            issueChunks();
+        }
+    }
+
+    /**
+     * @brief Issue chunk transfers until m_pipeline_depth of them are in
+     * flight. Must be called with m_mtx locked.
+     */
+    void issueChunks() {
+        auto n = m_chunk_requests.size();
+        while(m_issued_chunks < n && m_issued_chunks - m_ready_chunks < m_pipeline_depth) {
+            auto offset = m_issued_chunks*m_chunk_size;
+            auto size   = std::min(m_chunk_size, m_remote_size - offset);
+            auto hret = margo_bulk_itransfer(
+                m_engine.get_margo_instance(), HG_BULK_PULL,
+                m_remote_ep.get_addr(), m_remote_bulk.get_bulk(), m_remote_offset + offset,
+                m_local_bulk.get_bulk(), offset, size, &m_chunk_requests[m_issued_chunks]);
+            if(hret != HG_SUCCESS)
+                throw Exception{"margo_bulk_itransfer failed when streaming MemoryView data"};
+            m_issued_chunks += 1;
+        }
+    }
+
+    /**
+     * @brief Registry of the views whose data is streamed or lazily
+     * fetched, whose writes are tracked, or that span several segments
+     * (see isDeferred), allowing backends to find the view a pointer handed to
+     * a script belongs to.
+     */
+    static void RegisterDeferred(const char* data, const std::shared_ptr<MemoryViewImpl>& view);
+    static void UnregisterDeferred(const char* data);
+    static std::shared_ptr<MemoryViewImpl> FindDeferred(const void* ptr);
 };
 
 }
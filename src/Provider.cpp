@@ -34,8 +34,20 @@ std::string Provider::getConfig() const {
     return self ? self->getConfig() : "{}";
 }
 
-Backend* Provider::getBackend() const {
-    return self ? self->m_backend.get() : nullptr;
+std::string Provider::getStatistics() const {
+    return self ? self->getStatistics() : "{}";
+}
+
+Backend* Provider::getBackend(const std::string& vm_name) const {
+    if(!self) return nullptr;
+    auto vm = self->findVm(vm_name);
+    return vm ? vm->backend.get() : nullptr;
+}
+
+std::shared_ptr<Backend> Provider::getSharedBackend(const std::string& vm_name) const {
+    if(!self) return nullptr;
+    auto vm = self->findVm(vm_name);
+    return vm ? vm->backend : nullptr;
 }
 
 Provider::operator bool() const {
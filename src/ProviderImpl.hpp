@@ -8,6 +8,12 @@
 
 #include "poesie/JsonSerialize.hpp"
 #include "poesie/Backend.hpp"
+#include "MemoryViewContext.hpp"
+#include "ReplicatedBackend.hpp"
+#include "DedicatedBackend.hpp"
+#include "WarmPoolBackend.hpp"
+#include "Scheduler.hpp"
+#include "AdmissionControl.hpp"
 
 #include <thallium.hpp>
 #include <thallium/serialization/stl/string.hpp>
@@ -16,7 +22,17 @@
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 
+#include <unordered_map>
+#include <map>
+#include <atomic>
+#include <unordered_set>
+#include <deque>
 #include <tuple>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <dlfcn.h>
 
 namespace poesie {
 
@@ -47,15 +63,131 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
 
     public:
 
+    /**
+     * @brief Set while a Python VM exists in the process (in any
+     * provider), since a process has a single Python interpreter.
+     */
+    static inline std::atomic<bool> s_python_reserved = false;
+
+    /**
+     * @brief Holds the process' Python interpreter for a Python VM,
+     * releasing it when destroyed.
+     */
+    struct PythonReservation {
+
+        bool held = false;
+
+        PythonReservation() = default;
+        PythonReservation(const PythonReservation&) = delete;
+        PythonReservation& operator=(const PythonReservation&) = delete;
+
+        bool acquire() {
+            bool expected = false;
+            held = s_python_reserved.compare_exchange_strong(expected, true);
+            return held;
+        }
+
+        ~PythonReservation() {
+            if(held) s_python_reserved = false;
+        }
+    };
+
+    /**
+     * @brief A VM hosted by the provider, along with
+     * the objects controlling how requests use it.
+     */
+    struct Vm {
+        // Declared first so that it is released after the backend is destroyed
+        PythonReservation                  python;
+        std::shared_ptr<Backend>           backend;
+        // Set (and equal to backend) if the VM is replicated
+        std::shared_ptr<ReplicatedBackend> replicated;
+        // Set (and equal to backend) if each request runs in a fresh VM
+        std::shared_ptr<WarmPoolBackend>   warm_pool;
+        // Whether each replica runs on its own execution stream, and the CPUs they are bound to
+        bool                               dedicated_xstreams = false;
+        std::vector<int>                   cpus;
+        // Order in which requests get to use the VM
+        Scheduler                          scheduler;
+        // Native functions loaded from plugin libraries
+        json                               natives = json::array();
+        // Whether the VM was created by a client, and the number of VMs and
+        // execution streams it counts against the limits of "remote_vms"
+        bool                               remote = false;
+        size_t                             num_vms = 0;
+        size_t                             num_xstreams = 0;
+    };
+
     tl::engine           m_engine;
     tl::pool             m_pool;
     // Client RPC
     tl::auto_remote_procedure m_execute;
     tl::auto_remote_procedure m_load;
     tl::auto_remote_procedure m_call;
+    tl::auto_remote_procedure m_install;
+    tl::auto_remote_procedure m_cancel;
+    tl::auto_remote_procedure m_create_vm;
+    tl::auto_remote_procedure m_destroy_vm;
     // FIXME: other RPCs go here ...
-    // Backend
-    std::shared_ptr<Backend> m_backend;
+    // VMs by name, the VM of the "vm" entry of the configuration being named ""
+    std::map<std::string, std::shared_ptr<Vm>> m_vms;
+    mutable tl::mutex                           m_vms_mtx;
+    // Configuration of the scheduler of each VM
+    json m_scheduler_config;
+    // Limits on the requests accepted by the provider
+    AdmissionControl m_admission;
+    // Plugin libraries providing native functions, guarded by m_vms_mtx
+    std::vector<void*> m_libraries;
+    // Directories from which plugin libraries may be loaded, and whether
+    // clients may install native functions (only set by the constructor)
+    std::vector<std::string> m_plugin_directories;
+    bool                     m_remote_install = false;
+    // Whether clients may create VMs, and the VMs and execution streams they
+    // may use at most (only set by the constructor)
+    bool   m_remote_vms = false;
+    size_t m_max_remote_vms = 8;
+    size_t m_max_remote_xstreams = 0;
+    // VMs and execution streams used by the VMs created by clients, guarded by m_vms_mtx
+    size_t m_num_remote_vms = 0;
+    size_t m_num_remote_xstreams = 0;
+    // Requests in progress, by request id, so that clients can cancel them
+    std::unordered_map<uint64_t, ExecutionContext*> m_requests;
+    // Ids of the last requests cancelled before they were received
+    std::unordered_set<uint64_t> m_early_cancels;
+    std::deque<uint64_t>         m_early_cancels_order;
+    tl::mutex                    m_requests_mtx;
+
+    static constexpr size_t s_max_early_cancels = 1024;
+
+    /**
+     * @brief Makes the ExecutionContext of a request available
+     * to cancelRPC for as long as the request is in progress.
+     */
+    class TrackedRequest {
+
+        ProviderImpl& m_provider;
+        uint64_t      m_id;
+
+        public:
+
+        TrackedRequest(ProviderImpl& provider, uint64_t id, ExecutionContext& context)
+        : m_provider(provider)
+        , m_id(id) {
+            if(m_id == 0) return;
+            std::unique_lock<tl::mutex> lock{m_provider.m_requests_mtx};
+            if(m_provider.m_early_cancels.erase(m_id)) context.cancel();
+            m_provider.m_requests[m_id] = &context;
+        }
+
+        TrackedRequest(const TrackedRequest&) = delete;
+        TrackedRequest& operator=(const TrackedRequest&) = delete;
+
+        ~TrackedRequest() {
+            if(m_id == 0) return;
+            std::unique_lock<tl::mutex> lock{m_provider.m_requests_mtx};
+            m_provider.m_requests.erase(m_id);
+        }
+    };
 
     ProviderImpl(const tl::engine& engine, uint16_t provider_id,
                  const std::string& config, const tl::pool& pool)
@@ -65,6 +197,10 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
     , m_execute(define("poesie_execute",  &ProviderImpl::executeRPC, pool))
     , m_load(define("poesie_load",  &ProviderImpl::loadRPC, pool))
     , m_call(define("poesie_call",  &ProviderImpl::callRPC, pool))
+    , m_install(define("poesie_install",  &ProviderImpl::installRPC, pool))
+    , m_cancel(define("poesie_cancel",  &ProviderImpl::cancelRPC, pool))
+    , m_create_vm(define("poesie_create_vm",  &ProviderImpl::createVmRPC, pool))
+    , m_destroy_vm(define("poesie_destroy_vm",  &ProviderImpl::destroyVmRPC, pool))
     {
         trace("Registered provider with id {}", get_provider_id());
         json json_config;
@@ -75,44 +211,366 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
             return;
         }
         if(!json_config.is_object()) return;
-        if(!json_config.contains("vm")) return;
-        auto& vm = json_config["vm"];
-        if(!vm.is_object()) return;
-        if(vm.contains("type") && vm["type"].is_string()) {
-            auto& vm_type = vm["type"].get_ref<const std::string&>();
-            auto vm_config = vm.contains("config") ? vm["config"] : json::object();
-            auto result = createVm(vm_type, vm_config);
-            result.check();
+        if(json_config.contains("memory_views"))
+            MemoryViewContext::Get(m_engine)->configure(json_config["memory_views"]);
+        if(json_config.contains("scheduler"))
+            m_scheduler_config = json_config["scheduler"];
+        if(json_config.contains("admission"))
+            m_admission.configure(json_config["admission"]);
+        if(json_config.contains("plugins"))
+            configurePlugins(json_config["plugins"]);
+        if(json_config.contains("remote_vms"))
+            configureRemoteVms(json_config["remote_vms"]);
+        if(json_config.contains("vm")) {
+            auto& vm = json_config["vm"];
+            if(vm.is_object() && vm.contains("type") && vm["type"].is_string()) {
+                auto description = vm;
+                // the top-level "natives" are installed in the default VM
+                if(json_config.contains("natives")) {
+                    if(!json_config["natives"].is_array())
+                        throw Exception{"\"natives\" field in provider configuration should be an array"};
+                    description["natives"] = json_config["natives"];
+                }
+                createVm("", description).check();
+            }
+        }
+        // created after the default VM so that they may be cloned from it
+        if(json_config.contains("vms")) {
+            auto& vms = json_config["vms"];
+            if(!vms.is_object())
+                throw Exception{"\"vms\" field in provider configuration should be an object"};
+            for(auto& [name, vm] : vms.items()) {
+                if(name.empty())
+                    throw Exception{"VM names in \"vms\" field should not be empty"};
+                createVm(name, vm).check();
+            }
         }
     }
 
     ~ProviderImpl() {
         trace("Deregistering provider");
-        if(m_backend) {
-            m_backend->destroy();
+        for(auto& [name, vm] : m_vms)
+            vm->backend->destroy();
+        m_vms.clear();
+        std::unique_lock<tl::mutex> lock{m_vms_mtx};
+        for(auto handle : m_libraries) dlclose(handle);
+        m_libraries.clear();
+    }
+
+    void configurePlugins(const json& config) {
+        if(!config.is_object())
+            throw Exception{"\"plugins\" field in provider configuration should be an object"};
+        if(config.contains("directories")) {
+            if(!config["directories"].is_array())
+                throw Exception{"\"directories\" field in plugins configuration should be an array of strings"};
+            for(auto& directory : config["directories"]) {
+                if(!directory.is_string())
+                    throw Exception{"\"directories\" field in plugins configuration should be an array of strings"};
+                m_plugin_directories.push_back(canonicalPath(directory.get<std::string>()));
+            }
+        }
+        if(config.contains("remote_install")) {
+            if(!config["remote_install"].is_boolean())
+                throw Exception{"\"remote_install\" field in plugins configuration should be a boolean"};
+            m_remote_install = config["remote_install"].get<bool>();
+        }
+    }
+
+    void configureRemoteVms(const json& config) {
+        if(!config.is_object())
+            throw Exception{"\"remote_vms\" field in provider configuration should be an object"};
+        if(config.contains("enabled")) {
+            if(!config["enabled"].is_boolean())
+                throw Exception{"\"enabled\" field in remote_vms configuration should be a boolean"};
+            m_remote_vms = config["enabled"].get<bool>();
+        }
+        if(config.contains("max_vms")) {
+            if(!config["max_vms"].is_number_unsigned())
+                throw Exception{"\"max_vms\" field in remote_vms configuration should be an unsigned integer"};
+            m_max_remote_vms = config["max_vms"].get<size_t>();
+        }
+        if(config.contains("max_xstreams")) {
+            if(!config["max_xstreams"].is_number_unsigned())
+                throw Exception{"\"max_xstreams\" field in remote_vms configuration should be an unsigned integer"};
+            m_max_remote_xstreams = config["max_xstreams"].get<size_t>();
+        }
+    }
+
+    static std::string canonicalPath(const std::string& path) {
+        char* resolved = ::realpath(path.c_str(), nullptr);
+        if(!resolved)
+            throw Exception{"Could not resolve "s + path + ": " + std::strerror(errno)};
+        std::string result{resolved};
+        std::free(resolved);
+        return result;
+    }
+
+    /**
+     * @brief Resolve the path of a plugin library, checking that it is
+     * in one of the directories of the "plugins" configuration. Libraries
+     * run code as soon as they are loaded, so none is allowed by default.
+     */
+    std::string checkLibrary(const std::string& library) const {
+        // resolving symbolic links and ".." prevents escaping the directories
+        auto resolved = canonicalPath(library);
+        for(auto& directory : m_plugin_directories) {
+            if(resolved.compare(0, directory.size(), directory) != 0) continue;
+            if(directory.back() == '/' || resolved[directory.size()] == '/')
+                return resolved;
         }
+        throw Exception{"Loading library "s + library + " is not allowed"};
+    }
+
+    std::shared_ptr<Vm> findVm(const std::string& name) const {
+        std::unique_lock<tl::mutex> lock{m_vms_mtx};
+        auto it = m_vms.find(name);
+        return it == m_vms.end() ? nullptr : it->second;
+    }
+
+    static std::string noSuchVm(const std::string& name) {
+        if(name.empty()) return "Provider has no VM attached";
+        return "Provider has no VM named \""s + name + "\"";
+    }
+
+    static json vmConfig(const Vm& vm) {
+        auto vm_config = json::object();
+        vm_config["type"] = vm.backend->name();
+        vm_config["config"] = json::parse(vm.backend->getConfig());
+        if(vm.replicated) {
+            vm_config["replicas"] = vm.replicated->numReplicas();
+            auto& read_only = vm.replicated->readOnlyFunctions();
+            vm_config["read_only"] = std::vector<std::string>{
+                read_only.begin(), read_only.end()};
+        }
+        if(vm.warm_pool) {
+            vm_config["isolation"] = "per_request";
+            vm_config["warm_pool_size"] = vm.warm_pool->size();
+        }
+        if(vm.dedicated_xstreams)
+            vm_config["dedicated_xstreams"] = true;
+        if(!vm.cpus.empty())
+            vm_config["cpus"] = vm.cpus;
+        return vm_config;
     }
 
     std::string getConfig() const {
         auto config = json::object();
-        if(m_backend) {
-            config["vm"] = json::object();
-            auto vm_config = json::object();
-            vm_config["type"] = m_backend->name();
-            vm_config["config"] = json::parse(m_backend->getConfig());
-            config["vm"] = std::move(vm_config);
+        std::unique_lock<tl::mutex> lock{m_vms_mtx};
+        for(auto& [name, vm] : m_vms) {
+            if(name.empty()) {
+                config["vm"] = vmConfig(*vm);
+                if(!vm->natives.empty())
+                    config["natives"] = vm->natives;
+            } else {
+                auto vm_config = vmConfig(*vm);
+                if(!vm->natives.empty())
+                    vm_config["natives"] = vm->natives;
+                config["vms"][name] = std::move(vm_config);
+            }
         }
+        auto default_vm = m_vms.find("");
+        // the scheduler of the default VM shows the defaults that were filled in
+        if(default_vm != m_vms.end() && default_vm->second->scheduler.enabled())
+            config["scheduler"] = default_vm->second->scheduler.getConfig();
+        else if(!m_scheduler_config.is_null())
+            config["scheduler"] = m_scheduler_config;
+        lock.unlock();
+        if(m_admission.enabled())
+            config["admission"] = m_admission.getConfig();
+        config["remote_vms"] = json{
+            {"enabled", m_remote_vms},
+            {"max_vms", m_max_remote_vms},
+            {"max_xstreams", m_max_remote_xstreams}
+        };
+        config["plugins"] = json{
+            {"directories", m_plugin_directories},
+            {"remote_install", m_remote_install}
+        };
+        config["memory_views"] = MemoryViewContext::Get(m_engine)->getConfig();
         return config.dump();
     }
 
-    Result<bool> createVm(const std::string& vm_type,
-                          const json& vm_config) {
+    std::string getStatistics() const {
+        auto stats = json::object();
+        stats["memory_views"] = MemoryViewContext::Get(m_engine)->getStatistics();
+        std::unique_lock<tl::mutex> lock{m_vms_mtx};
+        for(auto& [name, vm] : m_vms) {
+            // statistics of the default VM are at the top level
+            auto& vm_stats = name.empty() ? stats : stats["vms"][name];
+            if(vm->replicated)
+                vm_stats["vm"] = vm->replicated->getStatistics();
+            if(vm->warm_pool)
+                vm_stats["vm"] = vm->warm_pool->getStatistics();
+            if(vm->scheduler.enabled())
+                vm_stats["scheduler"] = vm->scheduler.getStatistics();
+        }
+        lock.unlock();
+        if(m_admission.enabled())
+            stats["admission"] = m_admission.getStatistics();
+        return stats.dump();
+    }
+
+    /**
+     * @brief Create a VM from its description, i.e. an entry of the
+     * "vms" field (or the "vm" field) of the provider's configuration,
+     * and make it available under the specified name.
+     *
+     * Instead of "type" and "config", the description may contain
+     * "clone_from": name, in which case the VM is cloned from the
+     * VM with that name (see Backend::clone) along with the native
+     * functions installed in it.
+     *
+     * VMs created by clients (remote = true) can't run a "preamble_file"
+     * or install "natives" unless clients may install native functions,
+     * and count against the limits of the "remote_vms" configuration.
+     */
+    Result<bool> createVm(const std::string& name, const json& description, bool remote = false) {
 
         Result<bool> result;
+        auto vm = std::make_shared<Vm>();
+        std::string vm_type;
+        bool reserved = false;
 
         try {
-            m_backend = VmFactory::createVm(vm_type, get_engine(), vm_config);
+            if(!description.is_object())
+                throw Exception{"VM configuration should be an object"};
+            std::shared_ptr<Vm> source;
+            json vm_config;
+            if(description.contains("clone_from")) {
+                if(!description["clone_from"].is_string())
+                    throw Exception{"\"clone_from\" field in VM configuration should be a string"};
+                if(description.contains("type") || description.contains("config"))
+                    throw Exception{"\"clone_from\" field in VM configuration excludes \"type\" and \"config\""};
+                auto& source_name = description["clone_from"].get_ref<const std::string&>();
+                source = findVm(source_name);
+                if(!source) throw Exception{noSuchVm(source_name)};
+                vm_type = source->backend->name();
+            } else {
+                if(!description.contains("type") || !description["type"].is_string())
+                    throw Exception{"\"type\" field in VM configuration should be a string"};
+                vm_type = description["type"].get<std::string>();
+                vm_config = description.contains("config") ? description["config"] : json::object();
+            }
+            size_t replicas = 1;
+            if(description.contains("replicas")) {
+                if(!description["replicas"].is_number_unsigned() || description["replicas"].get<size_t>() == 0)
+                    throw Exception{"\"replicas\" field in VM configuration should be a strictly positive integer"};
+                replicas = description["replicas"].get<size_t>();
+            }
+            std::unordered_set<std::string> read_only;
+            if(description.contains("read_only")) {
+                if(!description["read_only"].is_array())
+                    throw Exception{"\"read_only\" field in VM configuration should be an array"};
+                for(auto& function : description["read_only"]) {
+                    if(!function.is_string())
+                        throw Exception{"Invalid entry in \"read_only\" field of VM configuration"};
+                    read_only.insert(function.get<std::string>());
+                }
+            }
+            if(description.contains("dedicated_xstreams")) {
+                if(!description["dedicated_xstreams"].is_boolean())
+                    throw Exception{"\"dedicated_xstreams\" field in VM configuration should be a boolean"};
+                vm->dedicated_xstreams = description["dedicated_xstreams"].get<bool>();
+            }
+            if(description.contains("cpus")) {
+                if(!description["cpus"].is_array() || description["cpus"].empty())
+                    throw Exception{"\"cpus\" field in VM configuration should be a non-empty array"};
+                for(auto& cpu : description["cpus"]) {
+                    if(!cpu.is_number_unsigned())
+                        throw Exception{"Invalid entry in \"cpus\" field of VM configuration"};
+                    vm->cpus.push_back(cpu.get<int>());
+                }
+                vm->dedicated_xstreams = true;
+            }
+            bool per_request = false;
+            if(description.contains("isolation")) {
+                auto& isolation = description["isolation"];
+                if(isolation != "shared" && isolation != "per_request")
+                    throw Exception{"\"isolation\" field in VM configuration should be \"shared\" or \"per_request\""};
+                per_request = isolation == "per_request";
+            }
+            size_t warm_pool_size = 4;
+            if(description.contains("warm_pool_size")) {
+                if(!description["warm_pool_size"].is_number_unsigned())
+                    throw Exception{"\"warm_pool_size\" field in VM configuration should be an unsigned integer"};
+                warm_pool_size = description["warm_pool_size"].get<size_t>();
+            }
+            if(per_request && (replicas > 1 || !read_only.empty() || vm->dedicated_xstreams))
+                throw Exception{"\"isolation\": \"per_request\" can't be combined with \"replicas\","
+                                " \"read_only\", \"dedicated_xstreams\", or \"cpus\""};
+            if(description.contains("natives") && !description["natives"].is_array())
+                throw Exception{"\"natives\" field in VM configuration should be an array"};
+            // a Python VM owns the only Python interpreter of the process,
+            // so any configuration requiring a second instance would fail
+            if(vm_type == "python") {
+                if(source)
+                    throw Exception{"Python VMs can't be cloned (a process has a single Python interpreter)"};
+                if(replicas > 1 || per_request)
+                    throw Exception{"Python VMs can't have \"replicas\" or \"isolation\": \"per_request\""
+                                    " (a process has a single Python interpreter)"};
+                if(!vm->python.acquire())
+                    throw Exception{"Process already has a Python VM (a process has a single Python interpreter)"};
+            }
+            if(remote) {
+                if(vm_config.is_object() && vm_config.contains("preamble_file"))
+                    throw Exception{"\"preamble_file\" is not allowed in VMs created by clients"};
+                if(description.contains("natives") && !m_remote_install)
+                    throw Exception{"Installing native functions is not enabled on this provider"};
+                vm->remote       = true;
+                vm->num_vms      = per_request ? warm_pool_size + 1 : replicas;
+                vm->num_xstreams = per_request ? 1 : vm->dedicated_xstreams ? replicas : 0;
+                reserve(*vm);
+                reserved = true;
+            }
+
+            // gives the i-th replica its own execution stream if requested
+            auto place = [&](std::shared_ptr<Backend> backend, size_t i) -> std::shared_ptr<Backend> {
+                if(!backend || !vm->dedicated_xstreams) return backend;
+                int cpu = vm->cpus.empty() ? -1 : vm->cpus[i % vm->cpus.size()];
+                return std::make_shared<DedicatedBackend>(std::move(backend), cpu);
+            };
+
+            // all the replicas are created from the same configuration
+            // (or the same source VM) so that they start from the same state
+            auto make = [&](size_t i) {
+                std::shared_ptr<Backend> backend;
+                if(source) backend = source->backend->clone(get_engine());
+                else backend = VmFactory::createVm(vm_type, get_engine(), vm_config);
+                return place(std::move(backend), i);
+            };
+
+            vm->backend = make(0);
+            if(!vm->backend)
+                throw Exception{"Unknown vm type "s + vm_type};
+            if(replicas > 1 || !read_only.empty()) {
+                std::vector<std::shared_ptr<Backend>> backends{vm->backend};
+                for(size_t i = 1; i < replicas; ++i)
+                    backends.push_back(make(i));
+                vm->replicated = std::make_shared<ReplicatedBackend>(
+                    std::move(backends), std::move(read_only), get_engine());
+                vm->backend = vm->replicated;
+            } else if(per_request) {
+                // the VM created above is the prototype of those running the requests
+                vm->warm_pool = std::make_shared<WarmPoolBackend>(
+                    std::move(vm->backend), get_engine(), warm_pool_size);
+                vm->backend = vm->warm_pool;
+            }
+            // requests to VMs with per-request isolation don't wait on each other
+            size_t concurrency = 1;
+            if(vm->replicated) concurrency = vm->replicated->numReplicas();
+            if(vm->warm_pool)  concurrency = std::max<size_t>(warm_pool_size, 1);
+            if(!m_scheduler_config.is_null())
+                vm->scheduler.configure(m_scheduler_config, concurrency);
+            if(source) {
+                std::unique_lock<tl::mutex> lock{m_vms_mtx};
+                auto natives = source->natives;
+                lock.unlock();
+                installNatives(*vm, natives);
+            }
+            if(description.contains("natives"))
+                installNatives(*vm, description["natives"]);
         } catch(const std::exception& ex) {
+            if(reserved) release(*vm);
             result.success() = false;
             result.error() = ex.what();
             error("Error when creating vm of type {}: {}",
@@ -120,75 +578,371 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
             return result;
         }
 
-        if(not m_backend) {
+        {
+            std::unique_lock<tl::mutex> lock{m_vms_mtx};
+            if(!m_vms.emplace(name, vm).second) {
+                lock.unlock();
+                if(reserved) release(*vm);
+                vm->backend->destroy();
+                result.success() = false;
+                result.error() = "A VM named \""s + name + "\" already exists";
+                return result;
+            }
+        }
+
+        trace("Successfully created vm of type {}", vm_type);
+        return result;
+    }
+
+    /**
+     * @brief Reserve the VMs and execution streams used by a VM created
+     * by a client, throwing if that would exceed the limits of the
+     * "remote_vms" configuration.
+     */
+    void reserve(const Vm& vm) {
+        std::unique_lock<tl::mutex> lock{m_vms_mtx};
+        if(m_num_remote_vms + vm.num_vms > m_max_remote_vms)
+            throw Exception{"Creating this VM would exceed the maximum number of VMs ("s
+                            + std::to_string(m_max_remote_vms) + ") created by clients"};
+        if(m_num_remote_xstreams + vm.num_xstreams > m_max_remote_xstreams)
+            throw Exception{"Creating this VM would exceed the maximum number of execution streams ("s
+                            + std::to_string(m_max_remote_xstreams) + ") used by VMs created by clients"};
+        m_num_remote_vms      += vm.num_vms;
+        m_num_remote_xstreams += vm.num_xstreams;
+    }
+
+    void release(const Vm& vm) {
+        std::unique_lock<tl::mutex> lock{m_vms_mtx};
+        m_num_remote_vms      -= vm.num_vms;
+        m_num_remote_xstreams -= vm.num_xstreams;
+    }
+
+    /**
+     * @brief Destroy the VM with the specified name. If remote is true
+     * (the request comes from a client) only VMs created by clients
+     * may be destroyed.
+     */
+    Result<bool> destroyVm(const std::string& name, bool remote = false) {
+        Result<bool> result;
+        std::shared_ptr<Vm> vm;
+        {
+            std::unique_lock<tl::mutex> lock{m_vms_mtx};
+            auto it = m_vms.find(name);
+            if(it != m_vms.end() && (!remote || it->second->remote)) {
+                vm = std::move(it->second);
+                m_vms.erase(it);
+            } else if(it != m_vms.end()) {
+                result.success() = false;
+                result.error() = "VM \""s + name + "\" was not created by a client and can't be destroyed";
+                return result;
+            }
+        }
+        if(!vm) {
             result.success() = false;
-            result.error() = "Unknown vm type "s + vm_type;
-            error("Unknown vm type {}", vm_type);
+            result.error() = noSuchVm(name);
             return result;
         }
+        if(vm->remote) release(*vm);
+        // requests already using the VM keep it alive until they complete
+        result = vm->backend->destroy();
+        trace("Destroyed vm {}", name);
+        return result;
+    }
 
-        trace("Successfully created vm of type {}", vm_type);
+    void installNatives(Vm& vm, const json& natives) {
+        for(auto& native : natives) {
+            if(!native.is_object()
+            || !native.contains("library") || !native["library"].is_string()
+            || !native.contains("symbol")  || !native["symbol"].is_string()
+            || !native.contains("nargs")   || !native["nargs"].is_number_unsigned())
+                throw Exception{"Invalid entry in \"natives\" field of provider configuration"};
+            auto& library = native["library"].get_ref<const std::string&>();
+            auto& symbol  = native["symbol"].get_ref<const std::string&>();
+            auto name     = native.value("name", symbol);
+            auto nargs    = native["nargs"].get<size_t>();
+            auto result   = installNative(vm, library, symbol, name, nargs);
+            result.check();
+        }
+    }
+
+    Result<bool> installNative(const std::string& vm_name,
+                               const std::string& library,
+                               const std::string& symbol,
+                               const std::string& name,
+                               size_t nargs) {
+        auto vm = findVm(vm_name);
+        if(!vm) {
+            Result<bool> result;
+            result.success() = false;
+            result.error() = noSuchVm(vm_name);
+            return result;
+        }
+        return installNative(*vm, library, symbol, name, nargs);
+    }
+
+    Result<bool> installNative(Vm& vm,
+                               const std::string& library,
+                               const std::string& symbol,
+                               const std::string& name,
+                               size_t nargs) {
+
+        Result<bool> result;
+
+        std::string resolved;
+        try {
+            resolved = checkLibrary(library);
+        } catch(const Exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            error("{}", result.error());
+            return result;
+        }
+
+        void* handle = dlopen(resolved.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if(!handle) {
+            result.success() = false;
+            result.error() = "Could not load library "s + library + ": " + dlerror();
+            error("{}", result.error());
+            return result;
+        }
+
+        auto fn = reinterpret_cast<Backend::NativeFn>(dlsym(handle, symbol.c_str()));
+        if(!fn) {
+            result.success() = false;
+            result.error() = "Could not find symbol "s + symbol + " in " + library;
+            error("{}", result.error());
+            dlclose(handle);
+            return result;
+        }
+
+        result = vm.backend->install(name, fn, nargs);
+        if(!result.success()) {
+            error("Could not install native function {}: {}", name, result.error());
+            dlclose(handle);
+            return result;
+        }
+
+        std::unique_lock<tl::mutex> lock{m_vms_mtx};
+        m_libraries.push_back(handle);
+        vm.natives.push_back(json{
+            {"library", library},
+            {"symbol", symbol},
+            {"name", name},
+            {"nargs", nargs}
+        });
+        lock.unlock();
+        trace("Successfully installed native function {} from {}", name, library);
         return result;
     }
 
+    template<typename ResultType>
+    bool admit(AdmissionControl::Permit& permit,
+               std::string_view code,
+               const std::vector<json>& args,
+               ResultType& result) {
+        if(m_admission.admit(permit, code, args))
+            return true;
+        result.success()   = false;
+        result.retryable() = true;
+        result.error()     = "Provider is overloaded, try again later";
+        return false;
+    }
+
+    template<typename ResultType>
+    bool schedule(Vm& vm,
+                  Scheduler::Ticket& ticket,
+                  const std::string& priority_class,
+                  std::string_view function,
+                  const ExecutionContext& context,
+                  ResultType& result) {
+        try {
+            ticket = vm.scheduler.schedule(priority_class, function, context);
+        } catch(const Exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            return false;
+        }
+        // the request may have been cancelled, or its deadline
+        // may have passed, while it was queued
+        if(context.interrupted()) {
+            result.success() = false;
+            result.error() = context.reason();
+            return false;
+        }
+        return true;
+    }
+
     void executeRPC(const tl::request& req,
+                    const std::string& vm_name,
                     const std::string& code,
-                    std::vector<JsonWrapper>& jargs) {
+                    std::vector<JsonWrapper>& jargs,
+                    const std::string& priority_class,
+                    uint64_t timeout_ms,
+                    uint64_t request_id) {
         trace("Received execute request");
+        ExecutionContext context{std::chrono::milliseconds{timeout_ms}, request_id != 0};
+        TrackedRequest tracked{*this, request_id, context};
         std::vector<json> args{
             std::move(jargs).begin(),
             std::move(jargs).end()
         };
         Result<JsonWrapper> result;
         tl::auto_respond<decltype(result)> response{req, result};
-        if(!m_backend) {
+        AdmissionControl::Permit permit;
+        Scheduler::Ticket ticket;
+        auto vm = findVm(vm_name);
+        if(!vm) {
             result.success() = false;
-            result.error() = "Provider has no VM attached";
-        } else {
-            result = m_backend->execute(code, args);
+            result.error() = noSuchVm(vm_name);
+        } else if(admit(permit, code, args, result)
+               && schedule(*vm, ticket, priority_class, "", context, result)) {
+            result = vm->backend->execute(code, args, context);
         }
         trace("Successfully executed execute RPC");
     }
 
     void loadRPC(const tl::request& req,
+                 const std::string& vm_name,
                  const std::string& filename,
-                 std::vector<JsonWrapper>& jargs) {
+                 std::vector<JsonWrapper>& jargs,
+                 const std::string& priority_class,
+                 uint64_t timeout_ms,
+                 uint64_t request_id) {
         trace("Received load request");
+        ExecutionContext context{std::chrono::milliseconds{timeout_ms}, request_id != 0};
+        TrackedRequest tracked{*this, request_id, context};
         std::vector<json> args{
             std::move(jargs).begin(),
             std::move(jargs).end()
         };
         Result<JsonWrapper> result;
         tl::auto_respond<decltype(result)> response{req, result};
-        if(!m_backend) {
+        AdmissionControl::Permit permit;
+        Scheduler::Ticket ticket;
+        auto vm = findVm(vm_name);
+        if(!vm) {
             result.success() = false;
-            result.error() = "Provider has no VM attached";
-        } else {
-            result = m_backend->load(filename, args);
+            result.error() = noSuchVm(vm_name);
+        } else if(admit(permit, filename, args, result)
+               && schedule(*vm, ticket, priority_class, "", context, result)) {
+            result = vm->backend->load(filename, args, context);
         }
         trace("Successfully executed load RPC");
     }
 
     void callRPC(const tl::request& req,
+                 const std::string& vm_name,
                  const std::string& function,
                  const std::string& target,
-                 std::vector<JsonWrapper>& jargs) {
+                 std::vector<JsonWrapper>& jargs,
+                 bool read_only,
+                 const std::string& priority_class,
+                 uint64_t timeout_ms,
+                 uint64_t request_id) {
         trace("Received call request");
+        ExecutionContext context{std::chrono::milliseconds{timeout_ms}, request_id != 0};
+        TrackedRequest tracked{*this, request_id, context};
         std::vector<json> args{
             std::move(jargs).begin(),
             std::move(jargs).end()
         };
         Result<JsonWrapper> result;
         tl::auto_respond<decltype(result)> response{req, result};
-        if(!m_backend) {
+        AdmissionControl::Permit permit;
+        Scheduler::Ticket ticket;
+        auto vm = findVm(vm_name);
+        if(!vm) {
             result.success() = false;
-            result.error() = "Provider has no VM attached";
+            result.error() = noSuchVm(vm_name);
+        } else if(!admit(permit, function, args, result)
+               || !schedule(*vm, ticket, priority_class, function, context, result)) {
+            // request rejected by the admission control or the scheduler
+        } else if(read_only && vm->replicated) {
+            result = vm->replicated->callReadOnly(function, target, args, context);
         } else {
-            result = m_backend->call(function, target, args);
+            result = vm->backend->call(function, target, args, context);
         }
         trace("Successfully executed call RPC");
     }
 
+    void installRPC(const tl::request& req,
+                    const std::string& vm_name,
+                    const std::string& library,
+                    const std::string& symbol,
+                    const std::string& name,
+                    size_t nargs) {
+        trace("Received install request");
+        Result<bool> result;
+        tl::auto_respond<decltype(result)> response{req, result};
+        if(!m_remote_install) {
+            result.success() = false;
+            result.error() = "Installing native functions is not enabled on this provider";
+            return;
+        }
+        result = installNative(vm_name, library, symbol, name, nargs);
+        trace("Successfully executed install RPC");
+    }
+
+    void createVmRPC(const tl::request& req,
+                     const std::string& vm_name,
+                     const std::string& description) {
+        trace("Received create_vm request");
+        Result<bool> result;
+        tl::auto_respond<decltype(result)> response{req, result};
+        if(!m_remote_vms) {
+            result.success() = false;
+            result.error() = "Creating VMs is not enabled on this provider";
+            return;
+        }
+        json json_description;
+        try {
+            json_description = json::parse(description);
+        } catch(json::parse_error& e) {
+            result.success() = false;
+            result.error() = "Could not parse VM configuration: "s + e.what();
+            return;
+        }
+        result = createVm(vm_name, json_description, true);
+        trace("Successfully executed create_vm RPC");
+    }
+
+    void destroyVmRPC(const tl::request& req,
+                      const std::string& vm_name) {
+        trace("Received destroy_vm request");
+        Result<bool> result;
+        tl::auto_respond<decltype(result)> response{req, result};
+        result = destroyVm(vm_name, true);
+        trace("Successfully executed destroy_vm RPC");
+    }
+
+    void cancelRPC(const tl::request& req,
+                   uint64_t request_id) {
+        trace("Received cancel request");
+        Result<bool> result;
+        tl::auto_respond<decltype(result)> response{req, result};
+        {
+            std::unique_lock<tl::mutex> lock{m_requests_mtx};
+            auto it = m_requests.find(request_id);
+            if(it != m_requests.end()) {
+                it->second->cancel();
+            } else if(m_early_cancels.insert(request_id).second) {
+                // the request may not have been received yet, or may
+                // have completed already, in which case its id is
+                // eventually forgotten
+                m_early_cancels_order.push_back(request_id);
+                if(m_early_cancels_order.size() > s_max_early_cancels) {
+                    m_early_cancels.erase(m_early_cancels_order.front());
+                    m_early_cancels_order.pop_front();
+                }
+            }
+        }
+        std::unique_lock<tl::mutex> lock{m_vms_mtx};
+        for(auto& [name, vm] : m_vms)
+            vm->scheduler.notifyCancelled();
+        lock.unlock();
+        trace("Successfully executed cancel RPC");
+    }
+
 };
 
 }
@@ -0,0 +1,108 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "poesie/Exception.hpp"
+#include "RegistrationCache.hpp"
+
+namespace poesie {
+
+void RegistrationCache::configure(const nlohmann::json& config) {
+    if(!config.is_object())
+        throw Exception{"RegistrationCache configuration should be an object"};
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    if(config.contains("capacity")) {
+        if(!config["capacity"].is_number_unsigned())
+            throw Exception{"\"capacity\" should be a positive integer"};
+        m_capacity = config["capacity"].get<size_t>();
+    }
+    evict();
+}
+
+nlohmann::json RegistrationCache::getConfig() const {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    return nlohmann::json{
+        {"capacity", m_capacity}
+    };
+}
+
+nlohmann::json RegistrationCache::getStatistics() const {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    auto total = m_hits + m_misses;
+    return nlohmann::json{
+        {"size", m_entries.size()},
+        {"in_use", m_entries.size() - m_unused.size()},
+        {"hits", m_hits},
+        {"misses", m_misses},
+        {"evictions", m_evictions},
+        {"hit_rate", total ? (double)m_hits/total : 0.0}
+    };
+}
+
+RegistrationCache::Key RegistrationCache::makeKey(const Registration& registration) {
+    return Key{reinterpret_cast<uintptr_t>(registration.data),
+               registration.size,
+               static_cast<int>(registration.mode)};
+}
+
+bool RegistrationCache::acquire(const tl::engine& engine, Registration& registration) {
+    auto key = makeKey(registration);
+    {
+        std::unique_lock<tl::mutex> lock{m_mtx};
+        if(m_capacity == 0) return false;
+        auto it = m_entries.find(key);
+        if(it != m_entries.end()) {
+            auto& entry = it->second;
+            if(entry.refcount++ == 0) m_unused.erase(entry.unused);
+            registration.bulk = entry.bulk;
+            m_hits += 1;
+            return true;
+        }
+        m_misses += 1;
+    }
+    // register the buffer outside of the lock
+    auto bulk = engine.expose({{registration.data, registration.size}}, registration.mode);
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    auto& entry = m_entries[key];
+    if(entry.bulk.is_null()) {
+        entry.bulk = std::move(bulk);
+    } else if(entry.refcount == 0) {
+        // registered concurrently by another caller
+        m_unused.erase(entry.unused);
+    }
+    entry.refcount += 1;
+    registration.bulk = entry.bulk;
+    evict();
+    return true;
+}
+
+void RegistrationCache::release(const Registration& registration) {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    auto it = m_entries.find(makeKey(registration));
+    // the entry may have been dropped by clear
+    if(it == m_entries.end()
+    || it->second.bulk.get_bulk() != registration.bulk.get_bulk()) return;
+    auto& entry = it->second;
+    if(--entry.refcount == 0) {
+        m_unused.push_front(it->first);
+        entry.unused = m_unused.begin();
+        evict();
+    }
+}
+
+void RegistrationCache::evict() {
+    while(m_entries.size() > m_capacity && !m_unused.empty()) {
+        m_entries.erase(m_unused.back());
+        m_unused.pop_back();
+        m_evictions += 1;
+    }
+}
+
+void RegistrationCache::clear() {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    m_entries.clear();
+    m_unused.clear();
+}
+
+}
@@ -0,0 +1,128 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __POESIE_REGISTRATION_CACHE_H
+#define __POESIE_REGISTRATION_CACHE_H
+
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+#include <unordered_map>
+#include <cstdint>
+#include <list>
+
+namespace poesie {
+
+namespace tl = thallium;
+
+/**
+ * @brief The RegistrationCache keeps the bulk handles exposing client
+ * buffers, keyed by address, size, and mode, so that a buffer passed in
+ * many consecutive calls is only registered once. Registrations are
+ * reference-counted by the MemoryViews using them; at most "capacity"
+ * registrations are kept (0, the default, disables the cache), the least
+ * recently used unused ones being released first. Registrations still in use are never
+ * released. A single RegistrationCache is shared by all the MemoryViews
+ * using a given engine (see MemoryViewContext). Clients enable it with
+ * Client::setRegistrationCacheCapacity, providers with the "memory_views"
+ * entry of their configuration.
+ *
+ * Note that a registration is looked up by address: a buffer freed and
+ * reallocated at the same address with the same size reuses the previous
+ * registration, which is only correct if the transport does not pin the
+ * physical pages. Disable the cache if this is the case.
+ */
+class RegistrationCache {
+
+    public:
+
+    struct Registration {
+        void*         data = nullptr;
+        size_t        size = 0;
+        tl::bulk_mode mode = tl::bulk_mode::read_write;
+        tl::bulk      bulk;
+    };
+
+    RegistrationCache() = default;
+
+    /**
+     * @brief Change the configuration of the cache.
+     * Unused registrations are released.
+     */
+    void configure(const nlohmann::json& config);
+
+    /**
+     * @brief Get the configuration of the cache.
+     */
+    nlohmann::json getConfig() const;
+
+    /**
+     * @brief Get the usage statistics of the cache.
+     */
+    nlohmann::json getStatistics() const;
+
+    /**
+     * @brief Set the bulk handle of the registration for its data, size,
+     * and mode, exposing the buffer with the provided engine if it is not
+     * already registered. Returns false if the cache is disabled, in which
+     * case the caller should expose the buffer itself. Registrations
+     * obtained from acquire must be given back with release.
+     */
+    bool acquire(const tl::engine& engine, Registration& registration);
+
+    /**
+     * @brief Give back a registration obtained from acquire.
+     */
+    void release(const Registration& registration);
+
+    /**
+     * @brief Drop all the registrations. Registrations in use are
+     * released when their last MemoryView is destroyed.
+     */
+    void clear();
+
+    private:
+
+    struct Key {
+        uintptr_t address;
+        size_t    size;
+        int       mode;
+
+        bool operator==(const Key& other) const {
+            return address == other.address
+                && size == other.size
+                && mode == other.mode;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            auto h = std::hash<uintptr_t>{}(key.address);
+            h ^= std::hash<size_t>{}(key.size) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            return h ^ static_cast<size_t>(key.mode);
+        }
+    };
+
+    struct Entry {
+        tl::bulk                  bulk;
+        size_t                    refcount = 0;
+        std::list<Key>::iterator  unused; // valid if refcount == 0
+    };
+
+    static Key makeKey(const Registration& registration);
+    void evict();
+
+    mutable tl::mutex                          m_mtx;
+    size_t                                     m_capacity = 0;
+    std::unordered_map<Key, Entry, KeyHash>    m_entries;
+    std::list<Key>                             m_unused; // most recent first
+    // statistics
+    size_t m_hits      = 0;
+    size_t m_misses    = 0;
+    size_t m_evictions = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,274 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "poesie/Exception.hpp"
+#include "poesie/MemoryView.hpp"
+#include "ReplicatedBackend.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <string>
+
+namespace poesie {
+
+using json = nlohmann::json;
+
+namespace {
+
+const Backend& primaryOf(const std::vector<std::shared_ptr<Backend>>& replicas) {
+    if(replicas.empty() || !replicas[0])
+        throw Exception{"ReplicatedBackend needs a primary VM"};
+    return *replicas[0];
+}
+
+struct ReadLock {
+    tl::rwlock& lock;
+    ReadLock(tl::rwlock& l) : lock(l) { lock.rdlock(); }
+    ~ReadLock() { lock.unlock(); }
+};
+
+struct WriteLock {
+    tl::rwlock& lock;
+    WriteLock(tl::rwlock& l) : lock(l) { lock.wrlock(); }
+    ~WriteLock() { lock.unlock(); }
+};
+
+bool containsViews(const json& j) {
+    if(MemoryView::IsMemoryView(j)) return true;
+    if(j.is_array() || j.is_object()) {
+        for(auto& item : j)
+            if(containsViews(item)) return true;
+    }
+    return false;
+}
+
+// copy of j in which the MemoryViews are replaced by the result of
+// f(view), visiting the views in the same order on every call
+template<typename F>
+json replaceViews(const json& j, F&& f) {
+    if(MemoryView::IsMemoryView(j)) return f(j);
+    if(j.is_array()) {
+        auto result = json::array();
+        for(auto& item : j) result.push_back(replaceViews(item, f));
+        return result;
+    }
+    if(j.is_object()) {
+        auto result = json::object();
+        for(auto& [key, item] : j.items()) result[key] = replaceViews(item, f);
+        return result;
+    }
+    return j;
+}
+
+// content of a MemoryView passed to a mutating operation,
+// as received before the primary runs the operation
+struct ViewContent {
+    MemoryView::Intent intent;
+    std::string        data;
+};
+
+}
+
+ReplicatedBackend::ReplicatedBackend(
+        std::vector<std::shared_ptr<Backend>> replicas,
+        std::unordered_set<std::string> read_only,
+        const tl::engine& engine)
+: Backend(primaryOf(replicas)) // copies the name of the backend type
+, m_engine(engine)
+, m_read_only(std::move(read_only)) {
+    for(auto& replica : replicas) {
+        if(!replica) throw Exception{"Invalid VM passed to ReplicatedBackend"};
+        m_replicas.push_back(std::make_unique<Replica>(std::move(replica)));
+    }
+}
+
+template<typename Operation>
+auto ReplicatedBackend::replicate(const std::vector<json>& args,
+                                  const ExecutionContext& context,
+                                  Operation&& op) {
+    WriteLock lock{m_lock};
+    using ResultType = decltype(op(*m_replicas[0]->backend, args, context));
+    // with replicas, the operation runs without constraints once started
+    // (the replicas couldn't replay an operation interrupted halfway),
+    // so the request may only be interrupted while waiting for the lock
+    bool replicated = m_replicas.size() > 1;
+    if(replicated && context.interrupted()) {
+        ResultType result;
+        result.success() = false;
+        result.error() = context.reason();
+        return result;
+    }
+    const ExecutionContext unconstrained;
+    auto& primary_context = replicated ? unconstrained : context;
+    // the MemoryViews are received here, the primary gets views of the
+    // received data (which the remote views send back when destroyed)
+    // and the replicas get views of copies of the original content
+    bool has_views = replicated
+                  && std::any_of(args.begin(), args.end(), containsViews);
+    std::vector<MemoryView>  remote_views, primary_views;
+    std::vector<ViewContent> contents;
+    std::vector<json>        primary_args;
+    if(has_views) {
+        try {
+            for(auto& arg : args) {
+                primary_args.push_back(replaceViews(arg, [&](const json& j) -> json {
+                    auto& remote = remote_views.emplace_back(m_engine, j);
+                    auto intent = remote.intent();
+                    if(remote.size() == 0) {
+                        contents.push_back(ViewContent{intent, {}});
+                        return j;
+                    }
+                    auto data = remote.access(0, remote.size(), intent != MemoryView::Intent::IN);
+                    contents.push_back(ViewContent{intent, std::string{data, remote.size()}});
+                    return primary_views.emplace_back(m_engine, data, remote.size(), intent).toJson();
+                }));
+            }
+        } catch(const std::exception& ex) {
+            ResultType result;
+            result.success() = false;
+            result.error() = ex.what();
+            return result;
+        }
+    }
+    auto result = op(*m_replicas[0]->backend, has_views ? primary_args : args, primary_context);
+    primary_views.clear();
+    for(size_t i = 1; i < m_replicas.size(); ++i) {
+        auto& replica = *m_replicas[i];
+        if(replica.diverged) continue;
+        std::vector<ViewContent> copies;
+        std::vector<MemoryView>  replica_views;
+        std::vector<json>        replica_args;
+        if(has_views) {
+            copies = contents;
+            size_t k = 0;
+            for(auto& arg : args) {
+                replica_args.push_back(replaceViews(arg, [&](const json& j) -> json {
+                    auto& copy = copies[k++];
+                    if(copy.data.empty()) return j;
+                    return replica_views.emplace_back(
+                        m_engine, copy.data.data(), copy.data.size(), copy.intent).toJson();
+                }));
+            }
+        }
+        auto replayed = op(*replica.backend, has_views ? replica_args : args, unconstrained);
+        if(replayed.success() != result.success()) {
+            spdlog::warn("[poesie] Replica {} diverged from the primary VM"
+                         " and will no longer be used", i);
+            replica.diverged = true;
+        }
+    }
+    m_writes += 1;
+    return result;
+}
+
+Result<json> ReplicatedBackend::callReadOnly(
+        std::string_view function,
+        std::string_view target,
+        const std::vector<json>& args,
+        const ExecutionContext& context) {
+    ReadLock lock{m_lock};
+    // pick the replica with the fewest pending calls, starting the
+    // search at a different replica each time to break ties
+    auto n     = m_replicas.size();
+    auto start = m_next++ % n;
+    Replica* chosen = nullptr;
+    for(size_t j = 0; j < n; ++j) {
+        auto& replica = *m_replicas[(start + j) % n];
+        if(replica.diverged) continue;
+        if(!chosen || replica.pending < chosen->pending)
+            chosen = &replica;
+        if(chosen->pending == 0) break;
+    }
+    chosen->pending += 1; // the primary never diverges, so chosen isn't null
+    chosen->reads += 1;
+    struct Pending {
+        Replica* replica;
+        ~Pending() { replica->pending -= 1; }
+    } pending{chosen};
+    return chosen->backend->call(function, target, args, context);
+}
+
+json ReplicatedBackend::getStatistics() const {
+    auto replicas = json::array();
+    for(auto& replica : m_replicas) {
+        replicas.push_back(json{
+            {"reads", replica->reads.load()},
+            {"pending", replica->pending.load()},
+            {"diverged", replica->diverged.load()}
+        });
+    }
+    return json{
+        {"writes", m_writes.load()},
+        {"replicas", std::move(replicas)}
+    };
+}
+
+std::string ReplicatedBackend::getConfig() const {
+    return m_replicas[0]->backend->getConfig();
+}
+
+Result<json> ReplicatedBackend::execute(std::string_view code,
+                                        const std::vector<json>& args,
+                                        const ExecutionContext& context) {
+    return replicate(args, context,
+        [&](Backend& vm, const std::vector<json>& a, const ExecutionContext& ctx) {
+            return vm.execute(code, a, ctx);
+        });
+}
+
+Result<json> ReplicatedBackend::load(std::string_view filename,
+                                     const std::vector<json>& args,
+                                     const ExecutionContext& context) {
+    return replicate(args, context,
+        [&](Backend& vm, const std::vector<json>& a, const ExecutionContext& ctx) {
+            return vm.load(filename, a, ctx);
+        });
+}
+
+Result<json> ReplicatedBackend::call(
+        std::string_view function,
+        std::string_view target,
+        const std::vector<json>& args,
+        const ExecutionContext& context) {
+    auto name = target.empty() ? std::string{function}
+              : std::string{target} + "." + std::string{function};
+    if(m_read_only.count(name))
+        return callReadOnly(function, target, args, context);
+    return replicate(args, context,
+        [&](Backend& vm, const std::vector<json>& a, const ExecutionContext& ctx) {
+            return vm.call(function, target, a, ctx);
+        });
+}
+
+Result<bool> ReplicatedBackend::install(
+        std::string_view name,
+        ForeignFn function,
+        size_t nargs) {
+    return replicate({}, ExecutionContext{},
+        [&](Backend& vm, const std::vector<json>&, const ExecutionContext&) {
+            return vm.install(name, function, nargs);
+        });
+}
+
+Result<bool> ReplicatedBackend::installAsync(
+        std::string_view name,
+        AsyncForeignFn function,
+        size_t nargs) {
+    return replicate({}, ExecutionContext{},
+        [&](Backend& vm, const std::vector<json>&, const ExecutionContext&) {
+            return vm.installAsync(name, function, nargs);
+        });
+}
+
+Result<bool> ReplicatedBackend::destroy() {
+    Result<bool> result;
+    WriteLock lock{m_lock};
+    for(auto& replica : m_replicas) {
+        auto r = replica->backend->destroy();
+        if(!r.success() && result.success()) result = std::move(r);
+    }
+    return result;
+}
+
+}
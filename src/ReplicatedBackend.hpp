@@ -0,0 +1,152 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __POESIE_REPLICATED_BACKEND_H
+#define __POESIE_REPLICATED_BACKEND_H
+
+#include <poesie/Backend.hpp>
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+#include <unordered_set>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+namespace poesie {
+
+namespace tl = thallium;
+
+/**
+ * @brief A ReplicatedBackend spreads the calls that only read the state
+ * of a VM across a set of identical VMs, so that they can run concurrently
+ * instead of being serialized behind the lock of a single VM.
+ *
+ * The first VM is the primary. Operations that may modify the state of the
+ * VMs (execute, load, install, and calls to functions that are not known to
+ * be read-only) run on the primary and are then replayed, in the same order,
+ * on every other replica, while read-only calls are held back. A read-only
+ * call runs on whichever replica has the fewest calls in progress. A replica
+ * whose outcome for a replayed operation differs from the primary's is
+ * considered diverged and stops receiving read-only calls. An operation
+ * interrupted halfway couldn't be replayed identically, so deadlines and
+ * cancellations of mutating operations only apply until they start: once
+ * started, they run to completion on the primary and on the replicas.
+ *
+ * The MemoryViews passed to a mutating operation are transferred once:
+ * their content is received before the primary runs the operation, the
+ * primary works on it in place and the result is sent back to the owner
+ * of OUT and INOUT views, while each replica works on a private copy of
+ * the content received, whose modifications are discarded.
+ *
+ * Functions are read-only either because they are listed in the "read_only"
+ * configuration (as "function", or "target.function" for methods), or
+ * because the client flagged the call as such. It is up to the user to
+ * ensure that such functions don't modify the state of the VM, and that
+ * mutating operations are deterministic.
+ */
+class ReplicatedBackend : public Backend {
+
+    struct Replica {
+        std::shared_ptr<Backend> backend;
+        std::atomic<size_t>      pending  = 0;
+        std::atomic<size_t>      reads    = 0;
+        std::atomic<bool>        diverged = false;
+
+        Replica(std::shared_ptr<Backend> b)
+        : backend(std::move(b)) {}
+    };
+
+    tl::engine                            m_engine;
+    std::vector<std::unique_ptr<Replica>> m_replicas; // primary first
+    std::unordered_set<std::string>       m_read_only;
+    mutable tl::rwlock                    m_lock;
+    std::atomic<size_t>                   m_next   = 0;
+    std::atomic<size_t>                   m_writes = 0;
+
+    template<typename Operation>
+    auto replicate(const std::vector<nlohmann::json>& args,
+                   const ExecutionContext& context,
+                   Operation&& op);
+
+    public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param replicas VMs to use, the first one being the primary.
+     * The VMs must have been created from the same configuration.
+     * @param read_only Names of the functions known to be read-only.
+     * @param engine Thallium engine.
+     */
+    ReplicatedBackend(std::vector<std::shared_ptr<Backend>> replicas,
+                      std::unordered_set<std::string> read_only,
+                      const tl::engine& engine);
+
+    /**
+     * @brief Invoke the designated function or method on any replica,
+     * without replaying it on the others.
+     */
+    Result<nlohmann::json> callReadOnly(
+            std::string_view function,
+            std::string_view target,
+            const std::vector<nlohmann::json>& args,
+            const ExecutionContext& context = ExecutionContext{});
+
+    /**
+     * @brief Number of replicas (including the primary).
+     */
+    size_t numReplicas() const {
+        return m_replicas.size();
+    }
+
+    /**
+     * @brief Names of the functions known to be read-only.
+     */
+    const std::unordered_set<std::string>& readOnlyFunctions() const {
+        return m_read_only;
+    }
+
+    /**
+     * @brief Get the usage statistics of the replicas.
+     */
+    nlohmann::json getStatistics() const;
+
+    std::string getConfig() const override;
+
+    using Backend::execute;
+    using Backend::load;
+    using Backend::call;
+
+    Result<nlohmann::json> execute(std::string_view code,
+                                   const std::vector<nlohmann::json>& args,
+                                   const ExecutionContext& context) override;
+
+    Result<nlohmann::json> load(std::string_view filename,
+                                const std::vector<nlohmann::json>& args,
+                                const ExecutionContext& context) override;
+
+    Result<nlohmann::json> call(
+            std::string_view function,
+            std::string_view target,
+            const std::vector<nlohmann::json>& args,
+            const ExecutionContext& context) override;
+
+    Result<bool> install(
+            std::string_view name,
+            ForeignFn function,
+            size_t nargs) override;
+
+    Result<bool> installAsync(
+            std::string_view name,
+            AsyncForeignFn function,
+            size_t nargs) override;
+
+    Result<bool> destroy() override;
+};
+
+}
+
+#endif
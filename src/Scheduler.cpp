@@ -0,0 +1,214 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "poesie/Exception.hpp"
+#include "Scheduler.hpp"
+#include <algorithm>
+#include <ctime>
+
+namespace poesie {
+
+using json = nlohmann::json;
+
+void Scheduler::configure(const json& config, size_t replicas) {
+    if(!config.is_object())
+        throw Exception{"Scheduler configuration should be an object"};
+    std::map<std::string, Class> classes;
+    if(config.contains("classes")) {
+        if(!config["classes"].is_object() || config["classes"].empty())
+            throw Exception{"\"classes\" should be a non-empty object"};
+        for(auto& [name, cls] : config["classes"].items()) {
+            if(!cls.is_object())
+                throw Exception{"Priority class \"" + name + "\" should be an object"};
+            auto& c = classes[name];
+            if(cls.contains("weight")) {
+                if(!cls["weight"].is_number() || cls["weight"].get<double>() <= 0.0)
+                    throw Exception{"\"weight\" of priority class \"" + name + "\" should be a positive number"};
+                c.weight = cls["weight"].get<double>();
+            }
+        }
+    } else {
+        classes["default"];
+    }
+    std::string default_class = classes.begin()->first;
+    if(config.contains("default_class")) {
+        if(!config["default_class"].is_string()
+        || !classes.count(config["default_class"].get<std::string>()))
+            throw Exception{"\"default_class\" should be the name of a priority class"};
+        default_class = config["default_class"].get<std::string>();
+    }
+    std::unordered_map<std::string, std::string> rules;
+    if(config.contains("rules")) {
+        if(!config["rules"].is_object())
+            throw Exception{"\"rules\" should be an object"};
+        for(auto& [function, cls] : config["rules"].items()) {
+            if(!cls.is_string() || !classes.count(cls.get<std::string>()))
+                throw Exception{"Rule for \"" + function + "\" should name a priority class"};
+            rules[function] = cls.get<std::string>();
+        }
+    }
+    size_t concurrency = std::max<size_t>(replicas, 1);
+    if(config.contains("concurrency")) {
+        if(!config["concurrency"].is_number_unsigned() || config["concurrency"].get<size_t>() == 0)
+            throw Exception{"\"concurrency\" should be a strictly positive integer"};
+        concurrency = config["concurrency"].get<size_t>();
+    }
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    if(m_running != 0)
+        throw Exception{"Cannot reconfigure a scheduler with running requests"};
+    m_classes       = std::move(classes);
+    m_rules         = std::move(rules);
+    m_default_class = std::move(default_class);
+    m_concurrency   = concurrency;
+    m_vtime         = 0.0;
+    m_enabled       = true;
+}
+
+json Scheduler::getConfig() const {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    auto classes = json::object();
+    for(auto& [name, cls] : m_classes)
+        classes[name] = json{{"weight", cls.weight}};
+    return json{
+        {"concurrency", m_concurrency},
+        {"classes", std::move(classes)},
+        {"default_class", m_default_class},
+        {"rules", m_rules}
+    };
+}
+
+json Scheduler::getStatistics() const {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    auto stats = json::object();
+    for(auto& [name, cls] : m_classes) {
+        stats[name] = json{
+            {"queued", cls.queue.size()},
+            {"running", cls.running},
+            {"completed", cls.completed},
+            {"avg_wait", cls.completed ? cls.total_wait/cls.completed : 0.0},
+            {"max_wait", cls.max_wait},
+            {"avg_latency", cls.completed ? cls.total_latency/cls.completed : 0.0},
+            {"max_latency", cls.max_latency}
+        };
+    }
+    return stats;
+}
+
+Scheduler::Ticket Scheduler::schedule(std::string_view requested_class,
+                                      std::string_view function,
+                                      const ExecutionContext& context) {
+    Ticket ticket;
+    if(!m_enabled) return ticket;
+    ticket.m_queued = Clock::now();
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    auto name = std::string{requested_class};
+    if(name.empty()) {
+        auto rule = m_rules.find(std::string{function});
+        name = rule != m_rules.end() ? rule->second : m_default_class;
+    }
+    auto it = m_classes.find(name);
+    if(it == m_classes.end())
+        throw Exception{"Unknown priority class \"" + name + "\""};
+    auto& cls = it->second;
+    // a class that was idle starts from the current virtual time
+    // instead of using the share it didn't use while idle
+    if(cls.queue.empty() && cls.running == 0)
+        cls.pass = std::max(cls.pass, m_vtime);
+    bool granted = false;
+    cls.queue.push_back(&granted);
+    dispatch();
+    while(!granted && !context.interrupted()) {
+        if(context.deadline() == ExecutionContext::Clock::time_point::max()) {
+            m_cv.wait(lock);
+            continue;
+        }
+        // condition variables take an absolute time of the system clock,
+        // waiting at most an hour at a time keeps it from overflowing
+        // for distant deadlines (the loop waits again if needed)
+        auto remaining = std::min<ExecutionContext::Clock::duration>(
+            context.deadline() - ExecutionContext::Clock::now(), std::chrono::hours{1});
+        auto abstime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            (std::chrono::system_clock::now() + remaining).time_since_epoch()).count();
+        struct timespec ts;
+        ts.tv_sec  = abstime / 1000000000;
+        ts.tv_nsec = abstime % 1000000000;
+        m_cv.wait_until(lock, &ts);
+    }
+    if(!granted) {
+        auto& queue = cls.queue;
+        queue.erase(std::find(queue.begin(), queue.end(), &granted));
+        return ticket;
+    }
+    ticket.m_scheduler = this;
+    ticket.m_class     = &cls;
+    ticket.m_started   = Clock::now();
+    return ticket;
+}
+
+void Scheduler::dispatch() {
+    bool granted = false;
+    while(m_running < m_concurrency) {
+        Class* next = nullptr;
+        for(auto& [name, cls] : m_classes) {
+            if(cls.queue.empty()) continue;
+            if(!next || cls.pass < next->pass) next = &cls;
+        }
+        if(!next) break;
+        *next->queue.front() = true;
+        next->queue.pop_front();
+        next->running += 1;
+        m_running += 1;
+        m_vtime = next->pass;
+        next->pass += 1.0/next->weight;
+        granted = true;
+    }
+    if(granted) m_cv.notify_all();
+}
+
+void Scheduler::notifyCancelled() {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    m_cv.notify_all();
+}
+
+void Scheduler::release(Ticket& ticket) {
+    auto now     = Clock::now();
+    auto wait    = std::chrono::duration<double>(ticket.m_started - ticket.m_queued).count();
+    auto latency = std::chrono::duration<double>(now - ticket.m_queued).count();
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    auto& cls = *ticket.m_class;
+    cls.running   -= 1;
+    cls.completed += 1;
+    cls.total_wait    += wait;
+    cls.max_wait       = std::max(cls.max_wait, wait);
+    cls.total_latency += latency;
+    cls.max_latency    = std::max(cls.max_latency, latency);
+    m_running -= 1;
+    dispatch();
+}
+
+Scheduler::Ticket::Ticket(Ticket&& other)
+: m_scheduler(other.m_scheduler)
+, m_class(other.m_class)
+, m_queued(other.m_queued)
+, m_started(other.m_started) {
+    other.m_scheduler = nullptr;
+}
+
+Scheduler::Ticket& Scheduler::Ticket::operator=(Ticket&& other) {
+    if(this == &other) return *this;
+    if(m_scheduler) m_scheduler->release(*this);
+    m_scheduler = other.m_scheduler;
+    m_class     = other.m_class;
+    m_queued    = other.m_queued;
+    m_started   = other.m_started;
+    other.m_scheduler = nullptr;
+    return *this;
+}
+
+Scheduler::Ticket::~Ticket() {
+    if(m_scheduler) m_scheduler->release(*this);
+}
+
+}
@@ -0,0 +1,160 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __POESIE_SCHEDULER_H
+#define __POESIE_SCHEDULER_H
+
+#include <poesie/Backend.hpp>
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+#include <unordered_map>
+#include <string_view>
+#include <string>
+#include <chrono>
+#include <deque>
+#include <map>
+
+namespace poesie {
+
+namespace tl = thallium;
+
+/**
+ * @brief The Scheduler decides in which order the requests waiting for
+ * the VM get to run, using weighted fair queuing between priority classes.
+ * It is configured through the "scheduler" entry of the provider's
+ * configuration:
+ *
+ * {
+ *    "concurrency": 1,
+ *    "classes": {
+ *        "interactive": { "weight": 4 },
+ *        "batch": { "weight": 1 }
+ *    },
+ *    "default_class": "batch",
+ *    "rules": {
+ *        "get_status": "interactive"
+ *    }
+ * }
+ *
+ * Each request is put in the queue of its class, which is the class
+ * requested by the client (see VmHandle::setPriorityClass) if any, or
+ * the class associated with the called function in "rules", or the
+ * default class. At most "concurrency" requests run at a time (by default
+ * one per VM replica). When a request completes, the next one is taken
+ * from the non-empty queue that has so far received the smallest share
+ * of the VM relative to its weight, so that a class of weight 4 gets
+ * four times as many requests through as a class of weight 1 when both
+ * are backlogged. Classes that are idle don't accumulate credit.
+ * Requests cancelled, or whose deadline passes, while queued leave the
+ * queue without running.
+ *
+ * Without a "scheduler" entry, requests are not queued by the provider
+ * and contend directly for the VM.
+ */
+class Scheduler {
+
+    struct Class {
+        double weight = 1.0;
+        double pass   = 0.0; // virtual time of the class
+        std::deque<bool*> queue;
+        size_t running = 0;
+        // statistics, in seconds
+        size_t completed     = 0;
+        double total_wait    = 0.0;
+        double max_wait      = 0.0;
+        double total_latency = 0.0;
+        double max_latency   = 0.0;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    public:
+
+    /**
+     * @brief A Ticket grants its owner the right to run a request.
+     * The next request is scheduled when the Ticket is destroyed.
+     */
+    class Ticket {
+
+        friend class Scheduler;
+
+        Scheduler*        m_scheduler = nullptr;
+        Class*            m_class     = nullptr;
+        Clock::time_point m_queued;
+        Clock::time_point m_started;
+
+        public:
+
+        Ticket() = default;
+        Ticket(Ticket&& other);
+        Ticket& operator=(Ticket&& other);
+        Ticket(const Ticket&) = delete;
+        Ticket& operator=(const Ticket&) = delete;
+        ~Ticket();
+    };
+
+    Scheduler() = default;
+
+    /**
+     * @brief Enable the scheduler with the provided configuration.
+     *
+     * @param config Configuration.
+     * @param replicas Number of VM replicas, used as default concurrency.
+     */
+    void configure(const nlohmann::json& config, size_t replicas = 1);
+
+    /**
+     * @brief Whether the scheduler has been configured.
+     */
+    bool enabled() const {
+        return m_enabled;
+    }
+
+    /**
+     * @brief Get the configuration of the scheduler.
+     */
+    nlohmann::json getConfig() const;
+
+    /**
+     * @brief Get the per-class latency statistics.
+     */
+    nlohmann::json getStatistics() const;
+
+    /**
+     * @brief Wait until a request of the specified class may run. If the
+     * requested class is empty, the class is chosen based on the function.
+     * Throws an Exception if the requested class is unknown. If the
+     * scheduler is disabled, or if the request gets cancelled or reaches
+     * its deadline while queued, returns immediately with an empty Ticket.
+     */
+    Ticket schedule(std::string_view requested_class,
+                    std::string_view function,
+                    const ExecutionContext& context = ExecutionContext{});
+
+    /**
+     * @brief Wake up the queued requests so that the ones
+     * that have been cancelled leave the queue.
+     */
+    void notifyCancelled();
+
+    private:
+
+    void dispatch();
+    void release(Ticket& ticket);
+
+    bool                                         m_enabled = false;
+    mutable tl::mutex                            m_mtx;
+    tl::condition_variable                       m_cv;
+    std::map<std::string, Class>                 m_classes;
+    std::unordered_map<std::string, std::string> m_rules;
+    std::string                                  m_default_class;
+    size_t                                       m_concurrency = 1;
+    size_t                                       m_running     = 0;
+    double                                       m_vtime       = 0.0;
+};
+
+}
+
+#endif
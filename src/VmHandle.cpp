@@ -40,40 +40,119 @@ Client VmHandle::client() const {
     return Client(self->m_client);
 }
 
+const std::string& VmHandle::vmName() const {
+    if(not self) throw Exception("Invalid poesie::VmHandle object");
+    return self->m_vm_name;
+}
+
+void VmHandle::setPriorityClass(std::string_view priority_class) {
+    if(not self) throw Exception("Invalid poesie::VmHandle object");
+    // copies of this VmHandle keep their own priority class
+    self = std::make_shared<VmHandleImpl>(*self);
+    self->m_priority_class = priority_class;
+}
+
+const std::string& VmHandle::priorityClass() const {
+    if(not self) throw Exception("Invalid poesie::VmHandle object");
+    return self->m_priority_class;
+}
+
 VmHandle::FutureType VmHandle::execute(std::string_view code,
-                                       const VmHandle::ArgsType& args) const
+                                       const VmHandle::ArgsType& args,
+                                       std::chrono::milliseconds timeout) const
 {
     if(not self) throw Exception("Invalid poesie::VmHandle object");
     std::vector<ConstJsonRefWrapper> jargs{args.begin(), args.end()};
     auto& rpc = self->m_client->m_execute;
     auto& ph  = self->m_ph;
-    auto async_response = rpc.on(ph).async(code, jargs);
-    return FutureType{std::move(async_response)};
+    auto request_id = self->m_client->newRequestId();
+    auto timeout_ms = static_cast<uint64_t>(timeout.count());
+    auto async_response = rpc.on(ph).async(self->m_vm_name, code, jargs, self->m_priority_class,
+                                          timeout_ms, request_id);
+    FutureType::RetryFn retry;
+    if(self->m_client->m_max_retries)
+        retry = self->retrier(timeout_ms,
+            [self=self, code=std::string{code}, args, request_id](uint64_t timeout_ms) {
+                std::vector<ConstJsonRefWrapper> jargs{args.begin(), args.end()};
+                return self->m_client->m_execute.on(self->m_ph).async(
+                    self->m_vm_name, code, jargs, self->m_priority_class, timeout_ms, request_id);
+            });
+    return FutureType{std::move(async_response), self->canceller(request_id), std::move(retry)};
 }
 
 VmHandle::FutureType VmHandle::load(
         std::string_view filename,
-        const VmHandle::ArgsType& args) const
+        const VmHandle::ArgsType& args,
+        std::chrono::milliseconds timeout) const
 {
     if(not self) throw Exception("Invalid poesie::VmHandle object");
     std::vector<ConstJsonRefWrapper> jargs{args.begin(), args.end()};
     auto& rpc = self->m_client->m_load;
     auto& ph  = self->m_ph;
-    auto async_response = rpc.on(ph).async(filename, jargs);
-    return FutureType{std::move(async_response)};
+    auto request_id = self->m_client->newRequestId();
+    auto timeout_ms = static_cast<uint64_t>(timeout.count());
+    auto async_response = rpc.on(ph).async(self->m_vm_name, filename, jargs, self->m_priority_class,
+                                          timeout_ms, request_id);
+    FutureType::RetryFn retry;
+    if(self->m_client->m_max_retries)
+        retry = self->retrier(timeout_ms,
+            [self=self, filename=std::string{filename}, args, request_id](uint64_t timeout_ms) {
+                std::vector<ConstJsonRefWrapper> jargs{args.begin(), args.end()};
+                return self->m_client->m_load.on(self->m_ph).async(
+                    self->m_vm_name, filename, jargs, self->m_priority_class, timeout_ms, request_id);
+            });
+    return FutureType{std::move(async_response), self->canceller(request_id), std::move(retry)};
 }
 
 VmHandle::FutureType VmHandle::call(
         std::string_view function,
         std::string_view target,
-        const VmHandle::ArgsType& args) const
+        const VmHandle::ArgsType& args,
+        bool read_only,
+        std::chrono::milliseconds timeout) const
 {
     if(not self) throw Exception("Invalid poesie::VmHandle object");
     std::vector<ConstJsonRefWrapper> jargs{args.begin(), args.end()};
     auto& rpc = self->m_client->m_call;
     auto& ph  = self->m_ph;
-    auto async_response = rpc.on(ph).async(function, target, jargs);
-    return FutureType{std::move(async_response)};
+    auto request_id = self->m_client->newRequestId();
+    auto timeout_ms = static_cast<uint64_t>(timeout.count());
+    auto async_response = rpc.on(ph).async(self->m_vm_name, function, target, jargs, read_only,
+                                          self->m_priority_class,
+                                          timeout_ms, request_id);
+    FutureType::RetryFn retry;
+    if(self->m_client->m_max_retries)
+        retry = self->retrier(timeout_ms,
+            [self=self, function=std::string{function}, target=std::string{target},
+             args, read_only, request_id](uint64_t timeout_ms) {
+                std::vector<ConstJsonRefWrapper> jargs{args.begin(), args.end()};
+                return self->m_client->m_call.on(self->m_ph).async(
+                    self->m_vm_name, function, target, jargs, read_only,
+                    self->m_priority_class, timeout_ms, request_id);
+            });
+    return FutureType{std::move(async_response), self->canceller(request_id), std::move(retry)};
+}
+
+Future<bool> VmHandle::installNative(
+        std::string_view library,
+        std::string_view symbol,
+        std::string_view name,
+        size_t nargs) const
+{
+    if(not self) throw Exception("Invalid poesie::VmHandle object");
+    auto& rpc = self->m_client->m_install;
+    auto& ph  = self->m_ph;
+    auto async_response = rpc.on(ph).async(self->m_vm_name, library, symbol, name, nargs);
+    return Future<bool>{std::move(async_response)};
+}
+
+Future<bool> VmHandle::destroy() const
+{
+    if(not self) throw Exception("Invalid poesie::VmHandle object");
+    auto& rpc = self->m_client->m_destroy_vm;
+    auto& ph  = self->m_ph;
+    auto async_response = rpc.on(ph).async(self->m_vm_name);
+    return Future<bool>{std::move(async_response)};
 }
 
 }
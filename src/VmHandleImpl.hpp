@@ -7,6 +7,11 @@
 #define __POESIE_VM_HANDLE_IMPL_H
 
 #include "ClientImpl.hpp"
+#include "poesie/Result.hpp"
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <random>
 
 namespace poesie {
 
@@ -16,13 +21,64 @@ class VmHandleImpl {
 
     std::shared_ptr<ClientImpl> m_client;
     tl::provider_handle         m_ph;
+    std::string                 m_vm_name;
+    std::string                 m_priority_class;
 
     VmHandleImpl() = default;
 
     VmHandleImpl(std::shared_ptr<ClientImpl> client,
-                       tl::provider_handle&& ph)
+                       tl::provider_handle&& ph,
+                       std::string vm_name = "")
     : m_client(std::move(client))
-    , m_ph(std::move(ph)) {}
+    , m_ph(std::move(ph))
+    , m_vm_name(std::move(vm_name)) {}
+
+    /**
+     * @brief Function that asks the provider
+     * to cancel the request with the given id.
+     */
+    std::function<void()> canceller(uint64_t request_id) const {
+        return [client=m_client, ph=m_ph, request_id]() {
+            Result<bool> result = client->m_cancel.on(ph)(request_id);
+            result.check();
+        };
+    }
+
+    /**
+     * @brief Function that sends a request again using the provided
+     * function, waiting a random delay of up to an exponentially growing
+     * backoff between attempts (so that clients rejected together don't
+     * all retry together), until the client's maximum number of retries
+     * is reached. Retries are sent with the part of the timeout
+     * (in milliseconds, 0 meaning none) that remains, and are not sent
+     * once it has elapsed.
+     */
+    template<typename SendFn>
+    std::function<bool(tl::async_response&)> retrier(uint64_t timeout_ms, SendFn&& send) const {
+        return [engine=m_client->m_engine,
+                backoff=m_client->m_initial_backoff,
+                max_backoff=m_client->m_max_backoff,
+                retries=m_client->m_max_retries,
+                timeout_ms,
+                start=std::chrono::steady_clock::now(),
+                send=std::forward<SendFn>(send)](tl::async_response& resp) mutable {
+            if(retries == 0) return false;
+            retries -= 1;
+            static thread_local std::mt19937_64 rng{std::random_device{}()};
+            auto delay = std::uniform_int_distribution<int64_t>{0, backoff.count()}(rng);
+            tl::thread::sleep(engine, delay);
+            backoff = std::min(2*backoff, max_backoff);
+            uint64_t remaining_ms = 0;
+            if(timeout_ms) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                if(static_cast<uint64_t>(elapsed) >= timeout_ms) return false;
+                remaining_ms = timeout_ms - elapsed;
+            }
+            resp = send(remaining_ms);
+            return true;
+        };
+    }
 };
 
 }
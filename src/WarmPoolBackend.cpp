@@ -0,0 +1,204 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "poesie/Exception.hpp"
+#include "WarmPoolBackend.hpp"
+#include <spdlog/spdlog.h>
+#include <optional>
+
+namespace poesie {
+
+using json = nlohmann::json;
+
+namespace {
+
+const Backend& checked(const std::shared_ptr<Backend>& backend) {
+    if(!backend)
+        throw Exception{"Invalid VM passed to WarmPoolBackend"};
+    return *backend;
+}
+
+}
+
+WarmPoolBackend::WarmPoolBackend(std::shared_ptr<Backend> prototype,
+                                 const tl::engine& engine,
+                                 size_t size)
+: Backend(checked(prototype)) // copies the name of the backend type
+, m_prototype(std::move(prototype))
+, m_engine(engine)
+, m_size(size)
+, m_pool(tl::pool::create(tl::pool::access::mpmc))
+, m_xstream(tl::xstream::create(tl::scheduler::predef::basic_wait, *m_pool)) {
+    for(size_t i = 0; i < m_size; ++i) refill();
+}
+
+WarmPoolBackend::~WarmPoolBackend() {
+    // pending refills stop creating VMs, the
+    // execution stream is joined afterwards
+    m_stopping = true;
+}
+
+WarmPoolBackend::ReadyVm WarmPoolBackend::create() {
+    auto vm = m_prototype->clone(m_engine);
+    if(!vm) throw Exception{"Could not create a VM of type " + name()};
+    m_created += 1;
+    return ReadyVm{std::move(vm), 0};
+}
+
+Result<bool> WarmPoolBackend::installMissing(ReadyVm& vm) {
+    // m_mtx must be held by the caller
+    Result<bool> result;
+    for(; vm.second < m_functions.size(); ++vm.second) {
+        auto& f = m_functions[vm.second];
+        auto r = f.function ? vm.first->install(f.name, f.function, f.nargs)
+                            : vm.first->installAsync(f.name, f.async_function, f.nargs);
+        if(!r.success() && result.success()) result = std::move(r);
+    }
+    return result;
+}
+
+void WarmPoolBackend::refill() {
+    {
+        std::unique_lock<tl::mutex> lock{m_mtx};
+        if(m_stopping || m_ready.size() + m_refilling >= m_size) return;
+        m_refilling += 1;
+    }
+    m_pool->make_thread([this]() {
+        std::optional<ReadyVm> vm;
+        try {
+            if(!m_stopping) vm = create();
+        } catch(const std::exception& ex) {
+            spdlog::warn("[poesie] Could not refill the pool of {} VMs: {}", name(), ex.what());
+        }
+        std::unique_lock<tl::mutex> lock{m_mtx};
+        m_refilling -= 1;
+        if(!vm || m_stopping) return;
+        installMissing(*vm);
+        m_ready.push_back(std::move(*vm));
+    }, tl::anonymous{});
+}
+
+void WarmPoolBackend::discard(std::shared_ptr<Backend> vm) {
+    m_discarded += 1;
+    m_pool->make_thread([vm=std::move(vm)]() mutable {
+        vm->destroy();
+        vm.reset();
+    }, tl::anonymous{});
+}
+
+std::shared_ptr<Backend> WarmPoolBackend::take() {
+    ReadyVm vm;
+    {
+        std::unique_lock<tl::mutex> lock{m_mtx};
+        if(!m_ready.empty()) {
+            vm = std::move(m_ready.front());
+            m_ready.pop_front();
+        }
+    }
+    if(vm.first) {
+        m_hits += 1;
+    } else {
+        m_misses += 1;
+        vm = create();
+    }
+    refill();
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    installMissing(vm);
+    return std::move(vm.first);
+}
+
+template<typename Operation>
+auto WarmPoolBackend::run(Operation&& op) {
+    decltype(op(std::declval<Backend&>())) result;
+    std::shared_ptr<Backend> vm;
+    try {
+        vm = take();
+    } catch(const std::exception& ex) {
+        result.success() = false;
+        result.error() = ex.what();
+        return result;
+    }
+    result = op(*vm);
+    discard(std::move(vm));
+    return result;
+}
+
+json WarmPoolBackend::getStatistics() const {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    auto ready = m_ready.size();
+    lock.unlock();
+    return json{
+        {"ready", ready},
+        {"hits", m_hits.load()},
+        {"misses", m_misses.load()},
+        {"created", m_created.load()},
+        {"discarded", m_discarded.load()}
+    };
+}
+
+std::string WarmPoolBackend::getConfig() const {
+    return m_prototype->getConfig();
+}
+
+Result<json> WarmPoolBackend::execute(std::string_view code,
+                                      const std::vector<json>& args,
+                                      const ExecutionContext& context) {
+    return run([&](Backend& vm) { return vm.execute(code, args, context); });
+}
+
+Result<json> WarmPoolBackend::load(std::string_view filename,
+                                   const std::vector<json>& args,
+                                   const ExecutionContext& context) {
+    return run([&](Backend& vm) { return vm.load(filename, args, context); });
+}
+
+Result<json> WarmPoolBackend::call(
+        std::string_view function,
+        std::string_view target,
+        const std::vector<json>& args,
+        const ExecutionContext& context) {
+    return run([&](Backend& vm) { return vm.call(function, target, args, context); });
+}
+
+Result<bool> WarmPoolBackend::install(
+        std::string_view name,
+        ForeignFn function,
+        size_t nargs) {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    m_functions.push_back(Function{std::string{name}, std::move(function), {}, nargs});
+    Result<bool> result;
+    for(auto& vm : m_ready) {
+        auto r = installMissing(vm);
+        if(!r.success() && result.success()) result = std::move(r);
+    }
+    return result;
+}
+
+Result<bool> WarmPoolBackend::installAsync(
+        std::string_view name,
+        AsyncForeignFn function,
+        size_t nargs) {
+    std::unique_lock<tl::mutex> lock{m_mtx};
+    m_functions.push_back(Function{std::string{name}, {}, std::move(function), nargs});
+    Result<bool> result;
+    for(auto& vm : m_ready) {
+        auto r = installMissing(vm);
+        if(!r.success() && result.success()) result = std::move(r);
+    }
+    return result;
+}
+
+Result<bool> WarmPoolBackend::destroy() {
+    std::deque<ReadyVm> ready;
+    {
+        std::unique_lock<tl::mutex> lock{m_mtx};
+        m_stopping = true;
+        ready.swap(m_ready);
+    }
+    for(auto& vm : ready) vm.first->destroy();
+    return m_prototype->destroy();
+}
+
+}
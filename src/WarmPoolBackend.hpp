@@ -0,0 +1,145 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __POESIE_WARM_POOL_BACKEND_H
+#define __POESIE_WARM_POOL_BACKEND_H
+
+#include <poesie/Backend.hpp>
+#include <thallium.hpp>
+#include <nlohmann/json.hpp>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <tuple>
+#include <atomic>
+
+namespace poesie {
+
+namespace tl = thallium;
+
+/**
+ * @brief A WarmPoolBackend runs each request in a fresh VM, so that
+ * requests can't observe the state left by previous ones, without paying
+ * for the creation of the VM (and the execution of its preamble) on the
+ * critical path of the request.
+ *
+ * It keeps a pool of VMs cloned (see Backend::clone) from a prototype VM
+ * that never runs requests. A request takes a VM from the pool and the VM
+ * is destroyed once the request completes. The pool is refilled, and used
+ * VMs are destroyed, by ULTs running on an execution stream of its own.
+ * If the pool is empty, the request creates its VM itself.
+ *
+ * Foreign functions installed in a WarmPoolBackend are installed in the
+ * VMs of the pool and in every VM created afterwards.
+ *
+ * It is used when the "vm" entry of the provider's configuration contains
+ * "isolation": "per_request", "warm_pool_size" (default 4) setting the
+ * number of VMs kept ready.
+ */
+class WarmPoolBackend : public Backend {
+
+    struct Function {
+        std::string    name;
+        ForeignFn      function;
+        AsyncForeignFn async_function;
+        size_t         nargs;
+    };
+
+    // VM ready to run a request, and how many of the
+    // functions of m_functions have been installed in it
+    using ReadyVm = std::pair<std::shared_ptr<Backend>, size_t>;
+
+    std::shared_ptr<Backend> m_prototype;
+    tl::engine               m_engine;
+    size_t                   m_size;
+    std::deque<ReadyVm>      m_ready;
+    size_t                   m_refilling = 0;
+    std::vector<Function>    m_functions;
+    mutable tl::mutex        m_mtx;
+    std::atomic<bool>        m_stopping  = false;
+    std::atomic<size_t>      m_hits      = 0;
+    std::atomic<size_t>      m_misses    = 0;
+    std::atomic<size_t>      m_created   = 0;
+    std::atomic<size_t>      m_discarded = 0;
+    // declared last so that the ULTs they run complete
+    // before the members above are destroyed
+    tl::managed<tl::pool>    m_pool;
+    tl::managed<tl::xstream> m_xstream;
+
+    std::shared_ptr<Backend> take();
+    ReadyVm create();
+    Result<bool> installMissing(ReadyVm& vm);
+    void refill();
+    void discard(std::shared_ptr<Backend> vm);
+
+    template<typename Operation>
+    auto run(Operation&& op);
+
+    public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param prototype VM from which the VMs of the pool are cloned.
+     * @param engine Thallium engine.
+     * @param size Number of VMs to keep ready.
+     */
+    WarmPoolBackend(std::shared_ptr<Backend> prototype,
+                    const tl::engine& engine,
+                    size_t size);
+
+    /**
+     * @brief Destructor.
+     */
+    ~WarmPoolBackend();
+
+    /**
+     * @brief Number of VMs the pool keeps ready.
+     */
+    size_t size() const {
+        return m_size;
+    }
+
+    /**
+     * @brief Get the usage statistics of the pool.
+     */
+    nlohmann::json getStatistics() const;
+
+    std::string getConfig() const override;
+
+    using Backend::execute;
+    using Backend::load;
+    using Backend::call;
+
+    Result<nlohmann::json> execute(std::string_view code,
+                                   const std::vector<nlohmann::json>& args,
+                                   const ExecutionContext& context) override;
+
+    Result<nlohmann::json> load(std::string_view filename,
+                                const std::vector<nlohmann::json>& args,
+                                const ExecutionContext& context) override;
+
+    Result<nlohmann::json> call(
+            std::string_view function,
+            std::string_view target,
+            const std::vector<nlohmann::json>& args,
+            const ExecutionContext& context) override;
+
+    Result<bool> install(
+            std::string_view name,
+            ForeignFn function,
+            size_t nargs) override;
+
+    Result<bool> installAsync(
+            std::string_view name,
+            AsyncForeignFn function,
+            size_t nargs) override;
+
+    Result<bool> destroy() override;
+};
+
+}
+
+#endif
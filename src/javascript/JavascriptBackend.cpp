@@ -6,6 +6,9 @@
 #include "JavascriptBackend.hpp"
 #include "poesie/Exception.hpp"
 #include "poesie/MemoryView.hpp"
+#include "../Kernels.hpp"
+#include "../Compression.hpp"
+#include "../Hashing.hpp"
 #include <fstream>
 #include <iostream>
 #include <mutex>
@@ -57,7 +60,7 @@ static void JSONtoDukValue(
         const thallium::engine& engine,
         duk_context* ctx,
         const nlohmann::json& value,
-        std::vector<poesie::MemoryView> createdViews) {
+        std::vector<poesie::MemoryView>& createdViews) {
     if (value.is_null()) {
         duk_push_null(ctx);
     } else if (value.is_boolean()) {
@@ -89,8 +92,12 @@ static void JSONtoDukValue(
         // binary data represents a MemoryView
         auto view = poesie::MemoryView{engine, value};
         createdViews.push_back(view);
-        auto data = view.data();
+        // scripts index the buffer directly (typed array methods included),
+        // so streamed and lazy views must be fully received before the buffer
+        // is exposed, and the whole buffer of a write-tracking view is
+        // considered modified (see MemoryView::data)
         auto size = view.size();
+        auto data = view.data();
         duk_push_external_buffer(ctx);
         duk_config_buffer(ctx, -1, data, size);
     } else {
@@ -98,14 +105,451 @@ static void JSONtoDukValue(
     }
 }
 
+// get the buffer underlying a view
+static char* memoryViewBuffer(duk_context* ctx, duk_idx_t idx, duk_size_t* size) {
+    return static_cast<char*>(duk_require_buffer_data(ctx, idx, size));
+}
+
+// make the bytes from begin (inclusive) to end (exclusive) of a view available
+static bool memoryViewAccessRange(char* data, size_t begin, size_t end, bool write) {
+    if(begin >= end) return true;
+    auto view = poesie::MemoryView::FromData(data);
+    if(!view) return true;
+    try {
+        view.access(data - view.rawData() + begin, end - begin, write);
+    } catch(const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+// memory_view_chunk_size(view): size of the chunks in which a view is received
+static duk_ret_t memoryViewChunkSize(duk_context* ctx) {
+    duk_size_t size = 0;
+    auto data = memoryViewBuffer(ctx, 0, &size);
+    size_t chunk_size = size;
+    {
+        auto view = poesie::MemoryView::FromData(data);
+        if(view) chunk_size = view.chunkSize();
+    }
+    duk_push_number(ctx, chunk_size);
+    return 1;
+}
+
+// memory_view_wait(view, [begin, [end]]): wait for the bytes
+// from begin (inclusive) to end (exclusive) of a view to be received
+static duk_ret_t memoryViewWait(duk_context* ctx) {
+    duk_size_t size = 0;
+    auto data = memoryViewBuffer(ctx, 0, &size);
+    size_t begin = duk_is_undefined(ctx, 1) ? 0 : (size_t)duk_require_number(ctx, 1);
+    size_t end   = duk_is_undefined(ctx, 2) ? size : (size_t)duk_require_number(ctx, 2);
+    if(end > size) return DUK_RET_RANGE_ERROR;
+    return memoryViewAccessRange(data, begin, end, false) ? 0 : DUK_RET_ERROR;
+}
+
+// memory_view_segments(view): array of the [begin, end) ranges of the
+// client memory segments a view was built from
+static duk_ret_t memoryViewSegments(duk_context* ctx) {
+    duk_size_t size = 0;
+    auto data = memoryViewBuffer(ctx, 0, &size);
+    std::vector<std::pair<size_t, size_t>> segments{{0, size}};
+    {
+        auto view = poesie::MemoryView::FromData(data);
+        if(view) segments = view.slice(data - view.rawData(), size).segments();
+    }
+    duk_push_array(ctx);
+    for(size_t i = 0; i < segments.size(); ++i) {
+        duk_push_array(ctx);
+        duk_push_number(ctx, segments[i].first);
+        duk_put_prop_index(ctx, -2, 0);
+        duk_push_number(ctx, segments[i].first + segments[i].second);
+        duk_put_prop_index(ctx, -2, 1);
+        duk_put_prop_index(ctx, -2, i);
+    }
+    return 1;
+}
+
+// finalizer of the buffers created by memory_view_from_file and memory_view_decompress
+static duk_ret_t memoryViewOwnedFinalizer(duk_context* ctx) {
+    duk_get_prop_string(ctx, 0, DUK_HIDDEN_SYMBOL("view"));
+    delete static_cast<poesie::MemoryView*>(duk_get_pointer(ctx, -1));
+    return 0;
+}
+
+// push a Uint8Array over the data of a view, which the array takes ownership of
+static void pushOwnedView(duk_context* ctx, poesie::MemoryView* view) {
+    duk_push_external_buffer(ctx);
+    duk_config_buffer(ctx, -1, view->rawData(), view->size());
+    duk_push_buffer_object(ctx, -1, 0, view->size(), DUK_BUFOBJ_UINT8ARRAY);
+    duk_remove(ctx, -2);
+    duk_push_pointer(ctx, view);
+    duk_put_prop_string(ctx, -2, DUK_HIDDEN_SYMBOL("view"));
+    duk_push_c_function(ctx, memoryViewOwnedFinalizer, 1);
+    duk_set_finalizer(ctx, -2);
+}
+
+static thallium::engine* stashedEngine(duk_context* ctx) {
+    duk_push_global_stash(ctx);
+    duk_get_prop_string(ctx, -1, DUK_HIDDEN_SYMBOL("engine"));
+    auto engine = static_cast<thallium::engine*>(duk_get_pointer(ctx, -1));
+    duk_pop_2(ctx);
+    return engine;
+}
+
+// memory_view_from_file(path, [offset, [size, [writable]]]): map a range of a
+// local file and return it as a Uint8Array (see MemoryView::FromFile); slices
+// of this array must not outlive it
+static duk_ret_t memoryViewFromFile(duk_context* ctx) {
+    auto path   = duk_require_string(ctx, 0);
+    auto offset = duk_is_undefined(ctx, 1) ? 0 : (size_t)duk_require_number(ctx, 1);
+    auto size   = duk_is_undefined(ctx, 2) ? std::optional<size_t>{}
+                                           : std::optional<size_t>{(size_t)duk_require_number(ctx, 2)};
+    auto intent = duk_to_boolean(ctx, 3) ? poesie::MemoryView::Intent::INOUT
+                                         : poesie::MemoryView::Intent::IN;
+    auto engine = stashedEngine(ctx);
+    poesie::MemoryView* view = nullptr;
+    try {
+        view = new poesie::MemoryView{poesie::MemoryView::FromFile(*engine, path, offset, size, intent)};
+    } catch(const std::exception&) {
+        return DUK_RET_ERROR;
+    }
+    pushOwnedView(ctx, view);
+    return 1;
+}
+
+// compression (see Compression.hpp): memory_view_compress(view, codec, dst, [level])
+// compresses a view into dst and returns the compressed size,
+// memory_view_decompress(view, codec, [dst]) decompresses a view into dst and
+// returns the decompressed size, or into a new Uint8Array if dst is not provided,
+// and memory_view_compress_bound(codec, size) is the maximum size of compressed data
+static duk_ret_t memoryViewCompressBound(duk_context* ctx) {
+    auto codec = duk_require_string(ctx, 0);
+    auto size  = (size_t)duk_require_number(ctx, 1);
+    size_t bound = 0;
+    try {
+        bound = poesie::compression::compressBound(codec, size);
+    } catch(const std::exception&) {
+        return DUK_RET_TYPE_ERROR;
+    }
+    duk_push_number(ctx, bound);
+    return 1;
+}
+
+static duk_ret_t memoryViewCompress(duk_context* ctx) {
+    duk_size_t src_size = 0, dst_size = 0;
+    auto src   = memoryViewBuffer(ctx, 0, &src_size);
+    auto codec = duk_require_string(ctx, 1);
+    auto dst   = memoryViewBuffer(ctx, 2, &dst_size);
+    int level  = duk_is_undefined(ctx, 3) ? 0 : duk_require_int(ctx, 3);
+    if(!memoryViewAccessRange(src, 0, src_size, false)
+    || !memoryViewAccessRange(dst, 0, dst_size, true))
+        return DUK_RET_ERROR;
+    size_t size = 0;
+    try {
+        size = poesie::compression::compress(codec, src, src_size, dst, dst_size, level);
+    } catch(const std::exception&) {
+        return DUK_RET_ERROR;
+    }
+    duk_push_number(ctx, size);
+    return 1;
+}
+
+static duk_ret_t memoryViewDecompress(duk_context* ctx) {
+    duk_size_t src_size = 0;
+    auto src   = memoryViewBuffer(ctx, 0, &src_size);
+    auto codec = duk_require_string(ctx, 1);
+    if(!memoryViewAccessRange(src, 0, src_size, false)) return DUK_RET_ERROR;
+    if(!duk_is_null_or_undefined(ctx, 2)) {
+        duk_size_t dst_size = 0;
+        auto dst = memoryViewBuffer(ctx, 2, &dst_size);
+        if(!memoryViewAccessRange(dst, 0, dst_size, true)) return DUK_RET_ERROR;
+        size_t size = 0;
+        try {
+            size = poesie::compression::decompress(codec, src, src_size, dst, dst_size);
+        } catch(const std::exception&) {
+            return DUK_RET_ERROR;
+        }
+        duk_push_number(ctx, size);
+        return 1;
+    }
+    auto engine = stashedEngine(ctx);
+    poesie::MemoryView* view = nullptr;
+    try {
+        view = new poesie::MemoryView{poesie::compression::decompress(*engine, codec, src, src_size)};
+    } catch(const std::exception&) {
+        delete view;
+        return DUK_RET_ERROR;
+    }
+    pushOwnedView(ctx, view);
+    return 1;
+}
+
+// native kernels (see Kernels.hpp), operating on the whole view:
+// memory_view_reduce(view, type, op), memory_view_count(view, byte),
+// memory_view_find(view, pattern, [start]) returning the index of the
+// pattern (a string or a buffer) or -1, memory_view_histogram(view)
+// returning an array of 256 counts, and memory_view_byteswap(view, width)
+static duk_ret_t memoryViewReduce(duk_context* ctx) {
+    duk_size_t size = 0;
+    auto data = memoryViewBuffer(ctx, 0, &size);
+    auto type = duk_require_string(ctx, 1);
+    auto op   = duk_require_string(ctx, 2);
+    if(!memoryViewAccessRange(data, 0, size, false)) return DUK_RET_ERROR;
+    // Javascript numbers are doubles, so sums of 64-bit integers
+    // are only exact up to 2^53
+    double result = 0;
+    try {
+        result = poesie::kernels::reduce(data, size, type, op).get<double>();
+    } catch(const std::exception&) {
+        return DUK_RET_TYPE_ERROR;
+    }
+    duk_push_number(ctx, result);
+    return 1;
+}
+
+static duk_ret_t memoryViewCount(duk_context* ctx) {
+    duk_size_t size = 0;
+    auto data  = memoryViewBuffer(ctx, 0, &size);
+    auto value = (uint8_t)duk_require_uint(ctx, 1);
+    if(!memoryViewAccessRange(data, 0, size, false)) return DUK_RET_ERROR;
+    duk_push_number(ctx, poesie::kernels::count(data, size, value));
+    return 1;
+}
+
+static duk_ret_t memoryViewFind(duk_context* ctx) {
+    duk_size_t size = 0;
+    auto data = memoryViewBuffer(ctx, 0, &size);
+    duk_size_t pattern_size = 0;
+    const char* pattern = duk_is_buffer_data(ctx, 1)
+        ? static_cast<const char*>(duk_get_buffer_data(ctx, 1, &pattern_size))
+        : duk_require_lstring(ctx, 1, &pattern_size);
+    size_t start = duk_is_undefined(ctx, 2) ? 0 : (size_t)duk_require_number(ctx, 2);
+    if(!memoryViewAccessRange(data, 0, size, false)) return DUK_RET_ERROR;
+    auto pos = poesie::kernels::find(data, size, {pattern, pattern_size}, start);
+    if(pos == std::string_view::npos) duk_push_int(ctx, -1);
+    else duk_push_number(ctx, pos);
+    return 1;
+}
+
+static duk_ret_t memoryViewHistogram(duk_context* ctx) {
+    duk_size_t size = 0;
+    auto data = memoryViewBuffer(ctx, 0, &size);
+    if(!memoryViewAccessRange(data, 0, size, false)) return DUK_RET_ERROR;
+    auto counts = poesie::kernels::histogram(data, size);
+    duk_push_array(ctx);
+    for(size_t b = 0; b < counts.size(); ++b) {
+        duk_push_number(ctx, counts[b]);
+        duk_put_prop_index(ctx, -2, b);
+    }
+    return 1;
+}
+
+static duk_ret_t memoryViewByteswap(duk_context* ctx) {
+    duk_size_t size = 0;
+    auto data  = memoryViewBuffer(ctx, 0, &size);
+    auto width = (size_t)duk_require_uint(ctx, 1);
+    if(!memoryViewAccessRange(data, 0, size, true)) return DUK_RET_ERROR;
+    try {
+        poesie::kernels::byteswap(data, size, width);
+    } catch(const std::exception&) {
+        return DUK_RET_RANGE_ERROR;
+    }
+    return 0;
+}
+
+// hashing (see Hashing.hpp): memory_view_hash(view, algorithm, [begin, [end]])
+// returns the hash of the bytes from begin (inclusive) to end (exclusive) of a
+// view, and memory_view_hasher(algorithm) returns a hasher h on which
+// h.update(view, [begin, [end]]) adds bytes to the hashed content (e.g. each
+// chunk of a streamed view as it is received) and h.digest() returns the hash
+// of the content added so far
+static bool memoryViewHashRange(duk_context* ctx, duk_idx_t view_idx, duk_idx_t begin_idx,
+                                char** data, size_t* size) {
+    duk_size_t view_size = 0;
+    auto view_data = memoryViewBuffer(ctx, view_idx, &view_size);
+    auto end_idx   = begin_idx + 1;
+    size_t begin = duk_is_undefined(ctx, begin_idx) ? 0 : (size_t)duk_require_number(ctx, begin_idx);
+    size_t end   = duk_is_undefined(ctx, end_idx) ? view_size : (size_t)duk_require_number(ctx, end_idx);
+    if(begin > end || end > view_size) return false;
+    if(!memoryViewAccessRange(view_data, begin, end, false)) return false;
+    *data = view_data + begin;
+    *size = end - begin;
+    return true;
+}
+
+static duk_ret_t memoryViewHash(duk_context* ctx) {
+    char* data = nullptr;
+    size_t size = 0;
+    auto algorithm = duk_require_string(ctx, 1);
+    if(!memoryViewHashRange(ctx, 0, 2, &data, &size)) return DUK_RET_RANGE_ERROR;
+    bool ok = true;
+    {
+        std::string digest;
+        try {
+            digest = poesie::hashing::hash(algorithm, data, size);
+        } catch(const std::exception&) {
+            ok = false;
+        }
+        if(ok) duk_push_lstring(ctx, digest.data(), digest.size());
+    }
+    return ok ? 1 : DUK_RET_TYPE_ERROR;
+}
+
+static poesie::hashing::Hasher* memoryViewThisHasher(duk_context* ctx) {
+    duk_push_this(ctx);
+    duk_get_prop_string(ctx, -1, DUK_HIDDEN_SYMBOL("hasher"));
+    auto hasher = static_cast<poesie::hashing::Hasher*>(duk_get_pointer(ctx, -1));
+    duk_pop_2(ctx);
+    return hasher;
+}
+
+static duk_ret_t memoryViewHasherUpdate(duk_context* ctx) {
+    auto hasher = memoryViewThisHasher(ctx);
+    char* data = nullptr;
+    size_t size = 0;
+    if(!hasher) return DUK_RET_TYPE_ERROR;
+    if(!memoryViewHashRange(ctx, 0, 1, &data, &size)) return DUK_RET_RANGE_ERROR;
+    hasher->update(data, size);
+    return 0;
+}
+
+static duk_ret_t memoryViewHasherDigest(duk_context* ctx) {
+    auto hasher = memoryViewThisHasher(ctx);
+    if(!hasher) return DUK_RET_TYPE_ERROR;
+    {
+        auto digest = hasher->hexdigest();
+        duk_push_lstring(ctx, digest.data(), digest.size());
+    }
+    return 1;
+}
+
+static duk_ret_t memoryViewHasherFinalizer(duk_context* ctx) {
+    duk_get_prop_string(ctx, 0, DUK_HIDDEN_SYMBOL("hasher"));
+    delete static_cast<poesie::hashing::Hasher*>(duk_get_pointer(ctx, -1));
+    return 0;
+}
+
+static duk_ret_t memoryViewHasher(duk_context* ctx) {
+    auto algorithm = duk_require_string(ctx, 0);
+    poesie::hashing::Hasher* hasher = nullptr;
+    try {
+        hasher = poesie::hashing::Hasher::Create(algorithm).release();
+    } catch(const std::exception&) {
+        return DUK_RET_TYPE_ERROR;
+    }
+    duk_push_object(ctx);
+    duk_push_pointer(ctx, hasher);
+    duk_put_prop_string(ctx, -2, DUK_HIDDEN_SYMBOL("hasher"));
+    duk_push_c_function(ctx, memoryViewHasherFinalizer, 1);
+    duk_set_finalizer(ctx, -2);
+    duk_push_c_function(ctx, memoryViewHasherUpdate, DUK_VARARGS);
+    duk_put_prop_string(ctx, -2, "update");
+    duk_push_c_function(ctx, memoryViewHasherDigest, 0);
+    duk_put_prop_string(ctx, -2, "digest");
+    return 1;
+}
+
+// streamed memory views: scripts access the bytes of a view directly, so
+// views are fully received before the script runs; memory_view_wait and
+// memory_view_chunks(view, function(begin, end) {...}) are provided so that
+// scripts written for other backends, which do stream views, work unchanged;
+// memory_view_slice(view, begin, end) returns a view of the bytes from begin
+// (inclusive) to end (exclusive) of a view, sharing the view's data
+static const char* memoryViewHelpers = R"(
+function memory_view_chunks(view, callback) {
+    var size = view.length;
+    var chunk_size = memory_view_chunk_size(view);
+    for(var begin = 0; begin < size; begin += chunk_size) {
+        var end = Math.min(begin + chunk_size, size);
+        memory_view_wait(view, begin, end);
+        callback(begin, end);
+    }
+}
+function memory_view_slice(view, begin, end) {
+    return view.subarray(begin, end);
+}
+)";
+
+// number of instructions between two calls to the timeout check
+// (DUK_HTHREAD_INTCTR_DEFAULT in duktape.c)
+static constexpr size_t s_interrupt_period = 256 * 1024;
+
+// Called periodically by Duktape while a script runs, with the
+// JavascriptVm as heap user data; a non-zero return value makes
+// Duktape throw a RangeError until the script has unwound.
+extern "C" duk_bool_t poesie_duk_exec_timeout_check(void* udata) {
+    auto vm = static_cast<JavascriptVm*>(udata);
+    if(!vm || !vm->m_context) return 0;
+    if(vm->m_context->interrupted()) return 1;
+    vm->m_yielder.tick(s_interrupt_period);
+    return 0;
+}
+
+// lets long computations explicitly share the execution stream
+static duk_ret_t poesieYield(duk_context*) {
+    thallium::thread::yield();
+    return 0;
+}
+
+namespace {
+
+// Makes the ExecutionContext of a request visible to
+// poesie_duk_exec_timeout_check while the request runs
+struct RunningContext {
+    const poesie::ExecutionContext*& current;
+    RunningContext(const poesie::ExecutionContext*& c,
+                   const poesie::ExecutionContext& context)
+    : current(c) { current = &context; }
+    ~RunningContext() { current = nullptr; }
+};
+
+}
 
 JavascriptVm::JavascriptVm(thallium::engine engine, const json& config)
 : m_engine(std::move(engine)),
-  m_config(config) {
-    m_ctx = duk_create_heap_default();
+  m_config(config),
+  m_yielder(config) {
+    m_ctx = duk_create_heap(nullptr, nullptr, nullptr, this, nullptr);
     if(!m_ctx) {
         throw poesie::Exception{"Duktape initialization failed"};
     }
+    duk_push_c_function(m_ctx, poesieYield, 0);
+    duk_put_global_string(m_ctx, "poesie_yield");
+    duk_push_c_function(m_ctx, memoryViewChunkSize, 1);
+    duk_put_global_string(m_ctx, "memory_view_chunk_size");
+    duk_push_c_function(m_ctx, memoryViewWait, DUK_VARARGS);
+    duk_put_global_string(m_ctx, "memory_view_wait");
+    duk_push_global_stash(m_ctx);
+    duk_push_pointer(m_ctx, &m_engine);
+    duk_put_prop_string(m_ctx, -2, DUK_HIDDEN_SYMBOL("engine"));
+    duk_pop(m_ctx);
+    duk_push_c_function(m_ctx, memoryViewFromFile, DUK_VARARGS);
+    duk_put_global_string(m_ctx, "memory_view_from_file");
+    duk_push_c_function(m_ctx, memoryViewSegments, 1);
+    duk_put_global_string(m_ctx, "memory_view_segments");
+    duk_push_c_function(m_ctx, memoryViewReduce, 3);
+    duk_put_global_string(m_ctx, "memory_view_reduce");
+    duk_push_c_function(m_ctx, memoryViewCount, 2);
+    duk_put_global_string(m_ctx, "memory_view_count");
+    duk_push_c_function(m_ctx, memoryViewFind, DUK_VARARGS);
+    duk_put_global_string(m_ctx, "memory_view_find");
+    duk_push_c_function(m_ctx, memoryViewHistogram, 1);
+    duk_put_global_string(m_ctx, "memory_view_histogram");
+    duk_push_c_function(m_ctx, memoryViewByteswap, 2);
+    duk_put_global_string(m_ctx, "memory_view_byteswap");
+    duk_push_c_function(m_ctx, memoryViewHash, DUK_VARARGS);
+    duk_put_global_string(m_ctx, "memory_view_hash");
+    duk_push_c_function(m_ctx, memoryViewHasher, 1);
+    duk_put_global_string(m_ctx, "memory_view_hasher");
+    duk_push_c_function(m_ctx, memoryViewCompressBound, 2);
+    duk_put_global_string(m_ctx, "memory_view_compress_bound");
+    duk_push_c_function(m_ctx, memoryViewCompress, DUK_VARARGS);
+    duk_put_global_string(m_ctx, "memory_view_compress");
+    duk_push_c_function(m_ctx, memoryViewDecompress, DUK_VARARGS);
+    duk_put_global_string(m_ctx, "memory_view_decompress");
+    if(duk_peval_string(m_ctx, memoryViewHelpers) != 0)
+        throw poesie::Exception{"Could not define memory view helpers"};
+    duk_pop(m_ctx);
     if(m_config.is_object()) {
         std::vector<json> args;
         if(m_config.contains("preamble_argv")) {
@@ -144,8 +588,10 @@ std::string JavascriptVm::getConfig() const {
 
 poesie::Result<json> JavascriptVm::execute(
         std::string_view code,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     std::unique_lock<thallium::mutex> guard{m_mtx};
+    RunningContext running{m_context, context};
     poesie::Result<json> result;
     duk_push_global_object(m_ctx);
     if (!duk_get_prop_string(m_ctx, -1, "process")) {
@@ -173,8 +619,11 @@ poesie::Result<json> JavascriptVm::execute(
     if (duk_peval_lstring(m_ctx, code.data(), code.size()) != 0) {
         result.success() = false;
         result.error() = "Error executing JavaScript code: ";
-        result.error() += duk_safe_to_string(m_ctx, -1);
+        if(context.interrupted()) result.error() += context.reason();
+        else result.error() += duk_safe_to_string(m_ctx, -1);
     } else {
+        // Push the views back while the result is converted
+        for(auto& view : createdViews) view.writeBack();
         result.value() = dukValueToJSON(m_ctx, -1);
     }
     duk_pop(m_ctx);  // Pop the result or error from the stack
@@ -183,7 +632,8 @@ poesie::Result<json> JavascriptVm::execute(
 
 poesie::Result<json> JavascriptVm::load(
         std::string_view filename,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     std::ifstream file{std::string(filename)};
     if (!file) {
@@ -195,16 +645,18 @@ poesie::Result<json> JavascriptVm::load(
     std::stringstream buffer;
     buffer << file.rdbuf();
     std::string code = buffer.str();
-    result = execute(code, args);
+    result = execute(code, args, context);
     return result;
 }
 
 poesie::Result<json> JavascriptVm::call(
         std::string_view function,
         std::string_view target,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     std::unique_lock<thallium::mutex> guard{m_mtx};
+    RunningContext running{m_context, context};
     std::vector<poesie::MemoryView> createdViews;
     if (target.empty()) {
         // Look up the global function
@@ -222,7 +674,8 @@ poesie::Result<json> JavascriptVm::call(
         if (duk_pcall(m_ctx, args.size()) != 0) {
             result.success() = false;
             result.error() = "Error calling function: ";
-            result.error() += duk_safe_to_string(m_ctx, -1);
+            if(context.interrupted()) result.error() += context.reason();
+            else result.error() += duk_safe_to_string(m_ctx, -1);
             duk_pop(m_ctx);  // Pop the error
             return result;
         }
@@ -253,12 +706,16 @@ poesie::Result<json> JavascriptVm::call(
         if (duk_pcall_method(m_ctx, args.size()) != 0) {
             result.success() = false;
             result.error() = "Error calling function: ";
-            result.error() += duk_safe_to_string(m_ctx, -1);
+            if(context.interrupted()) result.error() += context.reason();
+            else result.error() += duk_safe_to_string(m_ctx, -1);
             duk_pop(m_ctx);  // Pop the error
             return result;
         }
     }
 
+    // Push the views back while the result is converted
+    for(auto& view : createdViews) view.writeBack();
+
     // Convert the result back to nlohmann::json
     result.value() = dukValueToJSON(m_ctx, -1);
 
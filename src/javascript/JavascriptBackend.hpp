@@ -37,6 +37,12 @@ class JavascriptVm : public poesie::Backend {
     json             m_config;
     thallium::mutex  m_mtx;
     duk_context*     m_ctx;
+    // ExecutionContext of the running request, polled by the
+    // execution timeout check of the Duktape heap
+    const poesie::ExecutionContext* m_context = nullptr;
+    poesie::Yielder                 m_yielder;
+
+    friend duk_bool_t (::poesie_duk_exec_timeout_check)(void* udata);
     std::unordered_map<std::string, std::unique_ptr<FunctionHolder>> m_ffuncs;
 
     public:
@@ -76,19 +82,26 @@ class JavascriptVm : public poesie::Backend {
      */
     std::string getConfig() const override;
 
+    // overloads running without an ExecutionContext
+    using poesie::Backend::execute;
+    using poesie::Backend::load;
+    using poesie::Backend::call;
+
     /**
      * @see Backend::execute.
      */
     poesie::Result<json> execute(
             std::string_view code,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::load.
      */
     poesie::Result<json> load(
             std::string_view filename,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::call.
@@ -96,7 +109,8 @@ class JavascriptVm : public poesie::Backend {
     poesie::Result<json> call(
             std::string_view function,
             std::string_view target,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::install.
@@ -3097,6 +3097,16 @@ typedef struct duk_hthread duk_context;
 
 /* __OVERRIDE_DEFINES__ */
 
+/* poesie: abort scripts whose ExecutionContext is interrupted,
+ * see JavascriptBackend.cpp
+ */
+#define DUK_USE_INTERRUPT_COUNTER
+#define DUK_USE_EXEC_TIMEOUT_CHECK(udata) poesie_duk_exec_timeout_check((udata))
+#if defined(__cplusplus)
+extern "C"
+#endif
+duk_bool_t poesie_duk_exec_timeout_check(void *udata);
+
 /*
  *  Conditional includes
  */
@@ -5,6 +5,9 @@
  */
 #include "Jx9Backend.hpp"
 #include "poesie/MemoryView.hpp"
+#include "../Kernels.hpp"
+#include "../Compression.hpp"
+#include "../Hashing.hpp"
 #include <fstream>
 #include <iostream>
 #include <nlohmann/json.hpp>
@@ -13,10 +16,59 @@
 #include <nlohmann/json.hpp>
 #include <stdexcept>
 
+/**
+ * State of an execution, passed as user data to the natives that create
+ * MemoryViews and hashers, since these must live as long as the execution.
+ * Jx9 resources are untyped (and jx9's own builtins, e.g. fopen, create some
+ * too), so the natives only use the resources registered here, with their type.
+ */
+struct Jx9Execution {
+
+    enum class Kind { MemoryView, Hasher };
+
+    const thallium::engine&                               engine;
+    std::vector<std::unique_ptr<poesie::MemoryView>>      createdViews = {};
+    std::vector<std::unique_ptr<poesie::hashing::Hasher>> hashers = {};
+    std::unordered_map<const void*, Kind>                 resources = {};
+
+    poesie::MemoryView* add(std::unique_ptr<poesie::MemoryView> view) {
+        auto ptr = view.get();
+        resources[ptr] = Kind::MemoryView;
+        createdViews.push_back(std::move(view));
+        return ptr;
+    }
+
+    poesie::hashing::Hasher* add(std::unique_ptr<poesie::hashing::Hasher> hasher) {
+        auto ptr = hasher.get();
+        resources[ptr] = Kind::Hasher;
+        hashers.push_back(std::move(hasher));
+        return ptr;
+    }
+
+    bool is(const void* ptr, Kind kind) const {
+        auto it = resources.find(ptr);
+        return it != resources.end() && it->second == kind;
+    }
+
+    poesie::MemoryView* view(jx9_value* value) const {
+        if(!jx9_value_is_resource(value)) return nullptr;
+        auto ptr = jx9_value_to_resource(value);
+        return is(ptr, Kind::MemoryView) ? static_cast<poesie::MemoryView*>(ptr) : nullptr;
+    }
+
+    poesie::hashing::Hasher* hasher(jx9_value* value) const {
+        if(!jx9_value_is_resource(value)) return nullptr;
+        auto ptr = jx9_value_to_resource(value);
+        return is(ptr, Kind::Hasher) ? static_cast<poesie::hashing::Hasher*>(ptr) : nullptr;
+    }
+};
+
 /**
  * Converts a jx9_value into a nlohmann::json object.
+ * MemoryViews registered in the execution are converted into a binary
+ * holding their address, other resources into null.
  */
-static nlohmann::json Jx9ValueToJSON(jx9_value* value) {
+static nlohmann::json Jx9ValueToJSON(jx9_value* value, const Jx9Execution& execution) {
     if (jx9_value_is_null(value)) {
         return nullptr;
     } else if (jx9_value_is_bool(value)) {
@@ -28,33 +80,37 @@ static nlohmann::json Jx9ValueToJSON(jx9_value* value) {
     } else if (jx9_value_is_string(value)) {
         return std::string(jx9_value_to_string(value, nullptr));
     } else if (jx9_value_is_resource(value)) {
+        auto view = execution.view(value);
+        if(!view) return nullptr;
         std::vector<uint8_t> b(sizeof(intptr_t));
-        intptr_t ptr = (intptr_t)jx9_value_to_resource(value);
+        intptr_t ptr = (intptr_t)view;
         std::memcpy(b.data(), &ptr, sizeof(ptr));
         return nlohmann::json::binary_t(b);
     } else if (jx9_value_is_json_object(value)) {
         nlohmann::json jsonObject = nlohmann::json::object();
+        std::pair<nlohmann::json*, const Jx9Execution*> walk{&jsonObject, &execution};
 
         auto object_walk = [](jx9_value* pKey, jx9_value* pValue, void* pUserData) -> int {
-            nlohmann::json* jsonObject = static_cast<nlohmann::json*>(pUserData);
+            auto walk = static_cast<std::pair<nlohmann::json*, const Jx9Execution*>*>(pUserData);
             std::string key = jx9_value_to_string(pKey, nullptr);
-            (*jsonObject)[key] = Jx9ValueToJSON(pValue);
+            (*walk->first)[key] = Jx9ValueToJSON(pValue, *walk->second);
             return JX9_OK;
         };
 
-        jx9_array_walk(value, object_walk, &jsonObject);
+        jx9_array_walk(value, object_walk, &walk);
         return jsonObject;
     } else if (jx9_value_is_json_array(value)) {
         nlohmann::json jsonArray = nlohmann::json::array();
+        std::pair<nlohmann::json*, const Jx9Execution*> walk{&jsonArray, &execution};
 
         auto array_walk = [](jx9_value* pKey, jx9_value* pValue, void* pUserData) -> int {
             (void)pKey;
-            nlohmann::json* jsonArray = static_cast<nlohmann::json*>(pUserData);
-            jsonArray->push_back(Jx9ValueToJSON(pValue));
+            auto walk = static_cast<std::pair<nlohmann::json*, const Jx9Execution*>*>(pUserData);
+            walk->first->push_back(Jx9ValueToJSON(pValue, *walk->second));
             return JX9_OK;
         };
 
-        jx9_array_walk(value, array_walk, &jsonArray);
+        jx9_array_walk(value, array_walk, &walk);
         return jsonArray;
     } else {
         return nullptr;
@@ -68,7 +124,7 @@ static jx9_value* JSONtoJx9Value(
         const thallium::engine& engine,
         jx9_vm* vm,
         const nlohmann::json& data,
-        std::vector<std::unique_ptr<poesie::MemoryView>>& createdViews) {
+        Jx9Execution& execution) {
     if (data.is_null()) {
         jx9_value* value = jx9_new_scalar(vm);
         jx9_value_null(value);
@@ -93,13 +149,13 @@ static jx9_value* JSONtoJx9Value(
         jx9_value* arrayValue = jx9_new_array(vm);
         for (const auto& item : data) {
             jx9_array_add_elem(arrayValue, nullptr,\
-                JSONtoJx9Value(engine, vm, item, createdViews));
+                JSONtoJx9Value(engine, vm, item, execution));
         }
         return arrayValue;
     } else if (data.is_object()) {
         jx9_value* objectValue = jx9_new_array(vm);
         for (auto it = data.begin(); it != data.end(); ++it) {
-            jx9_value* entry = JSONtoJx9Value(engine, vm, it.value(), createdViews);
+            jx9_value* entry = JSONtoJx9Value(engine, vm, it.value(), execution);
             jx9_array_add_strkey_elem(objectValue, it.key().c_str(), entry);
         }
         return objectValue;
@@ -111,9 +167,7 @@ static jx9_value* JSONtoJx9Value(
             return value;
         }
         // else, this is a MemoryView object
-        auto view = std::make_unique<poesie::MemoryView>(engine, data);
-        jx9_value_resource(value, view.get());
-        createdViews.push_back(std::move(view));
+        jx9_value_resource(value, execution.add(std::make_unique<poesie::MemoryView>(engine, data)));
         return value;
     } else {
         jx9_value* value = jx9_new_scalar(vm);
@@ -191,7 +245,7 @@ static inline nlohmann::json MemoryView_to_string(const std::vector<nlohmann::js
     poesie::MemoryView* view = nullptr;
     std::memcpy(&view, binary.data(), sizeof(view));
     if(!view) return nullptr;
-    return std::string{view->data(), view->size()};
+    return std::string{view->access(0, view->size()), view->size()};
 }
 
 static inline nlohmann::json MemoryView_get(const std::vector<nlohmann::json>& argv) {
@@ -204,7 +258,7 @@ static inline nlohmann::json MemoryView_get(const std::vector<nlohmann::json>& a
     std::memcpy(&view, binary.data(), sizeof(view));
     if(!view) return nullptr;
     if(i < 0 || i >= (ssize_t)view->size()) return nullptr;
-    return int(view->data()[i]);
+    return int(*view->access(i, 1));
 }
 
 static inline nlohmann::json MemoryView_set(const std::vector<nlohmann::json>& argv) {
@@ -220,15 +274,335 @@ static inline nlohmann::json MemoryView_set(const std::vector<nlohmann::json>& a
     std::memcpy(&view, binary.data(), sizeof(view));
     if(!view) return false;
     if(i < 0 || i >= (int64_t)view->size()) return false;
-    view->data()[i] = (char)b;
+    *view->access(i, 1, true) = (char)b;
+    return true;
+}
+
+static inline nlohmann::json MemoryView_chunk_size(const std::vector<nlohmann::json>& argv) {
+    if(!argv[0].is_binary()) return nullptr;
+    auto& binary = argv[0].get_binary();
+    if(binary.size() != sizeof(intptr_t)) return nullptr;
+    poesie::MemoryView* view = nullptr;
+    std::memcpy(&view, binary.data(), sizeof(view));
+    if(!view) return nullptr;
+    return view->chunkSize();
+}
+
+static inline nlohmann::json MemoryView_wait(const std::vector<nlohmann::json>& argv) {
+    if(!argv[0].is_binary()) return false;
+    if(!argv[1].is_number()) return false;
+    if(!argv[2].is_number()) return false;
+    auto begin = argv[1].get<int64_t>();
+    auto end = argv[2].get<int64_t>();
+    auto& binary = argv[0].get_binary();
+    if(binary.size() != sizeof(intptr_t)) return false;
+    poesie::MemoryView* view = nullptr;
+    std::memcpy(&view, binary.data(), sizeof(view));
+    if(!view) return false;
+    if(begin < 0 || end > (int64_t)view->size()) return false;
+    if(begin < end) view->access(begin, end - begin);
+    return true;
+}
+
+static inline nlohmann::json MemoryView_segments(const std::vector<nlohmann::json>& argv) {
+    if(!argv[0].is_binary()) return nullptr;
+    auto& binary = argv[0].get_binary();
+    if(binary.size() != sizeof(intptr_t)) return nullptr;
+    poesie::MemoryView* view = nullptr;
+    std::memcpy(&view, binary.data(), sizeof(view));
+    if(!view) return nullptr;
+    auto segments = nlohmann::json::array();
+    for(auto& segment : view->segments())
+        segments.push_back({segment.first, segment.first + segment.second});
+    return segments;
+}
+
+// native kernels (see Kernels.hpp), operating on the whole view:
+// memory_view_reduce(view, type, op), memory_view_count(view, byte),
+// memory_view_find(view, pattern, start) returning the offset of the
+// pattern or -1, memory_view_histogram(view) returning an array of 256
+// counts, and memory_view_byteswap(view, width); they return null
+// (false for memory_view_byteswap) on invalid arguments
+static poesie::MemoryView* MemoryView_kernel_arg(const nlohmann::json& arg) {
+    if(!arg.is_binary()) return nullptr;
+    auto& binary = arg.get_binary();
+    if(binary.size() != sizeof(intptr_t)) return nullptr;
+    poesie::MemoryView* view = nullptr;
+    std::memcpy(&view, binary.data(), sizeof(view));
+    return view;
+}
+
+static inline nlohmann::json MemoryView_reduce(const std::vector<nlohmann::json>& argv) {
+    auto view = MemoryView_kernel_arg(argv[0]);
+    if(!view || !argv[1].is_string() || !argv[2].is_string()) return nullptr;
+    try {
+        return poesie::kernels::reduce(view->access(0, view->size()), view->size(),
+            argv[1].get_ref<const std::string&>(), argv[2].get_ref<const std::string&>());
+    } catch(const std::exception&) {
+        return nullptr;
+    }
+}
+
+static inline nlohmann::json MemoryView_count(const std::vector<nlohmann::json>& argv) {
+    auto view = MemoryView_kernel_arg(argv[0]);
+    if(!view || !argv[1].is_number_integer()) return nullptr;
+    auto b = argv[1].get<int64_t>();
+    if(b < 0 || b > 255) return nullptr;
+    return poesie::kernels::count(view->access(0, view->size()), view->size(), (uint8_t)b);
+}
+
+static inline nlohmann::json MemoryView_find(const std::vector<nlohmann::json>& argv) {
+    auto view = MemoryView_kernel_arg(argv[0]);
+    if(!view || !argv[1].is_string() || !argv[2].is_number()) return nullptr;
+    auto start = argv[2].get<int64_t>();
+    if(start < 0) start = 0;
+    auto pos = poesie::kernels::find(view->access(0, view->size()), view->size(),
+                                     argv[1].get_ref<const std::string&>(), start);
+    if(pos == std::string_view::npos) return -1;
+    return pos;
+}
+
+static inline nlohmann::json MemoryView_histogram(const std::vector<nlohmann::json>& argv) {
+    auto view = MemoryView_kernel_arg(argv[0]);
+    if(!view) return nullptr;
+    return poesie::kernels::histogram(view->access(0, view->size()), view->size());
+}
+
+static inline nlohmann::json MemoryView_byteswap(const std::vector<nlohmann::json>& argv) {
+    auto view = MemoryView_kernel_arg(argv[0]);
+    if(!view || !argv[1].is_number_integer()) return false;
+    try {
+        poesie::kernels::byteswap(view->access(0, view->size(), true), view->size(),
+                                  argv[1].get<size_t>());
+    } catch(const std::exception&) {
+        return false;
+    }
     return true;
 }
 
+// compression (see Compression.hpp): memory_view_compress(view, codec, dst, level)
+// compresses a view into dst and returns the compressed size (level 0 selects the
+// codec's default), memory_view_compress_bound(codec, size) is the maximum size
+// of compressed data, and memory_view_decompress is defined below; they return
+// null on failure
+static inline nlohmann::json MemoryView_compress_bound(const std::vector<nlohmann::json>& argv) {
+    if(!argv[0].is_string() || !argv[1].is_number_integer()) return nullptr;
+    try {
+        return poesie::compression::compressBound(
+            argv[0].get_ref<const std::string&>(), argv[1].get<size_t>());
+    } catch(const std::exception&) {
+        return nullptr;
+    }
+}
+
+static inline nlohmann::json MemoryView_compress(const std::vector<nlohmann::json>& argv) {
+    auto src = MemoryView_kernel_arg(argv[0]);
+    auto dst = MemoryView_kernel_arg(argv[2]);
+    if(!src || !dst || !argv[1].is_string() || !argv[3].is_number_integer()) return nullptr;
+    try {
+        return poesie::compression::compress(argv[1].get_ref<const std::string&>(),
+            src->access(0, src->size()), src->size(),
+            dst->access(0, dst->size(), true), dst->size(), argv[3].get<int>());
+    } catch(const std::exception&) {
+        return nullptr;
+    }
+}
+
+// hashing (see Hashing.hpp): memory_view_hash(view, algorithm, begin, end) returns
+// the hash of the bytes from begin (inclusive) to end (exclusive) of a view, with
+// no copy of the data, or null on invalid arguments; incremental hashing is
+// provided by memory_view_hasher, defined below
+static inline nlohmann::json MemoryView_hash(const std::vector<nlohmann::json>& argv) {
+    auto view = MemoryView_kernel_arg(argv[0]);
+    if(!view || !argv[1].is_string() || !argv[2].is_number() || !argv[3].is_number()) return nullptr;
+    auto begin = argv[2].get<int64_t>();
+    auto end   = argv[3].get<int64_t>();
+    if(begin < 0 || begin > end || end > (int64_t)view->size()) return nullptr;
+    try {
+        return poesie::hashing::hash(argv[1].get_ref<const std::string&>(),
+                                     view->access(begin, end - begin), end - begin);
+    } catch(const std::exception&) {
+        return nullptr;
+    }
+}
+
+// number of instructions between two calls to the interrupt hook
+// (JX9_VM_INTERRUPT_PERIOD in jx9.c)
+static constexpr size_t s_interrupt_period = 1024;
+
+// polled by the Jx9 VM while a script runs (see JX9_VM_CONFIG_INTERRUPT_HOOK),
+// a non-zero return value aborts the script
+struct Jx9Interrupt {
+    const poesie::ExecutionContext& context;
+    poesie::Yielder&                yielder;
+    bool                            aborted = false;
+};
+
+static int Jx9_interrupt(void* data) {
+    auto interrupt = static_cast<Jx9Interrupt*>(data);
+    interrupt->aborted = interrupt->context.interrupted();
+    if(!interrupt->aborted) interrupt->yielder.tick(s_interrupt_period);
+    return interrupt->aborted;
+}
+
+// poesie_yield(), lets long computations explicitly share the execution stream
+static int Poesie_yield(jx9_context* ctx, int argc, jx9_value** argv) {
+    (void)argc;
+    (void)argv;
+    thallium::thread::yield();
+    jx9_result_null(ctx);
+    return JX9_OK;
+}
+
+// memory_view_slice(view, offset, size)
+static int MemoryView_slice(jx9_context* ctx, int argc, jx9_value** argv) {
+    auto execution = static_cast<Jx9Execution*>(jx9_context_user_data(ctx));
+    if(argc != 3 || !execution->view(argv[0])) {
+        jx9_result_null(ctx);
+        return JX9_OK;
+    }
+    auto view   = execution->view(argv[0]);
+    auto offset = jx9_value_to_int64(argv[1]);
+    auto size   = jx9_value_to_int64(argv[2]);
+    if(!view || offset < 0 || size < 0 || (size_t)offset > view->size()
+    || (size_t)size > view->size() - (size_t)offset) {
+        jx9_result_null(ctx);
+        return JX9_OK;
+    }
+    jx9_result_resource(ctx, execution->add(std::make_unique<poesie::MemoryView>(view->slice(offset, size))));
+    return JX9_OK;
+}
+
+// memory_view_from_file(path, [offset, [size, [writable]]])
+static int MemoryView_from_file(jx9_context* ctx, int argc, jx9_value** argv) {
+    if(argc < 1 || argc > 4 || !jx9_value_is_string(argv[0])) {
+        jx9_result_null(ctx);
+        return JX9_OK;
+    }
+    auto execution = static_cast<Jx9Execution*>(jx9_context_user_data(ctx));
+    std::string path = jx9_value_to_string(argv[0], nullptr);
+    size_t offset = argc > 1 ? jx9_value_to_int64(argv[1]) : 0;
+    std::optional<size_t> size;
+    if(argc > 2 && !jx9_value_is_null(argv[2])) size = jx9_value_to_int64(argv[2]);
+    auto intent = argc > 3 && jx9_value_to_bool(argv[3]) ? poesie::MemoryView::Intent::INOUT
+                                                         : poesie::MemoryView::Intent::IN;
+    std::unique_ptr<poesie::MemoryView> view;
+    try {
+        view = std::make_unique<poesie::MemoryView>(
+            poesie::MemoryView::FromFile(execution->engine, path, offset, size, intent));
+    } catch(const std::exception& ex) {
+        jx9_context_throw_error(ctx, JX9_CTX_WARNING, ex.what());
+        jx9_result_null(ctx);
+        return JX9_OK;
+    }
+    jx9_result_resource(ctx, execution->add(std::move(view)));
+    return JX9_OK;
+}
+
+// memory_view_decompress(view, codec, [dst]) decompresses a view into dst and
+// returns the decompressed size, or into a new local view if dst is not provided
+static int MemoryView_decompress(jx9_context* ctx, int argc, jx9_value** argv) {
+    auto execution = static_cast<Jx9Execution*>(jx9_context_user_data(ctx));
+    if(argc < 2 || argc > 3 || !jx9_value_is_string(argv[1])) {
+        jx9_result_null(ctx);
+        return JX9_OK;
+    }
+    auto src = execution->view(argv[0]);
+    auto dst = argc > 2 && !jx9_value_is_null(argv[2]) ? execution->view(argv[2]) : nullptr;
+    if(!src || (argc > 2 && !jx9_value_is_null(argv[2]) && !dst)) {
+        jx9_result_null(ctx);
+        return JX9_OK;
+    }
+    std::string codec = jx9_value_to_string(argv[1], nullptr);
+    std::unique_ptr<poesie::MemoryView> view;
+    size_t size = 0;
+    try {
+        auto src_data = src->access(0, src->size());
+        if(dst) {
+            size = poesie::compression::decompress(codec, src_data, src->size(),
+                dst->access(0, dst->size(), true), dst->size());
+        } else {
+            view = std::make_unique<poesie::MemoryView>(
+                poesie::compression::decompress(execution->engine, codec, src_data, src->size()));
+        }
+    } catch(const std::exception& ex) {
+        jx9_context_throw_error(ctx, JX9_CTX_WARNING, ex.what());
+        jx9_result_null(ctx);
+        return JX9_OK;
+    }
+    if(!view) {
+        jx9_result_int64(ctx, size);
+        return JX9_OK;
+    }
+    jx9_result_resource(ctx, execution->add(std::move(view)));
+    return JX9_OK;
+}
+
+// memory_view_hasher(algorithm) returns a hasher, memory_view_hasher_update(hasher,
+// view, begin, end) adds the bytes from begin (inclusive) to end (exclusive) of a
+// view to the hashed content (e.g. each chunk of a streamed view as it is received),
+// and memory_view_hasher_digest(hasher) returns the hash of the content added so far
+static int MemoryView_hasher(jx9_context* ctx, int argc, jx9_value** argv) {
+    if(argc != 1 || !jx9_value_is_string(argv[0])) {
+        jx9_result_null(ctx);
+        return JX9_OK;
+    }
+    auto execution = static_cast<Jx9Execution*>(jx9_context_user_data(ctx));
+    std::unique_ptr<poesie::hashing::Hasher> hasher;
+    try {
+        hasher = poesie::hashing::Hasher::Create(jx9_value_to_string(argv[0], nullptr));
+    } catch(const std::exception& ex) {
+        jx9_context_throw_error(ctx, JX9_CTX_WARNING, ex.what());
+        jx9_result_null(ctx);
+        return JX9_OK;
+    }
+    jx9_result_resource(ctx, execution->add(std::move(hasher)));
+    return JX9_OK;
+}
+
+static int MemoryView_hasher_update(jx9_context* ctx, int argc, jx9_value** argv) {
+    auto execution = static_cast<Jx9Execution*>(jx9_context_user_data(ctx));
+    if(argc != 4) {
+        jx9_result_bool(ctx, 0);
+        return JX9_OK;
+    }
+    auto hasher = execution->hasher(argv[0]);
+    auto view   = execution->view(argv[1]);
+    auto begin  = jx9_value_to_int64(argv[2]);
+    auto end    = jx9_value_to_int64(argv[3]);
+    if(!hasher || !view || begin < 0 || begin > end || end > (int64_t)view->size()) {
+        jx9_result_bool(ctx, 0);
+        return JX9_OK;
+    }
+    try {
+        hasher->update(view->access(begin, end - begin), end - begin);
+    } catch(const std::exception& ex) {
+        jx9_context_throw_error(ctx, JX9_CTX_WARNING, ex.what());
+        jx9_result_bool(ctx, 0);
+        return JX9_OK;
+    }
+    jx9_result_bool(ctx, 1);
+    return JX9_OK;
+}
+
+static int MemoryView_hasher_digest(jx9_context* ctx, int argc, jx9_value** argv) {
+    auto execution = static_cast<Jx9Execution*>(jx9_context_user_data(ctx));
+    auto hasher = argc == 1 ? execution->hasher(argv[0]) : nullptr;
+    if(!hasher) {
+        jx9_result_null(ctx);
+        return JX9_OK;
+    }
+    auto digest = hasher->hexdigest();
+    jx9_result_string(ctx, digest.data(), (int)digest.size());
+    return JX9_OK;
+}
+
 POESIE_REGISTER_BACKEND(jx9, Jx9Vm);
 
 Jx9Vm::Jx9Vm(thallium::engine engine, const json& config)
 : m_engine(std::move(engine))
-, m_config(config) {
+, m_config(config)
+, m_yielder(config) {
     int rc = jx9_init(&m_jx9_engine);
     if (rc != JX9_OK) {
         throw poesie::Exception("Failed to initialize Jx9 engine");
@@ -252,6 +626,17 @@ Jx9Vm::Jx9Vm(thallium::engine engine, const json& config)
     install("memory_view_to_string", MemoryView_to_string, 1);
     install("memory_view_get", MemoryView_get, 2);
     install("memory_view_set", MemoryView_set, 3);
+    install("memory_view_chunk_size", MemoryView_chunk_size, 1);
+    install("memory_view_wait", MemoryView_wait, 3);
+    install("memory_view_segments", MemoryView_segments, 1);
+    install("memory_view_reduce", MemoryView_reduce, 3);
+    install("memory_view_count", MemoryView_count, 2);
+    install("memory_view_find", MemoryView_find, 3);
+    install("memory_view_histogram", MemoryView_histogram, 1);
+    install("memory_view_byteswap", MemoryView_byteswap, 2);
+    install("memory_view_hash", MemoryView_hash, 4);
+    install("memory_view_compress_bound", MemoryView_compress_bound, 2);
+    install("memory_view_compress", MemoryView_compress, 4);
 }
 
 Jx9Vm::~Jx9Vm() {
@@ -266,10 +651,11 @@ std::string Jx9Vm::getConfig() const {
 
 poesie::Result<json> Jx9Vm::execute(
         std::string_view code,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     std::unique_lock<thallium::mutex> guard{m_mtx};
-    std::vector<std::unique_ptr<poesie::MemoryView>> createdViews;
+    Jx9Execution execution{m_engine};
 
     int rc;
     jx9_vm* pJx9VM = nullptr;
@@ -291,7 +677,7 @@ poesie::Result<json> Jx9Vm::execute(
     }
 
     // Install __global__ variable
-    jx9_value* pGlobal = JSONtoJx9Value(m_engine, pJx9VM, m_global, createdViews);
+    jx9_value* pGlobal = JSONtoJx9Value(m_engine, pJx9VM, m_global, execution);
     if(pGlobal) {
         rc = jx9_vm_config(pJx9VM, JX9_VM_CONFIG_CREATE_VAR, "__global__", pGlobal);
         // Release the jx9_value as it has been copied into the VM
@@ -313,7 +699,7 @@ poesie::Result<json> Jx9Vm::execute(
     std::vector<json> argv;
     argv.push_back("poesie");
     argv.insert(argv.end(), args.begin(), args.end());
-    jx9_value* pArgv = JSONtoJx9Value(m_engine, pJx9VM, argv, createdViews);
+    jx9_value* pArgv = JSONtoJx9Value(m_engine, pJx9VM, argv, execution);
     if(pArgv) {
         rc = jx9_vm_config(pJx9VM, JX9_VM_CONFIG_CREATE_VAR, "__argv__", pArgv);
         // Release the jx9_value as it has been copied into the VM
@@ -333,6 +719,7 @@ poesie::Result<json> Jx9Vm::execute(
 
     for(auto& p : m_ffuncs) {
         auto holder_ptr = p.second.get();
+        holder_ptr->execution = &execution;
         auto& name = p.first;
         rc = jx9_create_function(pJx9VM, name.c_str(), FunctionHolder::binding, holder_ptr);
         if (rc != JX9_OK) {
@@ -344,8 +731,40 @@ poesie::Result<json> Jx9Vm::execute(
         }
     }
 
+    rc = jx9_create_function(pJx9VM, "memory_view_slice", MemoryView_slice, &execution);
+    if (rc == JX9_OK)
+        rc = jx9_create_function(pJx9VM, "memory_view_from_file", MemoryView_from_file, &execution);
+    if (rc == JX9_OK)
+        rc = jx9_create_function(pJx9VM, "memory_view_decompress", MemoryView_decompress, &execution);
+    if (rc == JX9_OK)
+        rc = jx9_create_function(pJx9VM, "memory_view_hasher", MemoryView_hasher, &execution);
+    if (rc == JX9_OK)
+        rc = jx9_create_function(pJx9VM, "memory_view_hasher_update", MemoryView_hasher_update, &execution);
+    if (rc == JX9_OK)
+        rc = jx9_create_function(pJx9VM, "memory_view_hasher_digest", MemoryView_hasher_digest, &execution);
+    if (rc == JX9_OK)
+        rc = jx9_create_function(pJx9VM, "poesie_yield", Poesie_yield, nullptr);
+    if (rc != JX9_OK) {
+        result.success() = false;
+        result.error() = "Failed to install builtin functions";
+        jx9_vm_release(pJx9VM);
+        return result;
+    }
+
+    Jx9Interrupt interrupt{context, m_yielder};
+    if (context.interruptible() || m_yielder.interval())
+        jx9_vm_config(pJx9VM, JX9_VM_CONFIG_INTERRUPT_HOOK, Jx9_interrupt, &interrupt);
+
     // Execute the script
     rc = jx9_vm_exec(pJx9VM, nullptr);
+    if (interrupt.aborted) {
+        // the script was aborted, its changes to __global__ are discarded
+        result.success() = false;
+        result.error() = "Failed to execute Jx9 code: ";
+        result.error() += context.reason();
+        jx9_vm_release(pJx9VM);
+        return result;
+    }
     if (rc != JX9_OK) {
         const char* errBuf;
         int iLen;
@@ -357,6 +776,9 @@ poesie::Result<json> Jx9Vm::execute(
         return result;
     }
 
+    // Push the views back while the results are extracted
+    for(auto& view : execution.createdViews) view->writeBack();
+
     // Extract VM return value
     jx9_value* ret_value;
     rc = jx9_vm_config(pJx9VM, JX9_VM_CONFIG_EXEC_VALUE, &ret_value);
@@ -366,12 +788,12 @@ poesie::Result<json> Jx9Vm::execute(
         jx9_vm_release(pJx9VM);
         return result;
     }
-    result.value() = Jx9ValueToJSON(ret_value);
+    result.value() = Jx9ValueToJSON(ret_value, execution);
 
     // Try to extract the __global__ variable
     pGlobal = jx9_vm_extract_variable(pJx9VM, "__global__");
     if (pGlobal != nullptr) {
-        m_global = Jx9ValueToJSON(pGlobal);
+        m_global = Jx9ValueToJSON(pGlobal, execution);
         jx9_release_value(pJx9VM, pGlobal);
     } else {
         m_global = json::object();
@@ -384,7 +806,8 @@ poesie::Result<json> Jx9Vm::execute(
 
 poesie::Result<json> Jx9Vm::load(
         std::string_view filename,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     std::ifstream file{std::string(filename)};
     if (!file) {
@@ -396,14 +819,15 @@ poesie::Result<json> Jx9Vm::load(
     std::stringstream buffer;
     buffer << file.rdbuf();
     std::string code = buffer.str();
-    result = execute(code, args);
+    result = execute(code, args, context);
     return result;
 }
 
 poesie::Result<json> Jx9Vm::call(
         std::string_view function,
         std::string_view target,
-        const std::vector<nlohmann::json>& args) {
+        const std::vector<nlohmann::json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     std::stringstream code;
     code << "return "
@@ -411,11 +835,11 @@ poesie::Result<json> Jx9Vm::call(
          << '(';
     if(!target.empty())
         code << target << ',';
-    for(size_t i = 0; i < args; ++i) {
+    for(size_t i = 0; i < args.size(); ++i) {
         code << args[i].dump() << (i == args.size()-1 ? ' ' : ',');
     }
     code << ");";
-    return execute(code.str(), {});
+    return execute(code.str(), {}, context);
 }
 
 /**
@@ -446,7 +870,7 @@ std::unique_ptr<poesie::Backend> Jx9Vm::create(const thallium::engine& engine, c
 
 int Jx9Vm::FunctionHolder::binding(jx9_context* pCtx, int argc, jx9_value** argv) {
     auto holder_ptr = static_cast<FunctionHolder*>(jx9_context_user_data(pCtx));
-    if (!holder_ptr) {
+    if (!holder_ptr || !holder_ptr->execution) {
         jx9_context_throw_error(pCtx, JX9_CTX_ERR, "Internal function holder is null");
         return JX9_CTX_ERR;
     }
@@ -459,7 +883,7 @@ int Jx9Vm::FunctionHolder::binding(jx9_context* pCtx, int argc, jx9_value** argv
     // Convert Jx9 values to JSON
     std::vector<json> args;
     for (int i = 0; i < argc; ++i) {
-        args.push_back(Jx9ValueToJSON(argv[i]));
+        args.push_back(Jx9ValueToJSON(argv[i], *holder_ptr->execution));
     }
 
     // Call the C++ function
@@ -12,6 +12,8 @@
 
 using json = nlohmann::json;
 
+struct Jx9Execution;
+
 /**
  * Jx9 implementation of an poesie Backend.
  */
@@ -19,8 +21,9 @@ class Jx9Vm : public poesie::Backend {
 
     struct FunctionHolder {
 
-        ForeignFn func;
-        size_t    expected_args;
+        ForeignFn           func;
+        size_t              expected_args;
+        const Jx9Execution* execution = nullptr; // set while a script runs
 
         FunctionHolder(
                 std::function<json(const std::vector<json>)> f,
@@ -39,6 +42,7 @@ class Jx9Vm : public poesie::Backend {
     thallium::mutex   m_mtx;
     jx9*              m_jx9_engine = nullptr;
     std::string       m_preamble;
+    poesie::Yielder   m_yielder;
     std::unordered_map<std::string, std::unique_ptr<FunctionHolder>> m_ffuncs;
 
     public:
@@ -78,19 +82,26 @@ class Jx9Vm : public poesie::Backend {
      */
     std::string getConfig() const override;
 
+    // overloads running without an ExecutionContext
+    using poesie::Backend::execute;
+    using poesie::Backend::load;
+    using poesie::Backend::call;
+
     /**
      * @see Backend::execute
      */
     poesie::Result<json> execute(
             std::string_view code,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::load
      */
     poesie::Result<json> load(
             std::string_view filename,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::call.
@@ -98,7 +109,8 @@ class Jx9Vm : public poesie::Backend {
     poesie::Result<json> call(
           std::string_view function,
           std::string_view target,
-          const std::vector<json>& args) override;
+          const std::vector<json>& args,
+          const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::install.
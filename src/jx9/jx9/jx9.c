@@ -477,6 +477,7 @@ typedef sxi64 jx9_int64;
 #define JX9_VM_CONFIG_IO_STREAM       11  /* ONE ARGUMENT: const jx9_io_stream *pStream */
 #define JX9_VM_CONFIG_ARGV_ENTRY      12  /* ONE ARGUMENT: const char *zValue */
 #define JX9_VM_CONFIG_EXTRACT_OUTPUT  13  /* TWO ARGUMENTS: const void **ppOut, unsigned int *pOutputLen */
+#define JX9_VM_CONFIG_INTERRUPT_HOOK  14  /* TWO ARGUMENTS: int (*xInterrupt)(void *pUserData), void *pUserData */
 /*
  * Global Library Configuration Commands.
  *
@@ -1963,10 +1964,18 @@ struct jx9_vm
 	int iAssertFlags;          /* Assertion flags */
 	jx9_value sAssertCallback; /* Callback to call on failed assertions */
 	sxi32 iExitStatus;         /* Script exit status */
+	int (*xInterrupt)(void *); /* Polled periodically, aborts the script when returning non-zero */
+	void *pInterruptData;      /* Last argument to xInterrupt() */
+	sxu32 nInterruptCounter;   /* Instructions executed since xInterrupt() was last polled */
 	jx9_gen_state sCodeGen;    /* Code generator module */
 	jx9_vm *pNext, *pPrev;      /* List of active VM's */
 	sxu32 nMagic;              /* Sanity check against misuse */
 };
+/*
+ * Number of instructions between two calls to the interrupt
+ * callback installed with JX9_VM_CONFIG_INTERRUPT_HOOK.
+ */
+#define JX9_VM_INTERRUPT_PERIOD 1024
 /*
  * Allowed value for jx9_vm.nMagic
  */
@@ -3988,6 +3997,13 @@ JX9_PRIVATE sxi32 jx9VmConfigure(
 		rc = SySetPut(&pVm->aIOstream, (const void *)&pStream);
 		break;
 								  }
+	case JX9_VM_CONFIG_INTERRUPT_HOOK: {
+		/* Callback polled every JX9_VM_INTERRUPT_PERIOD instructions */
+		pVm->xInterrupt = va_arg(ap, int (*)(void *));
+		pVm->pInterruptData = va_arg(ap, void *);
+		pVm->nInterruptCounter = 0;
+		break;
+										}
 	case JX9_VM_CONFIG_EXTRACT_OUTPUT: {
 		/* Point to the VM internal output consumer buffer */
 		const void **ppOut = va_arg(ap, const void **);
@@ -4263,6 +4279,13 @@ static sxi32 VmByteCodeExec(
 		/* Fetch the instruction to execute */
 		pInstr = &aInstr[pc];
 		rc = SXRET_OK;
+		/* Give the host application a chance to abort the script */
+		if( pVm->xInterrupt && ++pVm->nInterruptCounter >= JX9_VM_INTERRUPT_PERIOD ){
+			pVm->nInterruptCounter = 0;
+			if( pVm->xInterrupt(pVm->pInterruptData) ){
+				goto Abort;
+			}
+		}
 /*
  * What follows here is a massive switch statement where each case implements a
  * separate instruction in the virtual machine.  If we follow the usual
@@ -398,6 +398,7 @@ typedef sxi64 jx9_int64;
 #define JX9_VM_CONFIG_IO_STREAM       11  /* ONE ARGUMENT: const jx9_io_stream *pStream */
 #define JX9_VM_CONFIG_ARGV_ENTRY      12  /* ONE ARGUMENT: const char *zValue */
 #define JX9_VM_CONFIG_EXTRACT_OUTPUT  13  /* TWO ARGUMENTS: const void **ppOut, unsigned int *pOutputLen */
+#define JX9_VM_CONFIG_INTERRUPT_HOOK  14  /* TWO ARGUMENTS: int (*xInterrupt)(void *pUserData), void *pUserData */
 /*
  * Global Library Configuration Commands.
  *
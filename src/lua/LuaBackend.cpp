@@ -5,6 +5,9 @@
  */
 #include "LuaBackend.hpp"
 #include "poesie/MemoryView.hpp"
+#include "../Kernels.hpp"
+#include "../Compression.hpp"
+#include "../Hashing.hpp"
 #include <sol/sol.hpp>
 #include <iostream>
 
@@ -12,9 +15,76 @@
 #include <nlohmann/json.hpp>
 #include <iostream>
 #include "memory/luamem.h"
+#include <unordered_map>
+#include <mutex>
+#include <algorithm>
 
 extern "C" int luaopen_memory(lua_State *L);
 
+// access hook of the memory references created for streamed, lazy, and
+// write-tracking MemoryViews, called by the memory library before it touches their bytes
+static void memoryViewAccess(lua_State* L, char* mem, size_t, size_t i, size_t j, int write) {
+    bool ok = true;
+    {
+        auto view = poesie::MemoryView::FromData(mem);
+        if(view) {
+            try {
+                view.access(mem - view.rawData() + i, j - i, write);
+            } catch(const std::exception&) {
+                ok = false;
+            }
+        }
+    }
+    if(!ok) luaL_error(L, "failed to access MemoryView data");
+}
+
+// MemoryViews created by scripts (memory_view_from_file, memory_view_decompress),
+// released when their memory reference is garbage-collected
+static std::mutex s_owned_views_mtx;
+static std::unordered_map<const void*, poesie::MemoryView> s_owned_views;
+
+static void releaseOwnedView(lua_State*, void* mem, size_t) {
+    std::lock_guard<std::mutex> lock{s_owned_views_mtx};
+    s_owned_views.erase(mem);
+}
+
+static sol::object pushOwnedView(lua_State* L, poesie::MemoryView view) {
+    auto data = view.rawData();
+    auto size = view.size();
+    {
+        std::lock_guard<std::mutex> lock{s_owned_views_mtx};
+        s_owned_views.emplace(data, std::move(view));
+    }
+    luamem_newref(L);
+    int ref_idx = lua_gettop(L);
+    luamem_setref(L, ref_idx, data, size, releaseOwnedView);
+    return sol::object{L, ref_idx};
+}
+
+// data of a memory reference passed to a native kernel, made
+// available if it belongs to a streamed or lazy MemoryView
+static char* memoryViewKernelData(lua_State* L, int idx, size_t* size, bool write = false) {
+    auto data = luamem_checkmemory(L, idx, size);
+    auto view = poesie::MemoryView::FromData(data);
+    if(view && *size) view.access(data - view.rawData(), *size, write);
+    return data;
+}
+
+// bytes first..last (default: all) of a memory reference passed to a native
+// kernel, made available if they belong to a streamed or lazy MemoryView
+static std::pair<char*, size_t> memoryViewKernelRange(lua_State* L, int idx,
+        sol::optional<size_t> first, sol::optional<size_t> last) {
+    size_t size = 0;
+    auto data = luamem_checkmemory(L, idx, &size);
+    auto i = first.value_or(1);
+    auto j = last.value_or(size);
+    if(i < 1 || j > size || i > j + 1)
+        throw poesie::Exception{"Invalid range of memory"};
+    auto view = poesie::MemoryView::FromData(data);
+    if(view && i <= j) view.access(data - view.rawData() + i - 1, j - i + 1);
+    return {data + i - 1, j + 1 - i};
+}
+
 static nlohmann::json LuaObjectToJSON(const sol::object& data) {
     nlohmann::json result;
 
@@ -133,7 +203,9 @@ static sol::object JSONToLuaObject(
             luamem_newref(L);
             int ref_idx = lua_gettop(L);
             static auto cleanup = [](lua_State*, void*, size_t) {};
-            luamem_setref(L, ref_idx, view.data(), view.size(), cleanup);
+            luamem_setref(L, ref_idx, view.rawData(), view.size(), cleanup);
+            if(view.numChunks() > 1 || view.tracksWrites())
+                luamem_setaccess(L, ref_idx, memoryViewAccess);
             return sol::object{L, ref_idx};
         }
         default:
@@ -143,16 +215,28 @@ static sol::object JSONToLuaObject(
 
 POESIE_REGISTER_BACKEND(lua, LuaVm);
 
+// maximum number of instructions between two polls of the ExecutionContext
+static constexpr int s_interrupt_period = 1000;
+
+// registry key of the LuaVm owning a lua_State
+static const char* s_vm_key = "poesie_lua_vm";
+
 LuaVm::LuaVm(thallium::engine engine, const json& config)
 : m_engine(std::move(engine))
 , m_config(config)
-, m_lua_state(sol::state()) {
+, m_lua_state(sol::state())
+, m_yielder(config) {
     m_lua_state.open_libraries(
         sol::lib::base,
         sol::lib::math,
         sol::lib::string,
         sol::lib::package,
-        sol::lib::table);
+        sol::lib::table,
+        sol::lib::coroutine);
+    lua_pushlightuserdata(m_lua_state.lua_state(), this);
+    lua_setfield(m_lua_state.lua_state(), LUA_REGISTRYINDEX, s_vm_key);
+    // lets long computations explicitly share the execution stream
+    m_lua_state.set_function("poesie_yield", []() { thallium::thread::yield(); });
     if(m_config.is_object()) {
         std::vector<json> args;
         if(m_config.contains("preamble_argv")) {
@@ -179,6 +263,200 @@ LuaVm::LuaVm(thallium::engine engine, const json& config)
     }
     luaopen_memory(m_lua_state.lua_state());
     lua_setglobal(m_lua_state.lua_state(), "memory");
+    // streamed and lazy memory views are made available as they are accessed
+    // through the memory library; scripts may also wait for the bytes first..last
+    // of a view with memory_view_wait(view, first, last) or iterate over the
+    // view's chunks with "for first, last in memory_view_chunks(view) do ... end"
+    m_lua_state.set_function("memory_view_chunk_size",
+        [](sol::this_state L, sol::stack_object obj) -> size_t {
+            size_t size = 0;
+            auto data = luamem_checkmemory(L, obj.stack_index(), &size);
+            auto view = poesie::MemoryView::FromData(data);
+            return view ? view.chunkSize() : size;
+        });
+    m_lua_state.set_function("memory_view_wait",
+        [](sol::this_state L, sol::stack_object obj,
+           sol::optional<size_t> first, sol::optional<size_t> last) {
+            size_t size = 0;
+            auto data = luamem_checkmemory(L, obj.stack_index(), &size);
+            auto i = first.value_or(1);
+            auto j = last.value_or(size);
+            if(i < 1 || j > size)
+                throw poesie::Exception{"Invalid range in memory_view_wait"};
+            if(i > j) return;
+            auto view = poesie::MemoryView::FromData(data);
+            if(!view) return;
+            view.access(data - view.rawData() + i - 1, j - i + 1);
+        });
+    // memory views built from several client segments are seen as a single
+    // buffer; memory_view_segments(view) returns the list of {first, last}
+    // bytes of each segment
+    m_lua_state.set_function("memory_view_segments",
+        [](sol::this_state L, sol::stack_object obj) {
+            size_t size = 0;
+            auto data = luamem_checkmemory(L, obj.stack_index(), &size);
+            sol::state_view lua{L};
+            auto segments = lua.create_table();
+            auto view = poesie::MemoryView::FromData(data);
+            if(!view) {
+                segments.add(lua.create_table_with(1, 1, 2, size));
+                return segments;
+            }
+            size_t offset = data - view.rawData();
+            for(auto& segment : view.slice(offset, size).segments())
+                segments.add(lua.create_table_with(
+                    1, segment.first + 1, 2, segment.first + segment.second));
+            return segments;
+        });
+    // memory_view_slice(view, first, last) returns a memory reference to the
+    // bytes first..last of a view, sharing the view's data
+    m_lua_state.set_function("memory_view_slice",
+        [](sol::this_state L, sol::stack_object obj, size_t first, size_t last) {
+            size_t size = 0;
+            auto data = luamem_checkmemory(L, obj.stack_index(), &size);
+            if(first < 1 || last > size || first > last + 1)
+                throw poesie::Exception{"Invalid range in memory_view_slice"};
+            luamem_newref(L);
+            int ref_idx = lua_gettop(L);
+            static auto cleanup = [](lua_State*, void*, size_t) {};
+            luamem_setref(L, ref_idx, data + first - 1, last - first + 1, cleanup);
+            auto view = poesie::MemoryView::FromData(data);
+            if(view && (view.numChunks() > 1 || view.tracksWrites()))
+                luamem_setaccess(L, ref_idx, memoryViewAccess);
+            return sol::object{L, ref_idx};
+        });
+    // memory_view_from_file(path, [offset, [size, [writable]]]) maps a range of a
+    // local file and returns it as a memory reference (see MemoryView::FromFile)
+    m_lua_state.set_function("memory_view_from_file",
+        [engine=m_engine](sol::this_state L, const std::string& path, sol::optional<size_t> offset,
+                          sol::optional<size_t> size, sol::optional<bool> writable) {
+            auto view = poesie::MemoryView::FromFile(engine, path, offset.value_or(0),
+                size ? std::optional<size_t>{*size} : std::nullopt,
+                writable.value_or(false) ? poesie::MemoryView::Intent::INOUT
+                                         : poesie::MemoryView::Intent::IN);
+            return pushOwnedView(L, std::move(view));
+        });
+    // native kernels (see Kernels.hpp): memory_view_reduce(view, type, op),
+    // memory_view_count(view, byte), memory_view_find(view, pattern, [init])
+    // returning the position of the pattern or nil, memory_view_histogram(view)
+    // returning a table mapping byte values 0..255 to their number of
+    // occurrences, and memory_view_byteswap(view, width)
+    m_lua_state.set_function("memory_view_reduce",
+        [](sol::this_state L, sol::stack_object obj, const std::string& type, const std::string& op) {
+            size_t size = 0;
+            auto data = memoryViewKernelData(L, obj.stack_index(), &size);
+            auto result = poesie::kernels::reduce(data, size, type, op);
+            // integers are returned as Lua integers, unless they exceed
+            // the range of lua_Integer (u64 above 2^63-1)
+            if(result.is_number_unsigned() && result.get<uint64_t>() <= (uint64_t)LUA_MAXINTEGER)
+                return sol::make_object(L, result.get<lua_Integer>());
+            if(result.is_number_integer() && !result.is_number_unsigned())
+                return sol::make_object(L, result.get<lua_Integer>());
+            return sol::make_object(L, result.get<double>());
+        });
+    m_lua_state.set_function("memory_view_count",
+        [](sol::this_state L, sol::stack_object obj, uint8_t value) {
+            size_t size = 0;
+            auto data = memoryViewKernelData(L, obj.stack_index(), &size);
+            return poesie::kernels::count(data, size, value);
+        });
+    m_lua_state.set_function("memory_view_find",
+        [](sol::this_state L, sol::stack_object obj, const std::string& pattern,
+           sol::optional<size_t> init) -> sol::optional<size_t> {
+            size_t size = 0;
+            auto data = memoryViewKernelData(L, obj.stack_index(), &size);
+            auto start = init.value_or(1);
+            if(start < 1) start = 1;
+            auto pos = poesie::kernels::find(data, size, pattern, start - 1);
+            if(pos == std::string_view::npos) return sol::nullopt;
+            return pos + 1;
+        });
+    m_lua_state.set_function("memory_view_histogram",
+        [](sol::this_state L, sol::stack_object obj) {
+            size_t size = 0;
+            auto data = memoryViewKernelData(L, obj.stack_index(), &size);
+            auto counts = poesie::kernels::histogram(data, size);
+            sol::state_view lua{L};
+            auto histogram = lua.create_table(0, 256);
+            for(size_t b = 0; b < counts.size(); ++b)
+                histogram[b] = counts[b];
+            return histogram;
+        });
+    m_lua_state.set_function("memory_view_byteswap",
+        [](sol::this_state L, sol::stack_object obj, size_t width) {
+            size_t size = 0;
+            auto data = memoryViewKernelData(L, obj.stack_index(), &size, true);
+            poesie::kernels::byteswap(data, size, width);
+        });
+    // compression (see Compression.hpp): memory_view_compress(view, codec, dst, [level])
+    // compresses a view into dst and returns the compressed size, memory_view_decompress(
+    // view, codec, [dst]) decompresses a view into dst and returns the decompressed size,
+    // or into a new local memory reference if dst is not provided, and
+    // memory_view_compress_bound(codec, size) is the maximum size of compressed data
+    m_lua_state.set_function("memory_view_compress_bound",
+        [](const std::string& codec, size_t size) {
+            return poesie::compression::compressBound(codec, size);
+        });
+    m_lua_state.set_function("memory_view_compress",
+        [](sol::this_state L, sol::stack_object src, const std::string& codec,
+           sol::stack_object dst, sol::optional<int> level) {
+            size_t src_size = 0, dst_size = 0;
+            auto src_data = memoryViewKernelData(L, src.stack_index(), &src_size);
+            auto dst_data = memoryViewKernelData(L, dst.stack_index(), &dst_size, true);
+            return poesie::compression::compress(
+                codec, src_data, src_size, dst_data, dst_size, level.value_or(0));
+        });
+    m_lua_state.set_function("memory_view_decompress",
+        [engine=m_engine](sol::this_state L, sol::stack_object src, const std::string& codec,
+                          sol::optional<sol::stack_object> dst) -> sol::object {
+            size_t src_size = 0;
+            auto src_data = memoryViewKernelData(L, src.stack_index(), &src_size);
+            if(dst && dst->get_type() != sol::type::lua_nil) {
+                size_t dst_size = 0;
+                auto dst_data = memoryViewKernelData(L, dst->stack_index(), &dst_size, true);
+                return sol::make_object(L, poesie::compression::decompress(
+                    codec, src_data, src_size, dst_data, dst_size));
+            }
+            return pushOwnedView(L, poesie::compression::decompress(engine, codec, src_data, src_size));
+        });
+    // hashing (see Hashing.hpp): memory_view_hash(view, algorithm, [first, [last]])
+    // returns the hash of the bytes first..last of a view, and memory_view_hasher(
+    // algorithm) returns a hasher h on which h:update(view, [first, [last]]) adds
+    // bytes to the hashed content (e.g. each chunk of a streamed view as it is
+    // received) and h:digest() returns the hash of the content added so far
+    m_lua_state.new_usertype<poesie::hashing::Hasher>("MemoryViewHasher",
+        sol::no_constructor,
+        "update", [](poesie::hashing::Hasher& hasher, sol::this_state L, sol::stack_object obj,
+                     sol::optional<size_t> first, sol::optional<size_t> last) {
+            auto [data, size] = memoryViewKernelRange(L, obj.stack_index(), first, last);
+            hasher.update(data, size);
+        },
+        "digest", &poesie::hashing::Hasher::hexdigest);
+    m_lua_state.set_function("memory_view_hasher",
+        [](const std::string& algorithm) {
+            return poesie::hashing::Hasher::Create(algorithm);
+        });
+    m_lua_state.set_function("memory_view_hash",
+        [](sol::this_state L, sol::stack_object obj, const std::string& algorithm,
+           sol::optional<size_t> first, sol::optional<size_t> last) {
+            auto [data, size] = memoryViewKernelRange(L, obj.stack_index(), first, last);
+            return poesie::hashing::hash(algorithm, data, size);
+        });
+    m_lua_state.script(R"(
+        function memory_view_chunks(view)
+            local size = memory.len(view)
+            local chunk_size = memory_view_chunk_size(view)
+            local first = 1
+            return function()
+                if first > size then return nil end
+                local last = math.min(first + chunk_size - 1, size)
+                memory_view_wait(view, first, last)
+                local i = first
+                first = last + 1
+                return i, last
+            end
+        end
+    )");
 }
 
 std::string LuaVm::getConfig() const {
@@ -187,18 +465,20 @@ std::string LuaVm::getConfig() const {
 
 poesie::Result<json> LuaVm::execute(
         std::string_view code,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     std::unique_lock<thallium::mutex> guard{m_mtx};
     try {
         std::vector<poesie::MemoryView> createdViews;
         m_lua_state["arg"] = JSONToLuaObject(m_engine, args, m_lua_state, createdViews);
-        sol::protected_function_result r = m_lua_state.script(std::string(code));
-        if(r.valid()) {
-            result.value() = LuaObjectToJSON(r);
-        } else {
-            throw sol::error{r};
+        sol::load_result chunk = m_lua_state.load(std::string(code));
+        if(!chunk.valid()) {
+            sol::error err = chunk;
+            throw err;
         }
+        sol::protected_function script = chunk;
+        result.value() = run(guard, script, {}, createdViews, context);
     } catch (const sol::error& e) {
         result.error() = "Error executing Lua code: ";
         result.error() += e.what();
@@ -209,18 +489,20 @@ poesie::Result<json> LuaVm::execute(
 
 poesie::Result<json> LuaVm::load(
         std::string_view filename,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     std::unique_lock<thallium::mutex> guard{m_mtx};
     try {
         std::vector<poesie::MemoryView> createdViews;
         m_lua_state["arg"] = JSONToLuaObject(m_engine, args, m_lua_state, createdViews);
-        sol::protected_function_result r = m_lua_state.script_file(std::string(filename));
-        if(r.valid()) {
-            result.value() = LuaObjectToJSON(r);
-        } else {
-            throw sol::error{r};
+        sol::load_result chunk = m_lua_state.load_file(std::string(filename));
+        if(!chunk.valid()) {
+            sol::error err = chunk;
+            throw err;
         }
+        sol::protected_function script = chunk;
+        result.value() = run(guard, script, {}, createdViews, context);
     } catch (const sol::error& e) {
         result.error() = "Error executing Lua code: ";
         result.error() += e.what();
@@ -232,7 +514,8 @@ poesie::Result<json> LuaVm::load(
 poesie::Result<json> LuaVm::call(
         std::string_view function,
         std::string_view target,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     std::unique_lock<thallium::mutex> guard{m_mtx};
     try {
@@ -243,12 +526,7 @@ poesie::Result<json> LuaVm::call(
         }
         if(target.empty()) {
             sol::protected_function lua_function = m_lua_state[function];
-            sol::protected_function_result r = lua_function(sol::as_args(lua_args));
-            if(r.valid()) {
-                result.value() = LuaObjectToJSON(r);
-            } else {
-                throw sol::error{r};
-            }
+            result.value() = run(guard, lua_function, lua_args, createdViews, context);
         } else {
             sol::table lua_target = m_lua_state[target];
             if(!lua_target.valid()) {
@@ -262,12 +540,8 @@ poesie::Result<json> LuaVm::call(
                     result.success() = false;
                 } else {
                     sol::protected_function lua_function = lua_target[function];
-                    sol::protected_function_result r = lua_function(lua_target, sol::as_args(lua_args));
-                    if(r.valid()) {
-                        result.value() = LuaObjectToJSON(r);
-                    } else {
-                        throw sol::error{r};
-                    }
+                    lua_args.insert(lua_args.begin(), lua_target);
+                    result.value() = run(guard, lua_function, lua_args, createdViews, context);
                 }
             }
         }
@@ -312,6 +586,143 @@ poesie::Result<bool> LuaVm::install(
     return result;
 }
 
+/**
+ * @see Backend::installAsync.
+ */
+poesie::Result<bool> LuaVm::installAsync(
+        std::string_view name,
+        AsyncForeignFn function,
+        size_t nargs) {
+    poesie::Result<bool> result;
+    std::unique_lock<thallium::mutex> guard{m_mtx};
+    // The "start" function calls the foreign function and, if the caller
+    // runs in the coroutine of a request, keeps the ForeignFuture aside for
+    // LuaVm::run to wait on it. Otherwise (e.g. in a coroutine created by
+    // the script, whose yields belong to the script) it waits on the
+    // ForeignFuture right away.
+    auto start =
+        [func=std::move(function), nargs, this](sol::this_state state, sol::variadic_args args)
+        -> std::tuple<bool, sol::object> {
+        if (args.size() != nargs) {
+            throw std::runtime_error("Invalid number of arguments passed to function.");
+        }
+        std::vector<json> json_args;
+        json_args.reserve(nargs);
+        for (size_t i = 0; i < nargs; ++i) {
+            json_args.push_back(LuaObjectToJSON(args[i]));
+        }
+        auto future = func(json_args);
+        lua_State* L = state.lua_state();
+        if (m_runners.count(L) && lua_isyieldable(L)) {
+            m_pending[L] = std::move(future);
+            return {true, sol::make_object(L, sol::nil)};
+        }
+        std::vector<poesie::MemoryView> createdViews;
+        return {false, JSONToLuaObject(m_engine, future(), sol::state_view{L}, createdViews)};
+    };
+    // The wrapper is the function actually visible from scripts,
+    // it yields if "start" has left a ForeignFuture to wait on.
+    static const char* wrapper_code = R"(
+        local start, yield = ...
+        return function(...)
+            local pending, value = start(...)
+            if pending then
+                local ok, result = yield()
+                if not ok then error(result, 2) end
+                return result
+            end
+            return value
+        end
+    )";
+    try {
+        sol::table holder = m_lua_state.create_table();
+        holder["start"] = std::move(start);
+        sol::protected_function factory = m_lua_state.load(wrapper_code);
+        sol::object start_fn = holder["start"];
+        sol::object yield_fn = m_lua_state["coroutine"]["yield"];
+        sol::protected_function_result r = factory(start_fn, yield_fn);
+        if(!r.valid()) throw sol::error{r};
+        sol::function wrapper = r;
+        m_lua_state[name] = wrapper;
+    } catch (const sol::error& e) {
+        result.error() = "Could not install asynchronous function: ";
+        result.error() += e.what();
+        result.success() = false;
+    }
+    return result;
+}
+
+void LuaVm::countHook(lua_State* L, lua_Debug* ar) {
+    (void)ar;
+    lua_getfield(L, LUA_REGISTRYINDEX, s_vm_key);
+    auto vm = static_cast<LuaVm*>(lua_touserdata(L, -1));
+    lua_pop(L, 1);
+    if(!vm) return;
+    if(vm->m_context && vm->m_context->interrupted())
+        luaL_error(L, "%s", vm->m_context->reason().c_str());
+    vm->m_yielder.tick(lua_gethookcount(L));
+}
+
+json LuaVm::run(std::unique_lock<thallium::mutex>& guard,
+                const sol::protected_function& function,
+                const std::vector<sol::object>& args,
+                std::vector<poesie::MemoryView>& createdViews,
+                const poesie::ExecutionContext& context) {
+    sol::thread runner = sol::thread::create(m_lua_state.lua_state());
+    lua_State* L = runner.thread_state();
+    // coroutines created by the script inherit the hook
+    int period = s_interrupt_period;
+    if(m_yielder.interval())
+        period = static_cast<int>(std::min<size_t>(period, m_yielder.interval()));
+    if(context.interruptible() || m_yielder.interval())
+        lua_sethook(L, countHook, LUA_MASKCOUNT, period);
+    // the coroutine may be interrupted between an asynchronous
+    // function leaving its ForeignFuture and yielding
+    struct Cleanup {
+        LuaVm& vm; lua_State* L;
+        ~Cleanup() { vm.m_runners.erase(L); vm.m_pending.erase(L); }
+    } cleanup{*this, L};
+    m_runners.insert(L);
+    sol::coroutine co{L, function};
+    bool ok = true;
+    json value;
+    // "arg" is a global, which other requests may set while the coroutine
+    // is suspended, so it is restored before the coroutine is resumed
+    sol::object arg;
+    for(bool first = true; ; first = false) {
+        if(!first) m_lua_state["arg"] = arg;
+        m_context = &context;
+        sol::protected_function_result r = first ?
+            co(sol::as_args(args))
+          : co(ok, JSONToLuaObject(m_engine, value, m_lua_state, createdViews));
+        m_context = nullptr;
+        if(!r.valid()) {
+            if(context.interrupted()) throw sol::error{context.reason()};
+            throw sol::error{r};
+        }
+        if(r.status() != sol::call_status::yielded) {
+            // push the views back while the result is converted
+            for(auto& view : createdViews) view.writeBack();
+            return LuaObjectToJSON(r);
+        }
+        auto it = m_pending.find(L);
+        if(it == m_pending.end())
+            throw sol::error{"attempt to yield from outside a coroutine"};
+        auto future = std::move(it->second);
+        m_pending.erase(it);
+        arg = m_lua_state["arg"].get<sol::object>();
+        guard.unlock();
+        try {
+            value = future();
+            ok = true;
+        } catch(const std::exception& ex) {
+            value = ex.what();
+            ok = false;
+        }
+        guard.lock();
+    }
+}
+
 poesie::Result<bool> LuaVm::destroy() {
     poesie::Result<bool> result;
     result.value() = true;
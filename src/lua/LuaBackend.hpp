@@ -7,7 +7,10 @@
 #define __LUA_BACKEND_HPP
 
 #include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <poesie/Backend.hpp>
+#include <poesie/MemoryView.hpp>
 #include <sol/sol.hpp>
 
 using json = nlohmann::json;
@@ -21,6 +24,33 @@ class LuaVm : public poesie::Backend {
     json             m_config;
     thallium::mutex  m_mtx;
     sol::state       m_lua_state;
+    std::unordered_map<lua_State*, ForeignFuture> m_pending;
+    std::unordered_set<lua_State*>                m_runners;
+    const poesie::ExecutionContext* m_context = nullptr;
+    poesie::Yielder                 m_yielder;
+
+    /**
+     * @brief Run the function in a new coroutine, resuming it each
+     * time it yields because of an asynchronous foreign function.
+     * Any other yield of the coroutine is an error, as it would be
+     * outside of a coroutine.
+     * The VM's lock is released while waiting for the foreign function
+     * to complete, so that other requests can use the VM. If the context
+     * is interruptible, the coroutine is aborted once it is interrupted.
+     * The coroutine periodically yields the execution stream according
+     * to the "yield_interval" configuration.
+     */
+    json run(std::unique_lock<thallium::mutex>& guard,
+             const sol::protected_function& function,
+             const std::vector<sol::object>& args,
+             std::vector<poesie::MemoryView>& createdViews,
+             const poesie::ExecutionContext& context);
+
+    /**
+     * @brief Count hook polling the ExecutionContext of the running request
+     * and yielding the execution stream.
+     */
+    static void countHook(lua_State* L, lua_Debug* ar);
 
     public:
 
@@ -59,19 +89,26 @@ class LuaVm : public poesie::Backend {
      */
     std::string getConfig() const override;
 
+    // overloads running without an ExecutionContext
+    using poesie::Backend::execute;
+    using poesie::Backend::load;
+    using poesie::Backend::call;
+
     /**
      * @see Backend::execute
      */
     poesie::Result<json> execute(
             std::string_view code,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::load
      */
     poesie::Result<json> load(
             std::string_view filename,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::call.
@@ -79,7 +116,8 @@ class LuaVm : public poesie::Backend {
     poesie::Result<json> call(
             std::string_view function,
             std::string_view target,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::install.
@@ -89,6 +127,14 @@ class LuaVm : public poesie::Backend {
             ForeignFn function,
             size_t nargs) override;
 
+    /**
+     * @see Backend::installAsync.
+     */
+    poesie::Result<bool> installAsync(
+            std::string_view name,
+            AsyncForeignFn function,
+            size_t nargs) override;
+
     /**
      * @brief Destroys the underlying vm.
      *
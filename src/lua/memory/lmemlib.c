@@ -8,7 +8,7 @@
 
 static size_t posrelatI (lua_Integer pos, size_t len);
 static size_t getendpos (lua_State *L, int arg, lua_Integer def, size_t len);
-static int str2byte (lua_State *L, const char *s, size_t l);
+static int str2byte (lua_State *L, int arg, const char *s, size_t l);
 static void code2char (lua_State *L, int idx, char *p, size_t n);
 static const char *lmemfind (const char *s1, size_t l1,
                              const char *s2, size_t l2);
@@ -34,6 +34,7 @@ static int mem_create (lua_State *L) {
 				len = (pose-posi)+1;
 				if (posi+len <= pose)  /* arithmetic overflow? */
 					return luaL_error(L, "string slice too long");
+				luamem_access(L, 1, posi-1, pose, 0);
 				s += posi-1;
 			}
 		}
@@ -101,6 +102,7 @@ static int mem_tostring (lua_State *L) {
 	const char *s = luamem_checkarray(L, 1, &len);
 	size_t start = posrelatI(luaL_optinteger(L, 2, 1), len);
 	size_t end = getendpos(L, 3, -1, len);
+	if (start <= end) luamem_access(L, 1, start-1, end, 0);
 	if (start <= end) lua_pushlstring(L, s+start-1, (end-start)+1);
 	else lua_pushliteral(L, "");
 	return 1;
@@ -111,6 +113,8 @@ static int mem_diff (lua_State *L) {
 	const char *s1 = luamem_checkarray(L, 1, &l1);
 	const char *s2 = luamem_checkarray(L, 2, &l2);
 	size_t i, n=(l1<l2 ? l1 : l2);
+	luamem_access(L, 1, 0, l1, 0);
+	luamem_access(L, 2, 0, l2, 0);
 	for (i=0; (i<n) && (s1[i]==s2[i]); i++);
 	if (i<n) {
 		lua_pushinteger(L, i+1);
@@ -128,7 +132,7 @@ static int mem_diff (lua_State *L) {
 static int mem_get (lua_State *L) {
 	size_t len;
 	const char *s = luamem_checkmemory(L, 1, &len);
-	return str2byte(L, s, len);
+	return str2byte(L, 1, s, len);
 }
 
 static int mem_set (lua_State *L) {
@@ -138,6 +142,7 @@ static int mem_set (lua_State *L) {
 	size_t i = posrelatI(luaL_checkinteger(L, 2), len);
 	luaL_argcheck(L, 1 <= i && i <= len, 2, "index out of bounds");
 	len = 1+len-i;
+	luamem_access(L, 1, i-1, i-1+(n < len ? n : len), 1);
 	code2char(L, 3, p+i-1, n < len ? n : len);
 	return 0;
 }
@@ -155,6 +160,8 @@ static int mem_find (lua_State *L) {
 			return luaL_error(L, "string slice too long");
 		os--;
 		sl -= os;
+		luamem_access(L, 1, i-1, j, 0);
+		luamem_access(L, 2, os, os+sl, 0);
 		s = lmemfind(p+i-1, n, s+os, sl < n ? sl : n);
 		if (s) {
 			lua_pushinteger(L, (s-p)+1);
@@ -184,6 +191,8 @@ static int mem_fill (lua_State *L) {
 	}
 	if (i <= j && os <= sl) {
 		os--;
+		if (lua_type(L, 2) != LUA_TNUMBER) luamem_access(L, 2, os, sl, 0);
+		luamem_access(L, 1, i-1, j, 1);
 		memfill(p+i-1, j-i+1, s+os, sl-os);
 	}
 	return 0;
@@ -195,6 +204,8 @@ static int mem_concat (lua_State *L) {
 	const char *s2 = luamem_toarray(L, 2, &l2);
 	if (s1 && s2) {
 		luaL_Buffer B;
+		luamem_access(L, 1, 0, l1, 0);
+		luamem_access(L, 2, 0, l2, 0);
 		char *buff = luaL_buffinitsize(L, &B, l1+l2);
 		memcpy(buff, s1, l1*sizeof(char));
 		memcpy(buff+l1, s2, l2*sizeof(char));
@@ -325,7 +336,7 @@ static size_t getendpos (lua_State *L, int arg, lua_Integer def,
 	else return len + (size_t)pos + 1;
 }
 
-static int str2byte (lua_State *L, const char *s, size_t l) {
+static int str2byte (lua_State *L, int arg, const char *s, size_t l) {
 	lua_Integer pi = luaL_checkinteger(L, 2);
 	size_t posi = posrelatI(pi, l);
 	size_t pose = getendpos(L, 3, pi, l);
@@ -335,6 +346,7 @@ static int str2byte (lua_State *L, const char *s, size_t l) {
 		return luaL_error(L, "string slice too long");
 	n = (int)(pose -  posi) + 1;
 	luaL_checkstack(L, n, "string slice too long");
+	luamem_access(L, arg, posi-1, pose, 0);
 	for (i=0; i<n; i++)
 		lua_pushinteger(L, uchar(s[posi+i-1]));
 	return n;
@@ -656,6 +668,14 @@ static int mem_pack (lua_State *L) {
 		int size, ntoalign;
 		KOption opt = getdetails(&h, i, &fmt, &size, &ntoalign);
 		arg++;
+		/* alignment and padding bytes are skipped, but reported as written
+		   with the packed values so that tracked ranges stay contiguous */
+		if (opt == Kint || opt == Kuint || opt == Kfloat || opt == Kchar)
+			luamem_access(L, 1, i, i+ntoalign+size, 1);
+		else if (opt == Kpadding)
+			luamem_access(L, 1, i, i+ntoalign+1, 1);
+		else if (ntoalign > 0)
+			luamem_access(L, 1, i, i+ntoalign, 1);
 		if (!getbytes(&mem, &i, lb, ntoalign))  /* skip alignment */
 			return packfailed(L, i, arg);
 		switch (opt) {
@@ -695,6 +715,7 @@ static int mem_pack (lua_State *L) {
 				size_t len;
 				const char *s = luamem_checkarray(L, arg, &len);
 				luaL_argcheck(L, len == (size_t)size, arg, "wrong length");
+				luamem_access(L, arg, 0, len, 0);
 				if (!packstream(&mem, &i, lb, s, size))
 					return packfailed(L, i, arg);
 				break;
@@ -705,6 +726,8 @@ static int mem_pack (lua_State *L) {
 				luaL_argcheck(L, size >= (int)sizeof(size_t) ||
 				                 len < ((size_t)1 << (size * NB)),
 				                 arg, "string length does not fit in given size");
+				luamem_access(L, arg, 0, len, 0);
+				luamem_access(L, 1, i, i+size+len, 1);
 				if (!packint(&mem, &i, lb, (lua_Unsigned)len, h.islittle, size, 0) ||  /* pack length */
 				    !packstream(&mem, &i, lb, s, len))
 					return packfailed(L, i, arg);
@@ -713,8 +736,10 @@ static int mem_pack (lua_State *L) {
 			case Kzstr: {  /* zero-terminated string */
 				size_t len;
 				const char *s = luamem_checkarray(L, arg, &len);
+				luamem_access(L, arg, 0, len, 0);
 				luaL_argcheck(L, memchr(s, '\0', len) == NULL, arg,
 				                 "string contains zeros");
+				luamem_access(L, 1, i, i+len+1, 1);
 				if (!packstream(&mem, &i, lb, s, len) || !packchar(&mem, &i, lb, '\0'))
 					return packfailed(L, i, arg);
 				break;
@@ -783,6 +808,7 @@ static int mem_unpack (lua_State *L) {
 		luaL_argcheck(L, (size_t)ntoalign + size <= ld - pos, 2,
 		                "data string too short");
 		pos += ntoalign;  /* skip alignment */
+		luamem_access(L, 1, pos, pos+size, 0);
 		/* stack space for item + next position */
 		luaL_checkstack(L, 1, "too many results");
 		n++;
@@ -811,13 +837,16 @@ static int mem_unpack (lua_State *L) {
 			case Kstring: {
 				size_t len = (size_t)unpackint(L, data + pos, h.islittle, size, 0);
 				luaL_argcheck(L, len <= ld - pos - size, 2, "data string too short");
+				luamem_access(L, 1, pos + size, pos + size + len, 0);
 				lua_pushlstring(L, data + pos + size, len);
 				pos += len;  /* skip string */
 				break;
 			}
 			case Kzstr: {
 				size_t len;
-				const char *z = (const char *)memchr(data + pos, '\0', ld - pos);
+				const char *z;
+				luamem_access(L, 1, pos, ld, 0);
+				z = (const char *)memchr(data + pos, '\0', ld - pos);
 				luaL_argcheck(L, z, 2, "unfinished string for format 'z'");
 				len = (size_t)(z - data - pos);
 				lua_pushlstring(L, data + pos, len);
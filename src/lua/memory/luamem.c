@@ -18,6 +18,7 @@ typedef struct luamem_Ref {
 	char *mem;
 	size_t len;
 	luamem_Unref unref;
+	luamem_Access access;
 } luamem_Ref;
 
 #define unrefmem(L,r)	if (r->unref) ref->unref(L, r->mem, r->len)
@@ -29,6 +30,7 @@ static int refgc (lua_State *L) {
 		ref->mem = NULL;
 		ref->len = 0;
 		ref->unref = NULL;
+		ref->access = NULL;
 	}
 	return 0;
 }
@@ -44,6 +46,7 @@ LUAMEMLIB_API void luamem_newref (lua_State *L) {
 	ref->mem = NULL;
 	ref->len = 0;
 	ref->unref = NULL;
+	ref->access = NULL;
 	if (luaL_newmetatable(L, LUAMEM_REF)) luaL_setfuncs(L, refmt, 0);
 	lua_setmetatable(L, -2);
 }
@@ -56,6 +59,7 @@ LUAMEMLIB_API int luamem_resetref (lua_State *L, int idx,
 		if (mem != ref->mem) {
 			if (cleanup) unrefmem(L, ref);
 			ref->mem = mem;
+			ref->access = NULL;
 		}
 		ref->len = len;
 		ref->unref = unref;
@@ -64,6 +68,25 @@ LUAMEMLIB_API int luamem_resetref (lua_State *L, int idx,
 	return 0;
 }
 
+LUAMEMLIB_API int luamem_setaccess (lua_State *L, int idx,
+                                    luamem_Access access) {
+	luamem_Ref *ref = (luamem_Ref *)luaL_testudata(L, idx, LUAMEM_REF);
+	if (ref) {
+		ref->access = access;
+		return 1;
+	}
+	return 0;
+}
+
+LUAMEMLIB_API void luamem_access (lua_State *L, int idx,
+                                  size_t i, size_t j, int write) {
+	luamem_Ref *ref = (luamem_Ref *)luaL_testudata(L, idx, LUAMEM_REF);
+	if (ref && ref->access) {
+		if (j > ref->len) j = ref->len;
+		if (i < j) ref->access(L, ref->mem, ref->len, i, j, write);
+	}
+}
+
 LUAMEMLIB_API int luamem_type (lua_State *L, int idx) {
 	int type = LUAMEM_TNONE;
 	if (lua_type(L, idx) == LUA_TUSERDATA) {
@@ -38,6 +38,19 @@ LUAMEMLIB_API int (luamem_resetref) (lua_State *L, int idx,
 
 #define  luamem_setref(L,I,M,S,F) luamem_resetref(L,I,M,S,F,1)
 
+/*
+** Access hook of a referenced memory, called before the bytes
+** from 'i' (inclusive) to 'j' (exclusive) of the memory are read
+** ('write' == 0) or written ('write' != 0) by the memory library.
+*/
+typedef void (*luamem_Access) (lua_State *L, char *mem, size_t len,
+                               size_t i, size_t j, int write);
+
+LUAMEMLIB_API int (luamem_setaccess) (lua_State *L, int idx,
+                                      luamem_Access access);
+LUAMEMLIB_API void (luamem_access) (lua_State *L, int idx,
+                                    size_t i, size_t j, int write);
+
 LUAMEMLIB_API int (luamem_type) (lua_State *L, int idx);
 
 #define luamem_ismemory(L,I)	(luamem_type(L,I) != LUAMEM_TNONE)
@@ -5,13 +5,143 @@
  */
 #include <poesie/MemoryView.hpp>
 #include "PythonBackend.hpp"
+#include "../Kernels.hpp"
+#include "../Compression.hpp"
+#include "../Hashing.hpp"
 #include <pybind11/stl.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
 namespace py = pybind11;
 using json = nlohmann::json;
 
+// Python's memoryview gives scripts direct access to the memory, so views
+// that need to know which bytes are read or modified (lazy and write-tracking
+// views) are exposed as a TrackedMemoryView instead, which calls
+// MemoryView::access whenever it is indexed
+struct TrackedMemoryView {
+    char*  data;
+    size_t size;
+
+    char* access(size_t offset, size_t count, bool write) const {
+        auto view = poesie::MemoryView::FromData(data);
+        if(!view) throw py::value_error("MemoryView has been released");
+        py::gil_scoped_release release;
+        return view.access(data - view.rawData() + offset, count, write);
+    }
+
+    size_t index(ssize_t i) const {
+        if(i < 0) i += size;
+        if(i < 0 || (size_t)i >= size) throw py::index_error("index out of range");
+        return i;
+    }
+};
+
+// MemoryView created by a script (see memory_view_from_file and
+// memory_view_decompress), exposed through a memoryview that keeps it alive
+struct OwnedMemoryView {
+    poesie::MemoryView view;
+};
+
+// get the bytes from begin (inclusive) to end (exclusive) of a view passed
+// to a hashing function, once they are available (defined below)
+static std::pair<const char*, size_t> memory_view_hash_range(
+        const py::object& view, size_t begin, std::optional<size_t> end);
+
+PYBIND11_EMBEDDED_MODULE(poesie_memory, m) {
+    py::class_<TrackedMemoryView>(m, "TrackedMemoryView")
+        .def("__len__", [](const TrackedMemoryView& v) { return v.size; })
+        .def_property_readonly("nbytes", [](const TrackedMemoryView& v) { return v.size; })
+        .def("__getitem__", [](const TrackedMemoryView& v, ssize_t i) {
+            auto offset = v.index(i);
+            return (int)(uint8_t)*v.access(offset, 1, false);
+        })
+        .def("__getitem__", [](const TrackedMemoryView& v, py::slice slice) {
+            size_t start, stop, step, length;
+            if(!slice.compute(v.size, &start, &stop, &step, &length))
+                throw py::error_already_set();
+            std::string result(length, '\0');
+            if(length == 0) return py::bytes(result);
+            auto last = start + (length - 1)*step;
+            auto lo = std::min(start, last), hi = std::max(start, last) + 1;
+            v.access(lo, hi - lo, false);
+            for(size_t k = 0; k < length; ++k) result[k] = v.data[start + k*step];
+            return py::bytes(result);
+        })
+        .def("__setitem__", [](const TrackedMemoryView& v, ssize_t i, int b) {
+            auto offset = v.index(i);
+            if(b < 0 || b > 255) throw py::value_error("byte must be in range(0, 256)");
+            *v.access(offset, 1, true) = (char)b;
+        })
+        .def("__setitem__", [](const TrackedMemoryView& v, py::slice slice, py::buffer value) {
+            size_t start, stop, step, length;
+            if(!slice.compute(v.size, &start, &stop, &step, &length))
+                throw py::error_already_set();
+            auto info = value.request();
+            if((size_t)(info.size*info.itemsize) != length)
+                throw py::value_error("slice assignment cannot change the size of a MemoryView");
+            if(length == 0) return;
+            auto src  = static_cast<const char*>(info.ptr);
+            auto last = start + (length - 1)*step;
+            auto lo = std::min(start, last), hi = std::max(start, last) + 1;
+            v.access(lo, hi - lo, true);
+            for(size_t k = 0; k < length; ++k) v.data[start + k*step] = src[k];
+        })
+        .def("tobytes", [](const TrackedMemoryView& v) {
+            return py::bytes(v.access(0, v.size, false), v.size);
+        });
+    py::class_<poesie::hashing::Hasher>(m, "MemoryViewHasher")
+        .def("update", [](poesie::hashing::Hasher& hasher, py::object view,
+                          size_t begin, std::optional<size_t> end) {
+            auto [data, size] = memory_view_hash_range(view, begin, end);
+            py::gil_scoped_release release;
+            hasher.update(data, size);
+        }, py::arg("view"), py::arg("begin") = 0, py::arg("end") = py::none())
+        .def("digest", &poesie::hashing::Hasher::hexdigest);
+    py::class_<OwnedMemoryView>(m, "OwnedMemoryView", py::buffer_protocol())
+        .def_buffer([](OwnedMemoryView& v) {
+            return py::buffer_info((uint8_t*)v.view.rawData(), (ssize_t)v.view.size(),
+                                   v.view.intent() == poesie::MemoryView::Intent::IN);
+        });
+}
+
+// get the data and size of a view (a memoryview or a TrackedMemoryView)
+static std::pair<char*, size_t> memory_view_buffer(const py::object& view) {
+    if(py::isinstance<TrackedMemoryView>(view)) {
+        auto& tracked = view.cast<const TrackedMemoryView&>();
+        return {tracked.data, tracked.size};
+    }
+    auto info = view.cast<py::buffer>().request();
+    return {static_cast<char*>(info.ptr), (size_t)(info.size*info.itemsize)};
+}
+
+// get the data and size of a view passed to a native kernel, made
+// available if it belongs to a streamed or lazy MemoryView
+static std::pair<char*, size_t> memory_view_kernel_buffer(const py::object& view, bool write = false) {
+    auto [data, size] = memory_view_buffer(view);
+    auto mv = poesie::MemoryView::FromData(data);
+    if(mv && size) {
+        py::gil_scoped_release release;
+        mv.access(data - mv.rawData(), size, write);
+    }
+    return {data, size};
+}
+
+static std::pair<const char*, size_t> memory_view_hash_range(
+        const py::object& view, size_t begin, std::optional<size_t> end) {
+    auto [data, size] = memory_view_buffer(view);
+    auto last = end.value_or(size);
+    if(begin > last || last > size)
+        throw py::index_error("range out of bounds");
+    auto mv = poesie::MemoryView::FromData(data);
+    if(mv && begin < last) {
+        py::gil_scoped_release release;
+        mv.access(data - mv.rawData() + begin, last - begin);
+    }
+    return {data + begin, last - begin};
+}
+
 static inline py::object from_json(
         const thallium::engine& engine, const json& j,
         std::vector<poesie::MemoryView>& createdViews) {
@@ -47,7 +177,12 @@ static inline py::object from_json(
         // else, this is a MemoryView object
         auto view = poesie::MemoryView{engine, j};
         createdViews.push_back(view);
-        return py::memoryview::from_memory((void*)view.data(), (ssize_t)view.size(), false);
+        if(view.tracksWrites() || view.isLazy())
+            return py::cast(TrackedMemoryView{view.rawData(), view.size()});
+        // a memoryview gives direct access to the bytes, so all the
+        // chunks of a streamed view must be received before it is exposed
+        auto data = view.access(0, view.size());
+        return py::memoryview::from_memory((void*)data, (ssize_t)view.size(), false);
     }
     return py::none();
 }
@@ -107,6 +242,70 @@ static inline json to_json(const py::handle& obj)
         + py::repr(obj).cast<std::string>()};
 }
 
+// number of trace events (lines and calls) between two polls of the
+// ExecutionContext, reading the clock at every line would be expensive
+static constexpr size_t s_poll_period = 64;
+
+// installs interruptTrace for the duration of a scope
+struct InterruptTrace {
+    const poesie::ExecutionContext& context;
+    poesie::Yielder&                yielder;
+    size_t                          events  = 0;
+    bool                            tracing = false;
+
+    InterruptTrace(const poesie::ExecutionContext& c, poesie::Yielder& y)
+    : context(c)
+    , yielder(y) {
+        if(!context.interruptible() && !yielder.interval()) return;
+        auto obj = PyLong_FromVoidPtr(this);
+        // lines are traced (not only calls) so that loops
+        // that call no function can be interrupted too
+        PyEval_SetTrace(interruptTrace, obj);
+        tracing = true;
+        Py_DECREF(obj);
+    }
+
+    ~InterruptTrace() {
+        if(tracing) PyEval_SetTrace(nullptr, nullptr);
+    }
+
+    // trace function polling the ExecutionContext of the running request
+    // every s_poll_period lines or calls of the script, raising a
+    // TimeoutError once it is interrupted, and periodically yielding the
+    // execution stream (the GIL is kept, as other requests first wait
+    // for PythonVm::s_mtx)
+    static int interruptTrace(PyObject* obj, PyFrameObject* frame, int what, PyObject* arg) {
+        (void)frame;
+        (void)arg;
+        if(what != PyTrace_LINE && what != PyTrace_CALL) return 0;
+        auto trace = static_cast<InterruptTrace*>(PyLong_AsVoidPtr(obj));
+        if(!trace) return 0;
+        if(++trace->events % s_poll_period == 0 && trace->context.interrupted()) {
+            PyErr_SetString(PyExc_TimeoutError, trace->context.reason().c_str());
+            return -1;
+        }
+        trace->yielder.tick(1);
+        return 0;
+    }
+};
+
+// streamed memory views: views exposed as memoryviews are fully received
+// before the script runs, lazy and write-tracking views (TrackedMemoryView)
+// wait for the bytes they are indexed with; scripts may also wait for a
+// range of a view by calling memory_view_wait or iterate over its chunks
+// with "for begin, end in memory_view_chunks(view)"
+static const char* memoryViewChunks = R"(
+def memory_view_chunks(view):
+    size = view.nbytes
+    chunk_size = memory_view_chunk_size(view)
+    begin = 0
+    while begin < size:
+        end = min(begin + chunk_size, size)
+        memory_view_wait(view, begin, end)
+        yield begin, end
+        begin = end
+)";
+
 POESIE_REGISTER_BACKEND(python, PythonVm);
 
 ABT_mutex_memory PythonVm::s_mtx = ABT_MUTEX_INITIALIZER;
@@ -117,7 +316,186 @@ PythonVm::PythonVm(thallium::engine engine, const json& config)
 , m_mtx(ABT_MUTEX_MEMORY_GET_HANDLE(&s_mtx))
 , m_main_module(py::module::import("__main__"))
 , m_main_namespace(m_main_module.attr("__dict__"))
+, m_yielder(config)
 {
+    py::module::import("poesie_memory");
+    // lets long computations explicitly share the execution stream
+    m_main_namespace["poesie_yield"] = py::cpp_function{
+        []() { thallium::thread::yield(); }};
+    m_main_namespace["memory_view_chunk_size"] = py::cpp_function{
+        [](py::object view) -> size_t {
+            auto [data, size] = memory_view_buffer(view);
+            auto mv = poesie::MemoryView::FromData(data);
+            return mv ? mv.chunkSize() : size;
+        }};
+    m_main_namespace["memory_view_wait"] = py::cpp_function{
+        [](py::object view, size_t begin, std::optional<size_t> end) {
+            auto [data, size] = memory_view_buffer(view);
+            auto last = end.value_or(size);
+            if(last > size)
+                throw py::index_error("range out of bounds");
+            if(begin >= last) return;
+            auto mv = poesie::MemoryView::FromData(data);
+            if(!mv) return;
+            py::gil_scoped_release release;
+            mv.access(data - mv.rawData() + begin, last - begin);
+        }, py::arg("view"), py::arg("begin") = 0, py::arg("end") = py::none()};
+    // memory views built from several client segments are seen as a single
+    // buffer, memory_view_segments(view) lists the (begin, end) of each segment
+    m_main_namespace["memory_view_segments"] = py::cpp_function{
+        [](py::object view) {
+            auto [data, size] = memory_view_buffer(view);
+            auto mv = poesie::MemoryView::FromData(data);
+            py::list segments;
+            if(!mv) {
+                segments.append(py::make_tuple(0, size));
+                return segments;
+            }
+            for(auto& segment : mv.slice(data - mv.rawData(), size).segments())
+                segments.append(py::make_tuple(segment.first, segment.first + segment.second));
+            return segments;
+        }};
+    // memory_view_from_file(path, offset=0, size=None, writable=False) maps a range
+    // of a local file and returns it as a memoryview (see MemoryView::FromFile)
+    m_main_namespace["memory_view_from_file"] = py::cpp_function{
+        [engine=m_engine](const std::string& path, size_t offset,
+                          std::optional<size_t> size, bool writable) {
+            auto view = poesie::MemoryView::FromFile(engine, path, offset, size,
+                writable ? poesie::MemoryView::Intent::INOUT : poesie::MemoryView::Intent::IN);
+            return py::memoryview(py::cast(OwnedMemoryView{std::move(view)}));
+        }, py::arg("path"), py::arg("offset") = 0, py::arg("size") = py::none(),
+           py::arg("writable") = false};
+    // memory_view_slice(view, begin, end) returns a view of the bytes from
+    // begin (inclusive) to end (exclusive) of a view, sharing the view's data
+    m_main_namespace["memory_view_slice"] = py::cpp_function{
+        [](py::object view, size_t begin, size_t end) -> py::object {
+            auto [data, size] = memory_view_buffer(view);
+            if(begin > end || end > size)
+                throw py::index_error("range out of bounds");
+            if(py::isinstance<TrackedMemoryView>(view))
+                return py::cast(TrackedMemoryView{data + begin, end - begin});
+            return py::memoryview::from_memory((void*)(data + begin), (ssize_t)(end - begin), false);
+        }};
+    // native kernels (see Kernels.hpp): memory_view_reduce(view, type, op),
+    // memory_view_count(view, byte), memory_view_find(view, pattern, start=0)
+    // returning the index of the pattern or -1, memory_view_histogram(view)
+    // returning a list of 256 counts, and memory_view_byteswap(view, width)
+    m_main_namespace["memory_view_reduce"] = py::cpp_function{
+        [](py::object view, const std::string& type, const std::string& op) {
+            auto [data, size] = memory_view_kernel_buffer(view);
+            nlohmann::json result;
+            try {
+                py::gil_scoped_release release;
+                result = poesie::kernels::reduce(data, size, type, op);
+            } catch(const poesie::Exception& ex) {
+                throw py::value_error(ex.what());
+            }
+            // integers are returned as (exact) Python ints
+            if(result.is_number_unsigned()) return py::object(py::int_(result.get<uint64_t>()));
+            if(result.is_number_integer()) return py::object(py::int_(result.get<int64_t>()));
+            return py::object(py::float_(result.get<double>()));
+        }};
+    m_main_namespace["memory_view_count"] = py::cpp_function{
+        [](py::object view, int value) {
+            if(value < 0 || value > 255) throw py::value_error("byte must be in range(0, 256)");
+            auto [data, size] = memory_view_kernel_buffer(view);
+            py::gil_scoped_release release;
+            return poesie::kernels::count(data, size, value);
+        }};
+    m_main_namespace["memory_view_find"] = py::cpp_function{
+        [](py::object view, py::bytes pattern, size_t start) -> ssize_t {
+            auto [data, size] = memory_view_kernel_buffer(view);
+            std::string p = pattern;
+            py::gil_scoped_release release;
+            auto pos = poesie::kernels::find(data, size, p, start);
+            return pos == std::string_view::npos ? -1 : (ssize_t)pos;
+        }, py::arg("view"), py::arg("pattern"), py::arg("start") = 0};
+    m_main_namespace["memory_view_histogram"] = py::cpp_function{
+        [](py::object view) {
+            auto [data, size] = memory_view_kernel_buffer(view);
+            py::gil_scoped_release release;
+            return poesie::kernels::histogram(data, size);
+        }};
+    m_main_namespace["memory_view_byteswap"] = py::cpp_function{
+        [](py::object view, size_t width) {
+            auto [data, size] = memory_view_kernel_buffer(view, true);
+            try {
+                py::gil_scoped_release release;
+                poesie::kernels::byteswap(data, size, width);
+            } catch(const poesie::Exception& ex) {
+                throw py::value_error(ex.what());
+            }
+        }};
+    // hashing (see Hashing.hpp): memory_view_hash(view, algorithm, begin=0, end=None)
+    // returns the hash of the bytes from begin (inclusive) to end (exclusive) of a
+    // view, and memory_view_hasher(algorithm) returns a hasher h on which
+    // h.update(view, begin=0, end=None) adds bytes to the hashed content (e.g. each
+    // chunk of a streamed view as it is received) and h.digest() returns the hash
+    // of the content added so far
+    m_main_namespace["memory_view_hash"] = py::cpp_function{
+        [](py::object view, const std::string& algorithm, size_t begin, std::optional<size_t> end) {
+            auto [data, size] = memory_view_hash_range(view, begin, end);
+            try {
+                py::gil_scoped_release release;
+                return poesie::hashing::hash(algorithm, data, size);
+            } catch(const poesie::Exception& ex) {
+                throw py::value_error(ex.what());
+            }
+        }, py::arg("view"), py::arg("algorithm"), py::arg("begin") = 0, py::arg("end") = py::none()};
+    m_main_namespace["memory_view_hasher"] = py::cpp_function{
+        [](const std::string& algorithm) {
+            try {
+                return poesie::hashing::Hasher::Create(algorithm);
+            } catch(const poesie::Exception& ex) {
+                throw py::value_error(ex.what());
+            }
+        }};
+    // compression (see Compression.hpp): memory_view_compress(view, codec, dst, level=0)
+    // compresses a view into dst and returns the compressed size,
+    // memory_view_decompress(view, codec, dst=None) decompresses a view into dst and
+    // returns the decompressed size, or into a new memoryview if dst is None, and
+    // memory_view_compress_bound(codec, size) is the maximum size of compressed data
+    m_main_namespace["memory_view_compress_bound"] = py::cpp_function{
+        [](const std::string& codec, size_t size) {
+            try {
+                return poesie::compression::compressBound(codec, size);
+            } catch(const poesie::Exception& ex) {
+                throw py::value_error(ex.what());
+            }
+        }};
+    m_main_namespace["memory_view_compress"] = py::cpp_function{
+        [](py::object view, const std::string& codec, py::object dst, int level) {
+            auto [src_data, src_size] = memory_view_kernel_buffer(view);
+            auto [dst_data, dst_size] = memory_view_kernel_buffer(dst, true);
+            try {
+                py::gil_scoped_release release;
+                return poesie::compression::compress(
+                    codec, src_data, src_size, dst_data, dst_size, level);
+            } catch(const poesie::Exception& ex) {
+                throw py::value_error(ex.what());
+            }
+        }, py::arg("view"), py::arg("codec"), py::arg("dst"), py::arg("level") = 0};
+    m_main_namespace["memory_view_decompress"] = py::cpp_function{
+        [engine=m_engine](py::object view, const std::string& codec, py::object dst) -> py::object {
+            auto [src_data, src_size] = memory_view_kernel_buffer(view);
+            try {
+                if(!dst.is_none()) {
+                    auto [dst_data, dst_size] = memory_view_kernel_buffer(dst, true);
+                    py::gil_scoped_release release;
+                    return py::int_(poesie::compression::decompress(
+                        codec, src_data, src_size, dst_data, dst_size));
+                }
+                poesie::MemoryView result;
+                {
+                    py::gil_scoped_release release;
+                    result = poesie::compression::decompress(engine, codec, src_data, src_size);
+                }
+                return py::memoryview(py::cast(OwnedMemoryView{std::move(result)}));
+            } catch(const poesie::Exception& ex) {
+                throw py::value_error(ex.what());
+            }
+        }, py::arg("view"), py::arg("codec"), py::arg("dst") = py::none()};
+    py::exec(memoryViewChunks, m_main_namespace);
     if(m_config.is_object()) {
         std::vector<json> args;
         if(m_config.contains("preamble_argv")) {
@@ -150,7 +528,8 @@ std::string PythonVm::getConfig() const {
 
 poesie::Result<json> PythonVm::execute(
         std::string_view code,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     ABT_mutex_lock(m_mtx);
     try {
@@ -160,11 +539,13 @@ poesie::Result<json> PythonVm::execute(
         std::vector<poesie::MemoryView> createdViews;
         for(auto& arg : args) argv.append(from_json(m_engine, arg, createdViews));
         sys.attr("argv") = argv;
+        InterruptTrace trace{context, m_yielder};
         py::exec(code.data(), m_main_namespace);
     } catch (const py::error_already_set &e) {
         result.success() = false;
         result.error() = "Error running Python code: ";
-        result.error() += e.what();
+        if(context.interrupted()) result.error() += context.reason();
+        else result.error() += e.what();
     }
     ABT_mutex_unlock(m_mtx);
     return result;
@@ -172,7 +553,8 @@ poesie::Result<json> PythonVm::execute(
 
 poesie::Result<json> PythonVm::load(
         std::string_view filename,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     std::ifstream file{std::string(filename)};
     if (!file) {
@@ -183,14 +565,15 @@ poesie::Result<json> PythonVm::load(
     }
     std::stringstream buffer;
     buffer << file.rdbuf();
-    result = execute(buffer.str(), args);
+    result = execute(buffer.str(), args, context);
     return result;
 }
 
 poesie::Result<json> PythonVm::call(
         std::string_view function,
         std::string_view target,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     ABT_mutex_lock(m_mtx);
     py::object pytarget;
@@ -219,12 +602,19 @@ poesie::Result<json> PythonVm::call(
         pyargs[i] = from_json(m_engine, args[i], createdViews);
     }
     try {
-        py::object ret = pytarget.attr(function.data())(*pyargs);
+        py::object ret;
+        {
+            InterruptTrace trace{context, m_yielder};
+            ret = pytarget.attr(function.data())(*pyargs);
+        }
+        // push the views back while the result is converted
+        for(auto& view : createdViews) view.writeBack();
         result.value() = to_json(ret);
     } catch(const py::error_already_set &e) {
         result.success() = false;
         result.error() = "Error running Python code: ";
-        result.error() += e.what();
+        if(context.interrupted()) result.error() += context.reason();
+        else result.error() += e.what();
     }
     ABT_mutex_unlock(m_mtx);
     return result;
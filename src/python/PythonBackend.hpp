@@ -15,6 +15,10 @@ namespace py = pybind11;
 
 /**
  * Python implementation of an poesie Backend.
+ *
+ * A PythonVm owns the Python interpreter of the process, of which
+ * there can only be one: it can't be cloned, replicated, or used
+ * with per-request isolation, and a process hosts a single PythonVm.
  */
 #pragma GCC visibility push(hidden)
 class PythonVm : public poesie::Backend {
@@ -25,6 +29,7 @@ class PythonVm : public poesie::Backend {
     py::scoped_interpreter m_guard;          // Initialize the interpreter and keep it alive
     py::object             m_main_module;    // Holds the main module for the subinterpreter
     py::object             m_main_namespace; // Holds the namespace of the main module
+    poesie::Yielder        m_yielder;
 
     static ABT_mutex_memory s_mtx;
 
@@ -65,12 +70,18 @@ class PythonVm : public poesie::Backend {
      */
     std::string getConfig() const override;
 
+    // overloads running without an ExecutionContext
+    using poesie::Backend::execute;
+    using poesie::Backend::load;
+    using poesie::Backend::call;
+
     /**
      * @see Backend::execute
      */
     poesie::Result<json> execute(
             std::string_view code,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::call.
@@ -78,14 +89,16 @@ class PythonVm : public poesie::Backend {
     poesie::Result<json> call(
             std::string_view function,
             std::string_view target,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::load
      */
     poesie::Result<json> load(
             std::string_view filename,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::install.
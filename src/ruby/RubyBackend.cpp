@@ -106,13 +106,59 @@ static mrb_value json_to_mrb_value(
 
 POESIE_REGISTER_BACKEND(ruby, RubyVm);
 
+#if defined(MRB_USE_DEBUG_HOOK) || defined(MRB_ENABLE_DEBUG_HOOK)
+#define POESIE_MRB_DEBUG_HOOK
+#endif
+
+// number of instructions between two polls of the ExecutionContext
+static constexpr unsigned s_interrupt_period = 1000;
+
+template<typename ... Args>
+void RubyVm::codeFetchHook(mrb_state* mrb, Args...) {
+    auto vm = static_cast<RubyVm*>(mrb->ud);
+    if(!vm || !vm->m_context) return;
+    if(++vm->m_fetched < s_interrupt_period) return;
+    vm->m_fetched = 0;
+    vm->m_yielder.tick(s_interrupt_period);
+    if(!vm->m_context->interrupted()) return;
+    // no object with a destructor may live in this frame when
+    // mrb_raise longjmps out of it, hence the copy in the VM
+    vm->m_interrupt_reason = vm->m_context->reason();
+    mrb_raise(mrb, E_RUNTIME_ERROR, vm->m_interrupt_reason.c_str());
+}
+
+void RubyVm::setContext(const poesie::ExecutionContext* context) {
+    // without debug hooks, scripts can't be interrupted (only the provider
+    // enforces deadlines, before the request starts) and only yield
+    // the execution stream by calling poesie_yield
+    if(context && (context->interruptible() || m_yielder.interval()))
+        m_context = context;
+    else
+        m_context = nullptr;
+    m_fetched = 0;
+#ifdef POESIE_MRB_DEBUG_HOOK
+    if(m_context) m_mrb->code_fetch_hook = codeFetchHook;
+    else m_mrb->code_fetch_hook = nullptr;
+#endif
+}
+
+// lets long computations explicitly share the execution stream
+static mrb_value mrb_poesie_yield(mrb_state*, mrb_value) {
+    thallium::thread::yield();
+    return mrb_nil_value();
+}
+
 RubyVm::RubyVm(thallium::engine engine, const json& config)
 : m_engine(std::move(engine))
-, m_config(config) {
+, m_config(config)
+, m_yielder(config) {
     m_mrb = mrb_open();
     if (!m_mrb) {
         throw poesie::Exception{"Failed to initialize mruby"};
     }
+    m_mrb->ud = this;
+    mrb_define_module_function(m_mrb, m_mrb->kernel_module, "poesie_yield",
+                               mrb_poesie_yield, MRB_ARGS_NONE());
     if(m_config.is_object()) {
         std::vector<json> args;
         if(m_config.contains("preamble_argv")) {
@@ -137,7 +183,7 @@ RubyVm::RubyVm(thallium::engine engine, const json& config)
             }
         }
     }
-    m_memoryview_class = mrb_mruby_memory_view_gem_init(m_mrb);
+    m_memoryview_class = mrb_mruby_memory_view_gem_init(m_mrb, m_engine);
 }
 
 RubyVm::~RubyVm() {
@@ -152,7 +198,8 @@ std::string RubyVm::getConfig() const {
 
 poesie::Result<json> RubyVm::execute(
         std::string_view code,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     std::unique_lock<thallium::mutex> guard{m_mtx};
     std::vector<poesie::MemoryView> createdViews;
@@ -164,7 +211,9 @@ poesie::Result<json> RubyVm::execute(
             json_to_mrb_value(m_engine, m_mrb, m_memoryview_class, args[i], createdViews));
     }
     mrb_const_set(m_mrb, mrb_obj_value(m_mrb->object_class), mrb_intern_lit(m_mrb, "ARGV"), ARGV);
+    setContext(&context);
     mrb_value ret = mrb_load_string(m_mrb, code.data());
+    setContext(nullptr);
     if (m_mrb->exc) {
         mrb_value exc = mrb_obj_value(m_mrb->exc);
         mrb_value exc_message = mrb_funcall(m_mrb, exc, "inspect", 0);
@@ -172,8 +221,11 @@ poesie::Result<json> RubyVm::execute(
         m_mrb->exc = nullptr;
         result.success() = false;
         result.error() = "Error executing Ruby code: ";
-        result.error() += error_message;
+        if(context.interrupted()) result.error() += context.reason();
+        else result.error() += error_message;
     } else {
+        // Push the views back while the result is converted
+        for(auto& view : createdViews) view.writeBack();
         result.value() = mrb_value_to_json(m_mrb, ret);
     }
     return result;
@@ -181,7 +233,8 @@ poesie::Result<json> RubyVm::execute(
 
 poesie::Result<json> RubyVm::load(
         std::string_view filename,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<json> result;
     std::ifstream file{std::string(filename)};
     if (!file) {
@@ -193,14 +246,15 @@ poesie::Result<json> RubyVm::load(
     std::stringstream buffer;
     buffer << file.rdbuf();
     std::string code = buffer.str();
-    result = execute(code, args);
+    result = execute(code, args, context);
     return result;
 }
 
 poesie::Result<nlohmann::json> RubyVm::call(
         std::string_view function,
         std::string_view target,
-        const std::vector<json>& args) {
+        const std::vector<json>& args,
+        const poesie::ExecutionContext& context) {
     poesie::Result<nlohmann::json> result;
     std::unique_lock<thallium::mutex> guard{m_mtx};
     std::vector<poesie::MemoryView> createdViews;
@@ -210,6 +264,7 @@ poesie::Result<nlohmann::json> RubyVm::call(
         mrb_args[i] = json_to_mrb_value(m_engine, m_mrb, m_memoryview_class, args[i], createdViews);
     }
     mrb_value ret;
+    setContext(&context);
     if (target.empty()) {
         // Target is empty, call a global function
         mrb_sym sym = mrb_intern_cstr(m_mrb, function.data());
@@ -221,6 +276,7 @@ poesie::Result<nlohmann::json> RubyVm::call(
         mrb_sym function_sym = mrb_intern_cstr(m_mrb, function.data());
         ret = mrb_funcall_argv(m_mrb, target_obj, function_sym, args.size(), mrb_args.data());
     }
+    setContext(nullptr);
 
     // Check for Ruby exceptions
     if (m_mrb->exc) {
@@ -230,9 +286,12 @@ poesie::Result<nlohmann::json> RubyVm::call(
         const char* error_message = mrb_str_to_cstr(m_mrb, exc_message);
         result.success() = false;
         result.error() = "Error executing Ruby code: ";
-        result.error() += error_message;
+        if(context.interrupted()) result.error() += context.reason();
+        else result.error() += error_message;
         m_mrb->exc = nullptr;
     } else {
+        // Push the views back while the result is converted
+        for(auto& view : createdViews) view.writeBack();
         // Convert the result from mrb_value to JSON
         result.value() = mrb_value_to_json(m_mrb, ret);
     }
@@ -24,6 +24,25 @@ class RubyVm : public poesie::Backend {
     thallium::mutex  m_mtx;
     mrb_state*       m_mrb;
     struct RClass*   m_memoryview_class;
+    // ExecutionContext of the running request, polled by codeFetchHook
+    const poesie::ExecutionContext* m_context = nullptr;
+    std::string                     m_interrupt_reason;
+    unsigned                        m_fetched = 0;
+    poesie::Yielder                 m_yielder;
+
+    /**
+     * @brief Hook called by mruby before each instruction when it is built
+     * with debug hooks, raising an exception once the running request is
+     * interrupted and periodically yielding the execution stream.
+     * The parameters after mrb differ between mruby versions.
+     */
+    template<typename ... Args>
+    static void codeFetchHook(mrb_state* mrb, Args...);
+
+    /**
+     * @brief Make the context visible to codeFetchHook.
+     */
+    void setContext(const poesie::ExecutionContext* context);
 
     public:
 
@@ -62,19 +81,26 @@ class RubyVm : public poesie::Backend {
      */
     std::string getConfig() const override;
 
+    // overloads running without an ExecutionContext
+    using poesie::Backend::execute;
+    using poesie::Backend::load;
+    using poesie::Backend::call;
+
     /**
      * @see Backend::execute
      */
     poesie::Result<json> execute(
             std::string_view code,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::load
      */
     poesie::Result<json> load(
             std::string_view filename,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::call.
@@ -82,7 +108,8 @@ class RubyVm : public poesie::Backend {
     poesie::Result<json> call(
             std::string_view function,
             std::string_view target,
-            const std::vector<json>& args) override;
+            const std::vector<json>& args,
+            const poesie::ExecutionContext& context) override;
 
     /**
      * @see Backend::install.
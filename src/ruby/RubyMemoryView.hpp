@@ -13,45 +13,475 @@
 #include <mruby/data.h>
 #include <mruby/string.h>
 #include <mruby/array.h>
+#include <mruby/numeric.h>
 #include <poesie/MemoryView.hpp>
+#include "../Kernels.hpp"
+#include "../Compression.hpp"
+#include "../Hashing.hpp"
+#include <algorithm>
 
 struct RubyMemoryView {
     uint8_t* data;
     size_t size;
+    bool deferred; // streamed, lazy, or write-tracking MemoryView
+    poesie::MemoryView* owned = nullptr; // view owned by this object, if any
 };
 
 // Free function to be called when mruby's garbage collector cleans up the object.
 static inline void memory_view_free(mrb_state *mrb, void *ptr) {
     struct RubyMemoryView *memview = (struct RubyMemoryView*)ptr;
     if (memview) {
+        delete memview->owned;
         mrb_free(mrb, memview);
     }
 }
 
 // Data type definition for the MemoryView struct in mruby.
+static const struct mrb_data_type memory_view_data_type = {
+    "MemoryView", memory_view_free,
+};
+
 // Constructor: MemoryView.new(size)
 static inline mrb_value memory_view_new(
         mrb_state *mrb,
         struct RClass *memory_view_class,
         const poesie::MemoryView& view) {
-
-    static const struct mrb_data_type memory_view_data_type = {
-        "MemoryView", memory_view_free,
-    };
-
-    auto rb_view = new RubyMemoryView{(uint8_t*)view.data(), view.size()};
+    auto rb_view = new RubyMemoryView{(uint8_t*)view.rawData(), view.size(),
+                                      view.numChunks() > 1 || view.tracksWrites()};
     auto obj     = mrb_data_object_alloc(mrb, memory_view_class, rb_view, &memory_view_data_type);
     auto val     = mrb_obj_value(obj);
 
     return val;
 }
 
+// Make the bytes from begin (inclusive) to end (exclusive) available, and
+// record them as modified if write is true (see MemoryView::access).
+static inline void memory_view_wait_range(mrb_state *mrb, RubyMemoryView *memview,
+                                          size_t begin, size_t end, bool write = false) {
+    if (!memview->deferred || begin >= end) return;
+    bool ok = true;
+    {
+        auto view = poesie::MemoryView::FromData(memview->data);
+        if (view) {
+            try {
+                view.access((char*)memview->data - view.rawData() + begin, end - begin, write);
+            } catch(const std::exception&) {
+                ok = false;
+            }
+        }
+    }
+    if (!ok) mrb_raise(mrb, E_RUNTIME_ERROR, "failed to receive MemoryView data");
+}
+
 // to_s method: Converts the data into a Ruby String.
 static inline mrb_value memory_view_to_s(mrb_state *mrb, mrb_value self) {
     struct RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    memory_view_wait_range(mrb, memview, 0, memview->size);
     return mrb_str_new(mrb, (const char*)memview->data, memview->size);
 }
 
+// chunk_size method: Get the size of the chunks in which the data is received.
+static inline mrb_value memory_view_chunk_size(mrb_state *mrb, mrb_value self) {
+    (void)mrb;
+    struct RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    size_t chunk_size = memview->size;
+    {
+        auto view = poesie::MemoryView::FromData(memview->data);
+        if (view) chunk_size = view.chunkSize();
+    }
+    return mrb_fixnum_value(chunk_size);
+}
+
+// wait method: wait(begin = 0, end = size) waits for a range of bytes to be received.
+static inline mrb_value memory_view_wait(mrb_state *mrb, mrb_value self) {
+    RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    mrb_int begin = 0;
+    mrb_int end = memview->size;
+
+    mrb_get_args(mrb, "|ii", &begin, &end);
+
+    if (begin < 0 || end < 0 || (size_t)end > memview->size) {
+        mrb_raise(mrb, E_INDEX_ERROR, "range out of bounds");
+    }
+
+    memory_view_wait_range(mrb, memview, begin, end);
+    return self;
+}
+
+// segments method: returns the [begin, end] ranges of the client memory segments the view was built from.
+static inline mrb_value memory_view_segments(mrb_state *mrb, mrb_value self) {
+    RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    std::vector<std::pair<size_t, size_t>> segments{{0, memview->size}};
+    {
+        auto view = poesie::MemoryView::FromData(memview->data);
+        if (view) segments = view.slice((char*)memview->data - view.rawData(), memview->size).segments();
+    }
+    mrb_value result = mrb_ary_new_capa(mrb, segments.size());
+    for (auto& segment : segments) {
+        mrb_value range[2] = { mrb_fixnum_value(segment.first),
+                               mrb_fixnum_value(segment.first + segment.second) };
+        mrb_ary_push(mrb, result, mrb_ary_new_from_values(mrb, 2, range));
+    }
+    return result;
+}
+
+// slice method: slice(begin, end) returns a MemoryView of the bytes from begin (inclusive)
+// to end (exclusive), sharing the data of this MemoryView.
+static inline mrb_value memory_view_slice(mrb_state *mrb, mrb_value self) {
+    RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    mrb_int begin, end;
+
+    mrb_get_args(mrb, "ii", &begin, &end);
+
+    if (begin < 0 || end < begin || (size_t)end > memview->size) {
+        mrb_raise(mrb, E_INDEX_ERROR, "range out of bounds");
+    }
+
+    auto rb_view = new RubyMemoryView{memview->data + begin, (size_t)(end - begin), memview->deferred};
+    auto obj     = mrb_data_object_alloc(mrb, mrb_obj_class(mrb, self), rb_view, &memory_view_data_type);
+    return mrb_obj_value(obj);
+}
+
+// each_chunk method: yields (begin, end) for each chunk, once it has been received.
+static inline mrb_value memory_view_each_chunk(mrb_state *mrb, mrb_value self) {
+    RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    mrb_value block;
+
+    mrb_get_args(mrb, "&!", &block);
+
+    size_t chunk_size = mrb_fixnum(memory_view_chunk_size(mrb, self));
+    for (size_t begin = 0; begin < memview->size; begin += chunk_size) {
+        size_t end = std::min(begin + chunk_size, memview->size);
+        memory_view_wait_range(mrb, memview, begin, end);
+        mrb_value args[2] = { mrb_fixnum_value(begin), mrb_fixnum_value(end) };
+        mrb_yield_argv(mrb, block, 2, args);
+    }
+    return self;
+}
+
+// reduce method: reduce(type, op) reduces the elements of the view natively (see Kernels.hpp).
+static inline mrb_value memory_view_reduce(mrb_state *mrb, mrb_value self) {
+    RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    char *type, *op;
+
+    mrb_get_args(mrb, "zz", &type, &op);
+
+    memory_view_wait_range(mrb, memview, 0, memview->size);
+    nlohmann::json result;
+    bool ok = true;
+    try {
+        result = poesie::kernels::reduce((const char*)memview->data, memview->size, type, op);
+    } catch(const std::exception&) {
+        ok = false;
+    }
+    if (!ok) mrb_raise(mrb, E_ARGUMENT_ERROR, "invalid type or operation for reduce, or overflow");
+    // integers are returned as Integer when they fit in a fixnum
+    if (result.is_number_unsigned() && result.get<uint64_t>() <= (uint64_t)MRB_INT_MAX
+        && FIXABLE(result.get<mrb_int>()))
+        return mrb_fixnum_value(result.get<mrb_int>());
+    if (result.is_number_integer() && !result.is_number_unsigned() && FIXABLE(result.get<mrb_int>()))
+        return mrb_fixnum_value(result.get<mrb_int>());
+    return mrb_float_value(mrb, result.get<mrb_float>());
+}
+
+// count method: count(byte) counts the occurrences of a byte value.
+static inline mrb_value memory_view_count(mrb_state *mrb, mrb_value self) {
+    RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    mrb_int value;
+
+    mrb_get_args(mrb, "i", &value);
+
+    if (value < 0 || value > 255) {
+        mrb_raise(mrb, E_ARGUMENT_ERROR, "value out of byte range (0-255)");
+    }
+
+    memory_view_wait_range(mrb, memview, 0, memview->size);
+    return mrb_fixnum_value(poesie::kernels::count((const char*)memview->data, memview->size, value));
+}
+
+// find method: find(pattern, start = 0) returns the index of the first occurrence of a string, or nil.
+static inline mrb_value memory_view_find(mrb_state *mrb, mrb_value self) {
+    RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    char *pattern;
+    mrb_int pattern_size;
+    mrb_int start = 0;
+
+    mrb_get_args(mrb, "s|i", &pattern, &pattern_size, &start);
+
+    memory_view_wait_range(mrb, memview, 0, memview->size);
+    auto pos = poesie::kernels::find((const char*)memview->data, memview->size,
+                                     {pattern, (size_t)pattern_size}, std::max<mrb_int>(start, 0));
+    if (pos == std::string_view::npos) return mrb_nil_value();
+    return mrb_fixnum_value(pos);
+}
+
+// histogram method: returns an array of the number of occurrences of each byte value.
+static inline mrb_value memory_view_histogram(mrb_state *mrb, mrb_value self) {
+    RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    memory_view_wait_range(mrb, memview, 0, memview->size);
+    auto counts = poesie::kernels::histogram((const char*)memview->data, memview->size);
+    mrb_value result = mrb_ary_new_capa(mrb, counts.size());
+    for (auto count : counts) mrb_ary_push(mrb, result, mrb_fixnum_value(count));
+    return result;
+}
+
+// byteswap method: byteswap(width) reverses the byte order of the elements of width 2, 4, or 8.
+static inline mrb_value memory_view_byteswap(mrb_state *mrb, mrb_value self) {
+    RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    mrb_int width;
+
+    mrb_get_args(mrb, "i", &width);
+
+    if ((width != 2 && width != 4 && width != 8) || memview->size % width) {
+        mrb_raise(mrb, E_ARGUMENT_ERROR, "invalid width for byteswap");
+    }
+
+    memory_view_wait_range(mrb, memview, 0, memview->size, true);
+    poesie::kernels::byteswap((char*)memview->data, memview->size, width);
+    return self;
+}
+
+// Get the range [begin, end) of a MemoryView passed to a hashing method, once it has been received.
+static inline std::pair<const char*, size_t> memory_view_hash_range(mrb_state *mrb, RubyMemoryView *memview,
+                                                                   mrb_int begin, mrb_int end) {
+    if (begin < 0 || end < begin || (size_t)end > memview->size) {
+        mrb_raise(mrb, E_INDEX_ERROR, "range out of bounds");
+    }
+    memory_view_wait_range(mrb, memview, begin, end);
+    return {(const char*)memview->data + begin, (size_t)(end - begin)};
+}
+
+// digest method: digest(algorithm, begin = 0, end = size) returns the hash of a range
+// of bytes (see Hashing.hpp).
+static inline mrb_value memory_view_digest(mrb_state *mrb, mrb_value self) {
+    RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    char *algorithm;
+    mrb_int begin = 0;
+    mrb_int end = memview->size;
+
+    mrb_get_args(mrb, "z|ii", &algorithm, &begin, &end);
+
+    auto range = memory_view_hash_range(mrb, memview, begin, end);
+    bool ok = true;
+    mrb_value result = mrb_nil_value();
+    {
+        std::string digest;
+        try {
+            digest = poesie::hashing::hash(algorithm, range.first, range.second);
+        } catch(const std::exception&) {
+            ok = false;
+        }
+        if (ok) result = mrb_str_new(mrb, digest.data(), digest.size());
+    }
+    if (!ok) mrb_raise(mrb, E_ARGUMENT_ERROR, "invalid hash algorithm");
+    return result;
+}
+
+// Data type of the hashers returned by MemoryView.hasher.
+static inline void memory_view_hasher_free(mrb_state *mrb, void *ptr) {
+    (void)mrb;
+    delete static_cast<poesie::hashing::Hasher*>(ptr);
+}
+
+static const struct mrb_data_type memory_view_hasher_type = {
+    "MemoryViewHasher", memory_view_hasher_free,
+};
+
+// hasher class method: MemoryView.hasher(algorithm) returns a MemoryViewHasher, on which
+// update(view, begin = 0, end = size) adds bytes to the hashed content (e.g. each chunk
+// of a streamed view as it is received) and digest returns the hash of the content
+// added so far.
+static inline mrb_value memory_view_hasher(mrb_state *mrb, mrb_value self) {
+    (void)self;
+    char *algorithm;
+
+    mrb_get_args(mrb, "z", &algorithm);
+
+    poesie::hashing::Hasher* hasher = nullptr;
+    try {
+        hasher = poesie::hashing::Hasher::Create(algorithm).release();
+    } catch(const std::exception&) {
+    }
+    if (!hasher) mrb_raise(mrb, E_ARGUMENT_ERROR, "invalid hash algorithm");
+
+    auto hasher_class = mrb_class_get(mrb, "MemoryViewHasher");
+    auto obj = mrb_data_object_alloc(mrb, hasher_class, hasher, &memory_view_hasher_type);
+    return mrb_obj_value(obj);
+}
+
+static inline mrb_value memory_view_hasher_update(mrb_state *mrb, mrb_value self) {
+    auto hasher = (poesie::hashing::Hasher*)DATA_PTR(self);
+    mrb_value view_value;
+    mrb_int begin = 0;
+    mrb_int end = -1;
+
+    mrb_get_args(mrb, "o|ii", &view_value, &begin, &end);
+
+    auto memview = (RubyMemoryView*)mrb_data_get_ptr(mrb, view_value, &memory_view_data_type);
+    if (!memview) mrb_raise(mrb, E_ARGUMENT_ERROR, "argument should be a MemoryView");
+    if (end == -1) end = memview->size;
+
+    auto range = memory_view_hash_range(mrb, memview, begin, end);
+    hasher->update(range.first, range.second);
+    return self;
+}
+
+static inline mrb_value memory_view_hasher_digest(mrb_state *mrb, mrb_value self) {
+    auto hasher = (poesie::hashing::Hasher*)DATA_PTR(self);
+    mrb_value result;
+    {
+        auto digest = hasher->hexdigest();
+        result = mrb_str_new(mrb, digest.data(), digest.size());
+    }
+    return result;
+}
+
+// Data type of the engine stored in the MemoryView class.
+static inline void memory_view_engine_free(mrb_state *mrb, void *ptr) {
+    (void)mrb;
+    delete static_cast<thallium::engine*>(ptr);
+}
+
+static const struct mrb_data_type memory_view_engine_type = {
+    "Engine", memory_view_engine_free,
+};
+
+// Get the engine stored in the MemoryView class.
+static inline thallium::engine* memory_view_engine(mrb_state *mrb, struct RClass *memory_view_class) {
+    auto engine_value = mrb_cv_get(mrb, mrb_obj_value(memory_view_class), mrb_intern_lit(mrb, "@@engine"));
+    return static_cast<thallium::engine*>(
+        mrb_data_get_ptr(mrb, engine_value, &memory_view_engine_type));
+}
+
+// Wrap a MemoryView created by a script (from_file, decompress), which the object takes ownership of.
+static inline mrb_value memory_view_wrap_owned(mrb_state *mrb, struct RClass *memory_view_class,
+                                               poesie::MemoryView* view) {
+    auto rb_view = new RubyMemoryView{(uint8_t*)view->rawData(), view->size(), false, view};
+    auto obj     = mrb_data_object_alloc(mrb, memory_view_class, rb_view, &memory_view_data_type);
+    return mrb_obj_value(obj);
+}
+
+// from_file class method: MemoryView.from_file(path, offset = 0, size = nil, writable = false)
+// maps a range of a local file (see MemoryView::FromFile).
+static inline mrb_value memory_view_from_file(mrb_state *mrb, mrb_value self) {
+    char *path;
+    mrb_int offset = 0;
+    mrb_value size = mrb_nil_value();
+    mrb_bool writable = false;
+
+    mrb_get_args(mrb, "z|iob", &path, &offset, &size, &writable);
+
+    if (offset < 0 || (!mrb_nil_p(size) && (!mrb_fixnum_p(size) || mrb_fixnum(size) <= 0))) {
+        mrb_raise(mrb, E_ARGUMENT_ERROR, "invalid offset or size");
+    }
+
+    auto engine = memory_view_engine(mrb, mrb_class_ptr(self));
+    poesie::MemoryView* view = nullptr;
+    bool ok = true;
+    {
+        std::optional<size_t> range_size;
+        if (!mrb_nil_p(size)) range_size = mrb_fixnum(size);
+        try {
+            view = new poesie::MemoryView{poesie::MemoryView::FromFile(
+                *engine, path, offset, range_size,
+                writable ? poesie::MemoryView::Intent::INOUT : poesie::MemoryView::Intent::IN)};
+        } catch(const std::exception&) {
+            ok = false;
+        }
+    }
+    if (!ok) mrb_raise(mrb, E_RUNTIME_ERROR, "failed to map file");
+
+    return memory_view_wrap_owned(mrb, mrb_class_ptr(self), view);
+}
+
+// compress_bound class method: MemoryView.compress_bound(codec, size) is the maximum
+// size of the compressed form of size bytes (see Compression.hpp).
+static inline mrb_value memory_view_compress_bound(mrb_state *mrb, mrb_value self) {
+    (void)self;
+    char *codec;
+    mrb_int size;
+
+    mrb_get_args(mrb, "zi", &codec, &size);
+
+    size_t bound = 0;
+    bool ok = size >= 0;
+    if (ok) {
+        try {
+            bound = poesie::compression::compressBound(codec, size);
+        } catch(const std::exception&) {
+            ok = false;
+        }
+    }
+    if (!ok) mrb_raise(mrb, E_ARGUMENT_ERROR, "invalid codec or size");
+    return mrb_fixnum_value(bound);
+}
+
+// compress method: compress(codec, dst, level = 0) compresses the data into
+// the MemoryView dst and returns the compressed size.
+static inline mrb_value memory_view_compress(mrb_state *mrb, mrb_value self) {
+    RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    char *codec;
+    mrb_value dst_value;
+    mrb_int level = 0;
+
+    mrb_get_args(mrb, "zo|i", &codec, &dst_value, &level);
+
+    auto dst = (RubyMemoryView*)mrb_data_get_ptr(mrb, dst_value, &memory_view_data_type);
+    if (!dst) mrb_raise(mrb, E_ARGUMENT_ERROR, "destination should be a MemoryView");
+
+    memory_view_wait_range(mrb, memview, 0, memview->size);
+    memory_view_wait_range(mrb, dst, 0, dst->size, true);
+    size_t size = 0;
+    bool ok = true;
+    try {
+        size = poesie::compression::compress(codec, (const char*)memview->data, memview->size,
+                                             (char*)dst->data, dst->size, level);
+    } catch(const std::exception&) {
+        ok = false;
+    }
+    if (!ok) mrb_raise(mrb, E_RUNTIME_ERROR, "failed to compress MemoryView");
+    return mrb_fixnum_value(size);
+}
+
+// decompress method: decompress(codec, dst = nil) decompresses the data into the
+// MemoryView dst and returns the decompressed size, or into a new MemoryView if
+// dst is nil.
+static inline mrb_value memory_view_decompress(mrb_state *mrb, mrb_value self) {
+    RubyMemoryView *memview = (RubyMemoryView*)DATA_PTR(self);
+    char *codec;
+    mrb_value dst_value = mrb_nil_value();
+
+    mrb_get_args(mrb, "z|o", &codec, &dst_value);
+
+    RubyMemoryView *dst = nullptr;
+    if (!mrb_nil_p(dst_value)) {
+        dst = (RubyMemoryView*)mrb_data_get_ptr(mrb, dst_value, &memory_view_data_type);
+        if (!dst) mrb_raise(mrb, E_ARGUMENT_ERROR, "destination should be a MemoryView");
+        memory_view_wait_range(mrb, dst, 0, dst->size, true);
+    }
+    memory_view_wait_range(mrb, memview, 0, memview->size);
+
+    auto memory_view_class = mrb_obj_class(mrb, self);
+    auto engine = memory_view_engine(mrb, memory_view_class);
+    poesie::MemoryView* view = nullptr;
+    size_t size = 0;
+    bool ok = true;
+    try {
+        auto src = (const char*)memview->data;
+        if (dst) {
+            size = poesie::compression::decompress(codec, src, memview->size, (char*)dst->data, dst->size);
+        } else {
+            view = new poesie::MemoryView{poesie::compression::decompress(*engine, codec, src, memview->size)};
+        }
+    } catch(const std::exception&) {
+        delete view;
+        ok = false;
+    }
+    if (!ok) mrb_raise(mrb, E_RUNTIME_ERROR, "failed to decompress MemoryView");
+    if (dst) return mrb_fixnum_value(size);
+    return memory_view_wrap_owned(mrb, memory_view_class, view);
+}
+
 // size method: Get the size of the data.
 static inline mrb_value memory_view_size(mrb_state *mrb, mrb_value self) {
     (void)mrb;
@@ -70,6 +500,7 @@ static inline mrb_value memory_view_get_byte(mrb_state *mrb, mrb_value self) {
         mrb_raise(mrb, E_INDEX_ERROR, "index out of bounds");
     }
 
+    memory_view_wait_range(mrb, memview, index, index + 1);
     return mrb_fixnum_value(memview->data[index]);
 }
 
@@ -89,21 +520,47 @@ static inline mrb_value memory_view_set_byte(mrb_state *mrb, mrb_value self) {
         mrb_raise(mrb, E_ARGUMENT_ERROR, "value out of byte range (0-255)");
     }
 
+    memory_view_wait_range(mrb, memview, index, index + 1, true);
     memview->data[index] = (uint8_t)value;
     return mrb_fixnum_value(value);
 }
 
 // Define the RubyMemoryView class and its methods in mruby.
-static inline struct RClass* mrb_mruby_memory_view_gem_init(mrb_state *mrb) {
+static inline struct RClass* mrb_mruby_memory_view_gem_init(mrb_state *mrb, const thallium::engine& engine) {
     struct RClass *memory_view_class;
 
     memory_view_class = mrb_define_class(mrb, "MemoryView", mrb->object_class);
     MRB_SET_INSTANCE_TT(memory_view_class, MRB_TT_DATA);
 
+    auto engine_data = mrb_data_object_alloc(mrb, mrb->object_class,
+        new thallium::engine{engine}, &memory_view_engine_type);
+    mrb_mod_cv_set(mrb, memory_view_class, mrb_intern_lit(mrb, "@@engine"), mrb_obj_value(engine_data));
+    mrb_define_class_method(mrb, memory_view_class, "from_file", memory_view_from_file, MRB_ARGS_ARG(1, 3));
+    mrb_define_class_method(mrb, memory_view_class, "compress_bound", memory_view_compress_bound, MRB_ARGS_REQ(2));
+    mrb_define_class_method(mrb, memory_view_class, "hasher", memory_view_hasher, MRB_ARGS_REQ(1));
+
     mrb_define_method(mrb, memory_view_class, "to_s", memory_view_to_s, MRB_ARGS_NONE());
     mrb_define_method(mrb, memory_view_class, "size", memory_view_size, MRB_ARGS_NONE());
     mrb_define_method(mrb, memory_view_class, "[]", memory_view_get_byte, MRB_ARGS_REQ(1));
     mrb_define_method(mrb, memory_view_class, "[]=", memory_view_set_byte, MRB_ARGS_REQ(2));
+    mrb_define_method(mrb, memory_view_class, "chunk_size", memory_view_chunk_size, MRB_ARGS_NONE());
+    mrb_define_method(mrb, memory_view_class, "wait", memory_view_wait, MRB_ARGS_OPT(2));
+    mrb_define_method(mrb, memory_view_class, "each_chunk", memory_view_each_chunk, MRB_ARGS_BLOCK());
+    mrb_define_method(mrb, memory_view_class, "segments", memory_view_segments, MRB_ARGS_NONE());
+    mrb_define_method(mrb, memory_view_class, "slice", memory_view_slice, MRB_ARGS_REQ(2));
+    mrb_define_method(mrb, memory_view_class, "reduce", memory_view_reduce, MRB_ARGS_REQ(2));
+    mrb_define_method(mrb, memory_view_class, "count", memory_view_count, MRB_ARGS_REQ(1));
+    mrb_define_method(mrb, memory_view_class, "find", memory_view_find, MRB_ARGS_ARG(1, 1));
+    mrb_define_method(mrb, memory_view_class, "histogram", memory_view_histogram, MRB_ARGS_NONE());
+    mrb_define_method(mrb, memory_view_class, "byteswap", memory_view_byteswap, MRB_ARGS_REQ(1));
+    mrb_define_method(mrb, memory_view_class, "compress", memory_view_compress, MRB_ARGS_ARG(2, 1));
+    mrb_define_method(mrb, memory_view_class, "decompress", memory_view_decompress, MRB_ARGS_ARG(1, 1));
+    mrb_define_method(mrb, memory_view_class, "digest", memory_view_digest, MRB_ARGS_ARG(1, 2));
+
+    struct RClass *hasher_class = mrb_define_class(mrb, "MemoryViewHasher", mrb->object_class);
+    MRB_SET_INSTANCE_TT(hasher_class, MRB_TT_DATA);
+    mrb_define_method(mrb, hasher_class, "update", memory_view_hasher_update, MRB_ARGS_ARG(1, 2));
+    mrb_define_method(mrb, hasher_class, "digest", memory_view_hasher_digest, MRB_ARGS_NONE());
 
     return memory_view_class;
 }
@@ -0,0 +1,88 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_all.hpp>
+#include "Ensure.hpp"
+#include <poesie/Client.hpp>
+#include <poesie/Provider.hpp>
+#include <poesie/Backend.hpp>
+
+TEST_CASE("Admission control test", "[admission]") {
+    // the busy script occupies an RPC execution stream,
+    // so other requests need another one to be handled
+    auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE, true, 2);
+    ENSURE(engine.finalize());
+    const auto provider_config = R"(
+    {
+        "vm": {
+            "type": "javascript",
+            "config": {
+                "preamble_file": "example-preamble.js"
+            }
+        },
+        "admission": {
+            "max_in_flight": 2,
+            "max_queued_bytes": 1024
+        }
+    }
+    )";
+    poesie::Provider provider(engine, 42, provider_config);
+
+    auto config = nlohmann::json::parse(provider.getConfig());
+    REQUIRE(config["admission"]["max_in_flight"] == 2);
+    REQUIRE(config["admission"]["max_queued_bytes"] == 1024);
+
+    SECTION("Create VmHandle") {
+        poesie::Client client(engine);
+        std::string addr = engine.self();
+
+        auto rh = client.makeVmHandle(addr, 42);
+        auto busy = "var t = Date.now(); while(Date.now() - t < 500) {}";
+
+        SECTION("Reject requests past the limits") {
+
+            client.setRetryPolicy(0);
+            poesie::VmHandle::ReturnType result;
+
+            auto running = rh.execute(busy);
+            thallium::thread::sleep(engine, 100);
+            // too many bytes
+            REQUIRE_THROWS_AS(rh.call("my_add", "", {std::string(4096, 'x'), ""}).wait(),
+                              poesie::RetryableException);
+            // queued behind the busy script
+            auto queued = rh.execute("my_add(1,2)");
+            thallium::thread::sleep(engine, 100);
+            // too many requests
+            REQUIRE_THROWS_AS(rh.execute("my_add(1,2)").wait(), poesie::RetryableException);
+            REQUIRE_NOTHROW(running.wait());
+            REQUIRE_NOTHROW([&]() { result = queued.wait(); }());
+            REQUIRE(result.get<int>() == 3);
+
+            auto stats = nlohmann::json::parse(provider.getStatistics());
+            REQUIRE(stats["admission"]["rejected"] == 2);
+            REQUIRE(stats["admission"]["in_flight"] == 0);
+            REQUIRE(stats["admission"]["queued_bytes"] == 0);
+        }
+
+        SECTION("Retry rejected requests with backoff") {
+
+            client.setRetryPolicy(10, std::chrono::milliseconds{50},
+                                      std::chrono::milliseconds{200});
+            poesie::VmHandle::ReturnType result;
+
+            auto running = rh.execute(busy);
+            thallium::thread::sleep(engine, 100);
+            REQUIRE_NOTHROW([&]() {
+                result = rh.call("my_add", "", {std::string(4096, 'x'), ""}).wait();
+            }());
+            REQUIRE(result.get<std::string>() == std::string(4096, 'x'));
+            REQUIRE_NOTHROW(running.wait());
+
+            auto stats = nlohmann::json::parse(provider.getStatistics());
+            REQUIRE(stats["admission"]["rejected"].get<size_t>() > 0);
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_all.hpp>
+#include "Ensure.hpp"
+#include <poesie/Client.hpp>
+#include <poesie/Provider.hpp>
+#include <poesie/Backend.hpp>
+#include <chrono>
+
+TEST_CASE("Cancellation test", "[cancellation]") {
+    // the running script occupies an RPC execution stream,
+    // so the cancel RPC needs another one to be handled
+    auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE, true, 2);
+    ENSURE(engine.finalize());
+    const auto provider_config = R"(
+    {
+        "vm": {
+            "type": "javascript",
+            "config": {
+                "preamble_file": "example-preamble.js"
+            }
+        },
+        "scheduler": {}
+    }
+    )";
+    poesie::Provider provider(engine, 42, provider_config);
+
+    SECTION("Create VmHandle") {
+        poesie::Client client(engine);
+        std::string addr = engine.self();
+
+        auto rh = client.makeVmHandle(addr, 42);
+
+        SECTION("Cancel running and queued requests") {
+
+            poesie::VmHandle::ReturnType result;
+
+            // the running request holds the VM, the second one is queued
+            auto running = rh.execute("while(true) {}");
+            auto queued  = rh.call("my_add", "", {1,2});
+            thallium::thread::sleep(engine, 200);
+            REQUIRE(!running.completed());
+
+            queued.cancel();
+            REQUIRE_THROWS_AS(queued.wait(), poesie::Exception);
+            running.cancel();
+            REQUIRE_THROWS_AS(running.wait(), poesie::Exception);
+
+            // cancelling a completed request has no effect
+            auto completed = rh.execute("my_add(1,2)");
+            REQUIRE_NOTHROW([&]() { result = completed.wait(); }());
+            REQUIRE(result.get<int>() == 3);
+            REQUIRE_NOTHROW(completed.cancel());
+
+            // the VM remains usable
+            REQUIRE_NOTHROW([&]() { result = rh.call("my_add", "", {3,4}).wait(); }());
+            REQUIRE(result.get<int>() == 7);
+
+            auto stats = nlohmann::json::parse(provider.getStatistics());
+            REQUIRE(stats["scheduler"]["default"]["queued"] == 0);
+            REQUIRE(stats["scheduler"]["default"]["running"] == 0);
+        }
+
+        SECTION("Expire queued requests at their deadline") {
+
+            using namespace std::chrono_literals;
+
+            // the queued request leaves the queue when its deadline
+            // passes, without waiting for the running one to complete
+            auto running = rh.execute("while(true) {}");
+            thallium::thread::sleep(engine, 200);
+            auto start = std::chrono::steady_clock::now();
+            REQUIRE_THROWS_AS(rh.call("my_add", "", {1,2}, false, 200ms).wait(), poesie::Exception);
+            REQUIRE(std::chrono::steady_clock::now() - start < 5s);
+            REQUIRE(!running.completed());
+            running.cancel();
+            REQUIRE_THROWS_AS(running.wait(), poesie::Exception);
+
+            auto stats = nlohmann::json::parse(provider.getStatistics());
+            REQUIRE(stats["scheduler"]["default"]["queued"] == 0);
+            REQUIRE(stats["scheduler"]["default"]["running"] == 0);
+        }
+
+        SECTION("Cancel a running Python loop") {
+
+            // a loop that calls no function must be interruptible
+            // even when the request has no deadline
+            poesie::Provider python_provider(engine, 43, R"(
+            {
+                "vm": {
+                    "type": "python",
+                    "config": {
+                        "preamble_file": "example-preamble.py"
+                    }
+                },
+                "scheduler": {}
+            }
+            )");
+            auto python_rh = client.makeVmHandle(addr, 43);
+
+            auto running = python_rh.execute("while True: pass");
+            thallium::thread::sleep(engine, 200);
+            REQUIRE(!running.completed());
+            running.cancel();
+            REQUIRE_THROWS_AS(running.wait(), poesie::Exception);
+
+            // the VM remains usable
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = python_rh.call("my_add", "", {3,4}).wait(); }());
+            REQUIRE(result.get<int>() == 7);
+        }
+    }
+}
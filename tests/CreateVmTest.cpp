@@ -0,0 +1,125 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_all.hpp>
+#include "Ensure.hpp"
+#include <poesie/Client.hpp>
+#include <poesie/Provider.hpp>
+#include <poesie/Backend.hpp>
+
+TEST_CASE("Create VM test", "[create-vm]") {
+    auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
+    ENSURE(engine.finalize());
+    const auto provider_config = R"(
+    {
+        "vm": {
+            "type": "javascript",
+            "config": {
+                "preamble_file": "example-preamble.js"
+            }
+        },
+        "remote_vms": {
+            "enabled": true,
+            "max_vms": 4,
+            "max_xstreams": 1
+        }
+    }
+    )";
+    poesie::Provider provider(engine, 42, provider_config);
+
+    SECTION("Create VMs at runtime") {
+        poesie::Client client(engine);
+        std::string addr = engine.self();
+
+        auto rh = client.makeVmHandle(addr, 42);
+        poesie::VmHandle::ReturnType result;
+
+        SECTION("Create a VM from a configuration") {
+            auto job = client.createVm(addr, 42, "job",
+                {{"type", "javascript"}, {"config", nlohmann::json::object()}});
+            REQUIRE(job.vmName() == "job");
+            REQUIRE_NOTHROW([&]() { result = job.execute("1+2").wait(); }());
+            REQUIRE(result.get<int>() == 3);
+            REQUIRE_THROWS_AS(job.call("my_add", "", {1,2}).wait(), poesie::Exception);
+
+            auto config = nlohmann::json::parse(provider.getConfig());
+            REQUIRE(config["vms"]["job"]["type"] == "javascript");
+
+            // names are unique
+            REQUIRE_THROWS_AS(client.createVm(addr, 42, "job", {{"type", "javascript"}}),
+                              poesie::Exception);
+            REQUIRE_THROWS_AS(client.createVm(addr, 42, "other", {{"type", "unknown"}}),
+                              poesie::Exception);
+        }
+
+        SECTION("Clone a VM") {
+            REQUIRE_NOTHROW(rh.execute("var counter = 42;").wait());
+
+            auto job = client.createVm(addr, 42, "job", {{"clone_from", ""}});
+            // the clone has run the preamble of its source
+            REQUIRE_NOTHROW([&]() { result = job.call("my_add", "", {1,2}).wait(); }());
+            REQUIRE(result.get<int>() == 3);
+            // but does not share its state
+            REQUIRE_THROWS_AS(job.execute("counter").wait(), poesie::Exception);
+            REQUIRE_NOTHROW(job.execute("var counter = 0;").wait());
+            REQUIRE_NOTHROW([&]() { result = rh.execute("counter").wait(); }());
+            REQUIRE(result.get<int>() == 42);
+
+            auto config = nlohmann::json::parse(provider.getConfig());
+            REQUIRE(config["vms"]["job"]["config"] == config["vm"]["config"]);
+
+            REQUIRE_THROWS_AS(client.createVm(addr, 42, "other", {{"clone_from", "unknown"}}),
+                              poesie::Exception);
+        }
+
+        SECTION("Destroy a VM") {
+            auto job = client.createVm(addr, 42, "job", {{"clone_from", ""}});
+            REQUIRE_NOTHROW(job.destroy().wait());
+            REQUIRE(provider.getSharedBackend("job") == nullptr);
+            REQUIRE_THROWS_AS(job.execute("1").wait(), poesie::Exception);
+            REQUIRE_THROWS_AS(job.destroy().wait(), poesie::Exception);
+            // the name can be reused
+            REQUIRE_NOTHROW(client.createVm(addr, 42, "job", {{"clone_from", ""}}));
+            // but VMs from the configuration can't be destroyed by clients
+            REQUIRE_THROWS_AS(rh.destroy().wait(), poesie::Exception);
+            REQUIRE(provider.getSharedBackend() != nullptr);
+        }
+
+        SECTION("Limit the VMs created by clients") {
+            // clients can't run files or load libraries on the provider
+            REQUIRE_THROWS_AS(client.createVm(addr, 42, "job",
+                {{"type", "javascript"}, {"config", {{"preamble_file", "example-preamble.js"}}}}),
+                poesie::Exception);
+            REQUIRE_THROWS_AS(client.createVm(addr, 42, "job",
+                {{"clone_from", ""}, {"natives", nlohmann::json::array()}}),
+                poesie::Exception);
+
+            // dedicated execution streams count against the maximum number of execution streams
+            REQUIRE_THROWS_AS(client.createVm(addr, 42, "job2",
+                {{"clone_from", ""}, {"dedicated_xstreams", true}, {"replicas", 2}}),
+                poesie::Exception);
+            REQUIRE_NOTHROW(client.createVm(addr, 42, "job2",
+                {{"clone_from", ""}, {"dedicated_xstreams", true}}));
+
+            // and replicas against the maximum number of VMs
+            REQUIRE_THROWS_AS(client.createVm(addr, 42, "job",
+                {{"clone_from", ""}, {"replicas", 4}}), poesie::Exception);
+            REQUIRE_NOTHROW(client.createVm(addr, 42, "job",
+                {{"clone_from", ""}, {"replicas", 3}}));
+            REQUIRE_THROWS_AS(client.createVm(addr, 42, "job3", {{"clone_from", ""}}),
+                              poesie::Exception);
+
+            // destroying a VM frees its share of the limits
+            REQUIRE_NOTHROW(client.makeVmHandle(addr, 42, "job").destroy().wait());
+            REQUIRE_NOTHROW(client.createVm(addr, 42, "job3", {{"clone_from", ""}, {"replicas", 3}}));
+
+            // clients can't create VMs by default
+            poesie::Provider default_provider(engine, 43, "{}");
+            REQUIRE_THROWS_AS(client.createVm(addr, 43, "job", {{"type", "javascript"}}),
+                              poesie::Exception);
+        }
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_all.hpp>
+#include "Ensure.hpp"
+#include <poesie/Client.hpp>
+#include <poesie/Provider.hpp>
+#include <poesie/Backend.hpp>
+#include <chrono>
+
+TEST_CASE("Deadline test", "[deadline]") {
+    auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
+    ENSURE(engine.finalize());
+    const auto provider_config = R"(
+    {
+        "vm": {
+            "type": "javascript",
+            "config": {
+                "preamble_file": "example-preamble.js"
+            }
+        }
+    }
+    )";
+    poesie::Provider provider(engine, 42, provider_config);
+
+    SECTION("Create VmHandle") {
+        poesie::Client client(engine);
+        std::string addr = engine.self();
+
+        auto rh = client.makeVmHandle(addr, 42);
+
+        SECTION("Interrupt requests that exceed their deadline") {
+
+            using namespace std::chrono_literals;
+            poesie::VmHandle::ReturnType result;
+
+            // a request that completes in time
+            REQUIRE_NOTHROW([&]() { result = rh.execute("my_add(1,2)", {}, 1000ms).wait(); }());
+            REQUIRE(result.get<int>() == 3);
+
+            // a runaway script, even one that catches errors
+            auto start = std::chrono::steady_clock::now();
+            REQUIRE_THROWS_AS(rh.execute("while(true) {}", {}, 200ms).wait(), poesie::Exception);
+            REQUIRE_THROWS_AS(
+                rh.execute("while(true) { try { while(true) {} } catch(e) {} }", {}, 200ms).wait(),
+                poesie::Exception);
+            REQUIRE(std::chrono::steady_clock::now() - start < 10s);
+
+            // a runaway function
+            REQUIRE_NOTHROW(rh.execute("function spin() { while(true) {} }").wait());
+            REQUIRE_THROWS_AS(rh.call("spin", "", {}, false, 200ms).wait(), poesie::Exception);
+
+            // the VM remains usable
+            REQUIRE_NOTHROW([&]() { result = rh.call("my_add", "", {3,4}).wait(); }());
+            REQUIRE(result.get<int>() == 7);
+        }
+
+        // interrupts a runaway loop in a VM of the given type,
+        // then checks that this VM remains usable
+        auto interruptLoop = [&](const std::string& type, const std::string& loop) {
+            using namespace std::chrono_literals;
+            auto config = nlohmann::json::parse(R"({"vm": {"config": {}}})");
+            config["vm"]["type"] = type;
+            config["vm"]["config"]["preamble_file"] = "example-preamble."
+                + (type == "python" ? "py" : type == "ruby" ? "rb" : type);
+            poesie::Provider other_provider(engine, 43, config.dump());
+            auto other_rh = client.makeVmHandle(addr, 43);
+
+            auto start = std::chrono::steady_clock::now();
+            REQUIRE_THROWS_AS(other_rh.execute(loop, {}, 200ms).wait(), poesie::Exception);
+            REQUIRE(std::chrono::steady_clock::now() - start < 10s);
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = other_rh.call("my_add", "", {3,4}).wait(); }());
+            REQUIRE(result.get<int>() == 7);
+        };
+
+        SECTION("Interrupt a runaway Lua loop") {
+            interruptLoop("lua", "while true do end");
+        }
+
+        SECTION("Interrupt a runaway Python loop") {
+            interruptLoop("python", "while True: pass");
+        }
+
+#ifdef POESIE_HAS_RUBY_DEBUG_HOOK
+        // without debug hooks, Ruby scripts can't be interrupted
+        SECTION("Interrupt a runaway Ruby loop") {
+            interruptLoop("ruby", "while true do end");
+        }
+#endif
+
+        SECTION("Interrupt a runaway Jx9 loop") {
+            interruptLoop("jx9", "while(true) {}");
+        }
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_all.hpp>
+#include "Ensure.hpp"
+#include <poesie/Client.hpp>
+#include <poesie/Provider.hpp>
+#include <poesie/Backend.hpp>
+
+TEST_CASE("Dedicated xstream test", "[dedicated-xstream]") {
+    auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
+    ENSURE(engine.finalize());
+    const auto provider_config = R"(
+    {
+        "vm": {
+            "type": "javascript",
+            "config": {
+                "preamble_file": "example-preamble.js"
+            },
+            "replicas": 2,
+            "read_only": ["my_add"],
+            "cpus": [0]
+        }
+    }
+    )";
+    poesie::Provider provider(engine, 42, provider_config);
+
+    auto config = nlohmann::json::parse(provider.getConfig());
+    REQUIRE(config["vm"]["type"] == "javascript");
+    REQUIRE(config["vm"]["dedicated_xstreams"] == true);
+    REQUIRE(config["vm"]["cpus"] == nlohmann::json::array({0}));
+
+    SECTION("Create VmHandle") {
+        poesie::Client client(engine);
+        std::string addr = engine.self();
+
+        auto rh = client.makeVmHandle(addr, 42);
+
+        SECTION("Run requests on the VMs' execution streams") {
+
+            poesie::VmHandle::ReturnType result;
+
+            REQUIRE_NOTHROW(rh.execute("var counter = 0; function increment() { return ++counter; }").wait());
+            REQUIRE_NOTHROW([&]() { result = rh.call("increment", "", {}).wait(); }());
+            REQUIRE(result.get<int>() == 1);
+
+            std::vector<poesie::VmHandle::FutureType> futures;
+            for(int i = 0; i < 8; ++i)
+                futures.push_back(rh.call("my_add", "", {i, 1}));
+            for(int i = 0; i < 8; ++i) {
+                REQUIRE_NOTHROW([&]() { result = futures[i].wait(); }());
+                REQUIRE(result.get<int>() == i + 1);
+            }
+
+            auto stats = nlohmann::json::parse(provider.getStatistics());
+            for(auto& replica : stats["vm"]["replicas"])
+                REQUIRE(replica["diverged"].get<bool>() == false);
+        }
+    }
+}
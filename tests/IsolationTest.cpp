@@ -0,0 +1,68 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_all.hpp>
+#include "Ensure.hpp"
+#include <poesie/Client.hpp>
+#include <poesie/Provider.hpp>
+#include <poesie/Backend.hpp>
+
+TEST_CASE("Per-request isolation test", "[isolation]") {
+    auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
+    ENSURE(engine.finalize());
+    const auto provider_config = R"(
+    {
+        "vm": {
+            "type": "javascript",
+            "config": {
+                "preamble_file": "example-preamble.js"
+            },
+            "isolation": "per_request",
+            "warm_pool_size": 2
+        }
+    }
+    )";
+    poesie::Provider provider(engine, 42, provider_config);
+
+    auto config = nlohmann::json::parse(provider.getConfig());
+    REQUIRE(config["vm"]["isolation"] == "per_request");
+    REQUIRE(config["vm"]["warm_pool_size"] == 2);
+
+    provider.getSharedBackend()->install("my_mult",
+        [](const poesie::Backend::ArgsType& args) -> poesie::Backend::ReturnType {
+            return args[0].get<int>() * args[1].get<int>();
+        }, 2);
+
+    SECTION("Create VmHandle") {
+        poesie::Client client(engine);
+        std::string addr = engine.self();
+
+        auto rh = client.makeVmHandle(addr, 42);
+
+        SECTION("Run each request in a fresh VM") {
+
+            poesie::VmHandle::ReturnType result;
+
+            // every VM has run the preamble
+            for(int i = 0; i < 5; ++i) {
+                REQUIRE_NOTHROW([&]() { result = rh.call("my_add", "", {i, 1}).wait(); }());
+                REQUIRE(result.get<int>() == i + 1);
+            }
+
+            // and has the installed functions
+            REQUIRE_NOTHROW([&]() { result = rh.call("my_mult", "", {3, 4}).wait(); }());
+            REQUIRE(result.get<int>() == 12);
+
+            // but does not see the state left by previous requests
+            REQUIRE_NOTHROW(rh.execute("var counter = 42;").wait());
+            REQUIRE_THROWS_AS(rh.execute("counter").wait(), poesie::Exception);
+
+            auto stats = nlohmann::json::parse(provider.getStatistics());
+            REQUIRE(stats["vm"]["hits"].get<size_t>() + stats["vm"]["misses"].get<size_t>() == 8);
+            REQUIRE(stats["vm"]["discarded"] == 8);
+        }
+    }
+}
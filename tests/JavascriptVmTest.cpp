@@ -10,6 +10,8 @@
 #include <poesie/Provider.hpp>
 #include <poesie/Backend.hpp>
 #include <poesie/MemoryView.hpp>
+#include <vector>
+#include <cstdint>
 
 TEST_CASE("Javascript vm test", "[javascript]") {
     auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
@@ -25,7 +27,7 @@ TEST_CASE("Javascript vm test", "[javascript]") {
     }
     )";
     poesie::Provider provider(engine, 42, provider_config);
-    provider.getBackend()->install("my_mult",
+    provider.getSharedBackend()->install("my_mult",
         [](poesie::Backend::ArgsType args) -> poesie::Backend::ReturnType {
             return args[0].get<int>() * args[1].get<int>();
         }, 2);
@@ -222,5 +224,127 @@ TEST_CASE("Javascript vm test", "[javascript]") {
             REQUIRE(data == "abcdefghijklmnop");
         }
 
+        SECTION("Use native kernels, hashing, and compression") {
+
+            auto code = R"(
+            function use_native(ints, wrapping, text, out) {
+                // Javascript numbers can't represent all 64-bit integers exactly
+                if(memory_view_reduce(ints, "i64", "min") != 2) return "invalid min";
+                try {
+                    memory_view_reduce(wrapping, "u64", "sum");
+                    return "overflow not detected";
+                } catch(e) {}
+                if(memory_view_count(text, 108) != 3) return "invalid count";
+                if(memory_view_find(text, "world") != 16) return "invalid find";
+                if(memory_view_hash(text, "crc32c", 0, 9) != "e3069283") return "invalid crc32c";
+                var codecs = ["zstd", "lz4"];
+                for(var c = 0; c < codecs.length; c++) {
+                    try {
+                        memory_view_compress_bound(codecs[c], 1);
+                    } catch(e) {
+                        continue;
+                    }
+                    var size = memory_view_compress(text, codecs[c], out);
+                    var back = memory_view_decompress(out.subarray(0, size), codecs[c]);
+                    if(back.length != text.length) return "invalid decompressed size";
+                    for(var i = 0; i < text.length; i++)
+                        if(back[i] != text[i]) return "invalid decompressed content";
+                }
+                return "ok";
+            }
+            )";
+
+            REQUIRE_NOTHROW([&]() { rh.execute(code).wait(); }());
+
+            std::vector<int64_t> ints = {(int64_t{1} << 53) + 1, 2};
+            std::vector<uint64_t> wrapping = {uint64_t{1} << 63, uint64_t{1} << 63};
+            std::string text = "123456789 hello world";
+            std::string out(256, '\0');
+
+            poesie::VmHandle::ArgsType args(4);
+            args[0] = poesie::MemoryView{
+                engine, reinterpret_cast<const char*>(ints.data()),
+                ints.size()*sizeof(int64_t), poesie::MemoryView::Intent::IN};
+            args[1] = poesie::MemoryView{
+                engine, reinterpret_cast<const char*>(wrapping.data()),
+                wrapping.size()*sizeof(uint64_t), poesie::MemoryView::Intent::IN};
+            args[2] = poesie::MemoryView{
+                engine, text.data(), text.size(),
+                poesie::MemoryView::Intent::IN};
+            args[3] = poesie::MemoryView{
+                engine, out.data(), out.size(),
+                poesie::MemoryView::Intent::OUT};
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = rh.call("use_native", "", args).wait(); }());
+            REQUIRE(result.get<std::string>() == "ok");
+        }
+
+        SECTION("Use streamed MemoryView") {
+            // streaming is a setting of the engine, shared by its providers
+            poesie::Provider streaming(engine, 43,
+                R"({"memory_views": {"streaming": {"chunk_size": 4, "pipeline_depth": 2}}})");
+
+            // the script reads the view without waiting for its chunks
+            auto code = R"(
+            function use_streamed_memory_view(view) {
+                var str = new TextDecoder().decode(view);
+                for (var i = 0; i < view.length; i++) {
+                    view[i] = 97 + (i % 26);
+                }
+                return str;
+            }
+            )";
+
+            REQUIRE_NOTHROW([&]() { rh.execute(code).wait(); }());
+
+            // a fragmented bulk handle forces the data to be staged
+            std::string data1 = "ABCDEFGH";
+            std::string data2 = "IJKLMNOP";
+            auto bulk = engine.expose({{data1.data(), data1.size()},
+                                       {data2.data(), data2.size()}},
+                                       thallium::bulk_mode::read_write);
+
+            poesie::VmHandle::ArgsType args(1);
+            args[0] = poesie::MemoryView{
+                engine, bulk, engine.self(),
+                poesie::MemoryView::Intent::INOUT};
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&](){ result = rh.call("use_streamed_memory_view", "", args).wait(); }());
+            REQUIRE(result.get<std::string>() == "ABCDEFGHIJKLMNOP");
+            REQUIRE(data1 + data2 == "abcdefghijklmnop");
+        }
+
+        SECTION("Use write-tracking MemoryView") {
+            poesie::Provider tracking(engine, 43, R"({"memory_views": {"track_writes": true}})");
+
+            // typed array methods write to the buffer without indexing it
+            auto code = R"(
+            function use_tracked_memory_view(view) {
+                view.fill(120, 0, 4);
+                view.set([121, 122], 8);
+                memory_view_slice(view, 12, 16).fill(119);
+            }
+            )";
+
+            REQUIRE_NOTHROW([&]() { rh.execute(code).wait(); }());
+
+            // a fragmented bulk handle forces the data to be staged
+            std::string data1 = "ABCDEFGH";
+            std::string data2 = "IJKLMNOP";
+            auto bulk = engine.expose({{data1.data(), data1.size()},
+                                       {data2.data(), data2.size()}},
+                                       thallium::bulk_mode::read_write);
+
+            poesie::VmHandle::ArgsType args(1);
+            args[0] = poesie::MemoryView{
+                engine, bulk, engine.self(),
+                poesie::MemoryView::Intent::INOUT};
+
+            REQUIRE_NOTHROW(rh.call("use_tracked_memory_view", "", args).wait());
+            REQUIRE(data1 + data2 == "xxxxEFGHyzKLwwww");
+        }
+
     }
 }
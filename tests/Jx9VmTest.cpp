@@ -10,6 +10,8 @@
 #include <poesie/Provider.hpp>
 #include <poesie/Backend.hpp>
 #include <poesie/MemoryView.hpp>
+#include <vector>
+#include <cstdint>
 
 TEST_CASE("Jx9 vm test", "[jx9]") {
     auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
@@ -21,11 +23,15 @@ TEST_CASE("Jx9 vm test", "[jx9]") {
             "config": {
                 "preamble_file": "example-preamble.jx9"
             }
+        },
+        "plugins": {
+            "directories": ["."],
+            "remote_install": true
         }
     }
     )";
     poesie::Provider provider(engine, 42, provider_config);
-    provider.getBackend()->install("my_mult",
+    provider.getSharedBackend()->install("my_mult",
         [](poesie::Backend::ArgsType args) -> poesie::Backend::ReturnType {
             return args[0].get<int>() * args[1].get<int>();
         }, 2);
@@ -166,5 +172,110 @@ TEST_CASE("Jx9 vm test", "[jx9]") {
             REQUIRE(result.get<int>() == 0);
             REQUIRE(data == "abcdefghijklmnop");
         }
+
+        SECTION("Use native kernels, hashing, and compression") {
+
+            auto code = R"(
+            $ints = $__argv__[1];
+            $wrapping = $__argv__[2];
+            $text = $__argv__[3];
+            $out = $__argv__[4];
+            $total = memory_view_reduce($ints, "i64", "sum");
+            if(!is_int($total) || $total != 9007199254740995) {
+                return 1;
+            }
+            if(!is_null(memory_view_reduce($wrapping, "u64", "sum"))) {
+                return 2;
+            }
+            if(memory_view_count($text, 108) != 3) {
+                return 3;
+            }
+            if(memory_view_find($text, "world", 0) != 16) {
+                return 4;
+            }
+            if(memory_view_hash($text, "crc32c", 0, 9) != "e3069283") {
+                return 5;
+            }
+            foreach(["zstd", "lz4"] as $codec) {
+                if(is_null(memory_view_compress_bound($codec, 1))) {
+                    continue;
+                }
+                $size = memory_view_compress($text, $codec, $out, 0);
+                $back = memory_view_decompress(memory_view_slice($out, 0, $size), $codec);
+                if(memory_view_to_string($back) != memory_view_to_string($text)) {
+                    return 6;
+                }
+            }
+            $hasher = memory_view_hasher("crc32c");
+            if(!is_null(memory_view_to_string($hasher))) {
+                return 7;
+            }
+            if(memory_view_hasher_update($text, $hasher, 0, 9)
+            || !is_null(memory_view_hasher_digest($text))) {
+                return 8;
+            }
+            if(!memory_view_hasher_update($hasher, $text, 0, 9)
+            || memory_view_hasher_digest($hasher) != "e3069283") {
+                return 9;
+            }
+            return 0;
+            )";
+
+            std::vector<int64_t> ints = {(int64_t{1} << 53) + 1, 2};
+            std::vector<uint64_t> wrapping = {uint64_t{1} << 63, uint64_t{1} << 63};
+            std::string text = "123456789 hello world";
+            std::string out(256, '\0');
+
+            poesie::VmHandle::ArgsType args(4);
+            args[0] = poesie::MemoryView{
+                engine, reinterpret_cast<const char*>(ints.data()),
+                ints.size()*sizeof(int64_t), poesie::MemoryView::Intent::IN};
+            args[1] = poesie::MemoryView{
+                engine, reinterpret_cast<const char*>(wrapping.data()),
+                wrapping.size()*sizeof(uint64_t), poesie::MemoryView::Intent::IN};
+            args[2] = poesie::MemoryView{
+                engine, text.data(), text.size(),
+                poesie::MemoryView::Intent::IN};
+            args[3] = poesie::MemoryView{
+                engine, out.data(), out.size(),
+                poesie::MemoryView::Intent::OUT};
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = rh.execute(code, args).wait(); }());
+            REQUIRE(result.get<int>() == 0);
+        }
+
+        SECTION("Install native function (bad library)") {
+
+            poesie::Future<bool> future;
+            REQUIRE_NOTHROW([&]() {
+                future = rh.installNative("libdoesnotexist.so", "my_func", "my_func", 1); }());
+
+            REQUIRE_THROWS_AS(future.wait(), poesie::Exception);
+        }
+
+        SECTION("Install native function") {
+
+            REQUIRE_NOTHROW(rh.installNative(
+                "./libexample-plugin.so", "example_plugin_mult", "plugin_mult", 2).wait());
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = rh.execute("return plugin_mult(6,7);").wait(); }());
+            REQUIRE(result.get<int>() == 42);
+
+            auto config = nlohmann::json::parse(provider.getConfig());
+            REQUIRE(config["natives"].size() == 1);
+            REQUIRE(config["natives"][0]["symbol"] == "example_plugin_mult");
+
+            // libraries outside of the allowed directories are not loaded
+            REQUIRE_THROWS_AS(rh.installNative(
+                "/etc/hostname", "example_plugin_mult", "plugin_mult", 2).wait(), poesie::Exception);
+
+            // and clients may not install native functions by default
+            poesie::Provider default_provider(engine, 43, R"({"vm": {"type": "jx9"}})");
+            auto rh_default = client.makeVmHandle(addr, 43);
+            REQUIRE_THROWS_AS(rh_default.installNative(
+                "./libexample-plugin.so", "example_plugin_mult", "plugin_mult", 2).wait(), poesie::Exception);
+        }
     }
 }
@@ -10,6 +10,8 @@
 #include <poesie/Provider.hpp>
 #include <poesie/Backend.hpp>
 #include <poesie/MemoryView.hpp>
+#include <vector>
+#include <cstdint>
 
 TEST_CASE("Lua vm test", "[lua]") {
     auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
@@ -25,10 +27,23 @@ TEST_CASE("Lua vm test", "[lua]") {
     }
     )";
     poesie::Provider provider(engine, 42, provider_config);
-    provider.getBackend()->install("my_mult",
+    provider.getSharedBackend()->install("my_mult",
         [](poesie::Backend::ArgsType args) -> poesie::Backend::ReturnType {
             return args[0].get<int>() * args[1].get<int>();
         }, 2);
+    provider.getSharedBackend()->installAsync("my_async_mult",
+        [](poesie::Backend::ArgsType args) -> poesie::Backend::ForeignFuture {
+            auto result = args[0].get<int>() * args[1].get<int>();
+            return [result]() -> poesie::Backend::ReturnType { return result; };
+        }, 2);
+    provider.getSharedBackend()->installAsync("my_async_sleep",
+        [engine](poesie::Backend::ArgsType args) -> poesie::Backend::ForeignFuture {
+            auto ms = args[0].get<int>();
+            return [engine, ms]() -> poesie::Backend::ReturnType {
+                thallium::thread::sleep(engine, ms);
+                return nullptr;
+            };
+        }, 1);
 
     SECTION("Create VmHandle") {
         poesie::Client client(engine);
@@ -73,6 +88,36 @@ TEST_CASE("Lua vm test", "[lua]") {
             REQUIRE(result.get<int>() == 1386);
         }
 
+        SECTION("Execute asynchronous foreign function") {
+
+            poesie::VmHandle::FutureType future;
+            REQUIRE_NOTHROW([&]() { future = rh.execute("return my_async_mult(42, 33) + 1"); }());
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = future.wait(); }());
+
+            REQUIRE(result.is_number());
+            REQUIRE(result.get<int>() == 1387);
+
+            // a suspended request keeps its own arg
+            auto code = "my_async_sleep(arg[2]); return arg[1]";
+            auto slow = rh.execute(code, {1, 200});
+            auto fast = rh.execute(code, {2, 0});
+            REQUIRE_NOTHROW([&]() { result = fast.wait(); }());
+            REQUIRE(result.get<int>() == 2);
+            REQUIRE_NOTHROW([&]() { result = slow.wait(); }());
+            REQUIRE(result.get<int>() == 1);
+
+            // coroutines created by the script only yield to the script
+            REQUIRE_NOTHROW([&]() { result = rh.execute(
+                "local co = coroutine.wrap(function() return my_async_mult(2, 3) end)\n"
+                "return co()").wait(); }());
+            REQUIRE(result.get<int>() == 6);
+
+            // and the script itself can't yield
+            REQUIRE_THROWS_AS(rh.execute("coroutine.yield(1); return 2").wait(), poesie::Exception);
+        }
+
         SECTION("Execute code (bad syntax)") {
 
             poesie::VmHandle::FutureType future;
@@ -231,5 +276,200 @@ TEST_CASE("Lua vm test", "[lua]") {
             REQUIRE_NOTHROW(future.wait());
             REQUIRE(data == "abcdefghijklmnop");
         }
+
+        SECTION("Use streamed MemoryView") {
+            // streaming is a setting of the engine, shared by its providers
+            poesie::Provider streaming(engine, 43,
+                R"({"memory_views": {"streaming": {"chunk_size": 4, "pipeline_depth": 2}}})");
+
+            auto code = R"(
+            function use_streamed_memory_view(view)
+                local content = ""
+                local num_chunks = 0
+                for first, last in memory_view_chunks(view) do
+                    content = content .. memory.tostring(view, first, last)
+                    num_chunks = num_chunks + 1
+                end
+                assert(content == "ABCDEFGHIJKLMNOP", "invalid memory content")
+                memory.fill(view, "abcdefghijklmnop")
+                return num_chunks
+            end
+            )";
+
+            REQUIRE_NOTHROW([&]() { rh.execute(code).wait(); }());
+
+            // a fragmented bulk handle forces the data to be staged
+            std::string data1 = "ABCDEFGH";
+            std::string data2 = "IJKLMNOP";
+            auto bulk = engine.expose({{data1.data(), data1.size()},
+                                       {data2.data(), data2.size()}},
+                                       thallium::bulk_mode::read_write);
+
+            poesie::VmHandle::ArgsType args(1);
+            args[0] = poesie::MemoryView{
+                engine, bulk, engine.self(),
+                poesie::MemoryView::Intent::INOUT};
+
+            poesie::VmHandle::FutureType future;
+            REQUIRE_NOTHROW([&]() { future = rh.call("use_streamed_memory_view", "", args); }());
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = future.wait(); }());
+            REQUIRE(result.get<int>() == 4);
+            REQUIRE(data1 + data2 == "abcdefghijklmnop");
+        }
+
+        SECTION("Use native kernels") {
+
+            auto code = R"(
+            function use_kernels(values, text, ints, wrapping)
+                assert(memory_view_reduce(values, "f64", "sum") == 8.0, "invalid sum")
+                local total = memory_view_reduce(ints, "i64", "sum")
+                assert(math.type(total) == "integer" and total == 9007199254740995, "inexact sum")
+                assert(not pcall(memory_view_reduce, wrapping, "u64", "sum"), "overflow not detected")
+                assert(memory_view_reduce(values, "f64", "max") == 4.0, "invalid max")
+                assert(memory_view_count(text, string.byte("l")) == 5, "invalid count")
+                assert(memory_view_find(text, "hello", 2) == 14, "invalid find")
+                assert(memory_view_find(text, "bye") == nil, "invalid find")
+                assert(memory_view_histogram(text)[string.byte("o")] == 3, "invalid histogram")
+                assert(not pcall(memory_view_reduce, values, "f64", "avg"), "invalid op accepted")
+                memory_view_byteswap(memory_view_slice(text, 1, 4), 2)
+                return memory_view_reduce(values, "f64", "min")
+            end
+            )";
+
+            REQUIRE_NOTHROW([&]() { rh.execute(code).wait(); }());
+
+            std::vector<double> values = {1.5, 2.5, 4.0};
+            std::string text = "hello world, hello";
+            std::vector<int64_t> ints = {(int64_t{1} << 53) + 1, 2};
+            std::vector<uint64_t> wrapping = {uint64_t{1} << 63, uint64_t{1} << 63};
+
+            poesie::VmHandle::ArgsType args(4);
+            args[0] = poesie::MemoryView{
+                engine, reinterpret_cast<const char*>(values.data()),
+                values.size()*sizeof(double), poesie::MemoryView::Intent::IN};
+            args[1] = poesie::MemoryView{
+                engine, text.data(), text.size(),
+                poesie::MemoryView::Intent::INOUT};
+            args[2] = poesie::MemoryView{
+                engine, reinterpret_cast<const char*>(ints.data()),
+                ints.size()*sizeof(int64_t), poesie::MemoryView::Intent::IN};
+            args[3] = poesie::MemoryView{
+                engine, reinterpret_cast<const char*>(wrapping.data()),
+                wrapping.size()*sizeof(uint64_t), poesie::MemoryView::Intent::IN};
+
+            poesie::VmHandle::FutureType future;
+            REQUIRE_NOTHROW([&]() { future = rh.call("use_kernels", "", args); }());
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = future.wait(); }());
+            REQUIRE(result.get<double>() == 1.5);
+            REQUIRE(text == "ehllo world, hello");
+        }
+
+        SECTION("Hash MemoryView") {
+            // streaming is a setting of the engine, shared by its providers
+            poesie::Provider streaming(engine, 43,
+                R"({"memory_views": {"streaming": {"chunk_size": 4, "pipeline_depth": 2}}})");
+
+            auto code = R"(
+            function use_hash(view)
+                assert(memory_view_hash(view, "crc32c", 1, 9) == "e3069283", "invalid crc32c")
+                assert(memory_view_hash(view, "xxh64", 1, 3) == "3c697d223fa7e885", "invalid xxh64")
+                local hasher = memory_view_hasher("sha256")
+                for first, last in memory_view_chunks(view) do
+                    hasher:update(view, first, last)
+                end
+                assert(hasher:digest() == memory_view_hash(view, "sha256"), "invalid incremental hash")
+                return memory_view_hash(view, "sha256", 1, 3)
+            end
+            )";
+
+            REQUIRE_NOTHROW([&]() { rh.execute(code).wait(); }());
+
+            // a fragmented bulk handle forces the data to be streamed
+            std::string data1 = "12345678";
+            std::string data2 = "9ABCDEFG";
+            auto bulk = engine.expose({{data1.data(), data1.size()},
+                                       {data2.data(), data2.size()}},
+                                       thallium::bulk_mode::read_only);
+
+            poesie::VmHandle::ArgsType args(1);
+            args[0] = poesie::MemoryView{
+                engine, bulk, engine.self(),
+                poesie::MemoryView::Intent::IN};
+
+            poesie::VmHandle::FutureType future;
+            REQUIRE_NOTHROW([&]() { future = rh.call("use_hash", "", args); }());
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = future.wait(); }());
+            REQUIRE(result.get<std::string>()
+                    == "a665a45920422f9d417e4867efdc4fb8a04a1f3fff1fa07e998e86f7f7a27ae3");
+        }
+
+        SECTION("Compress and decompress MemoryView") {
+
+            auto code = R"(
+            function find_codec()
+                for _, c in ipairs({"zstd", "lz4"}) do
+                    if pcall(memory_view_compress_bound, c, 1) then
+                        return c
+                    end
+                end
+                return ""
+            end
+            function use_compression(codec, view, out, back)
+                local size = memory_view_compress(view, codec, out)
+                local compressed = memory_view_slice(out, 1, size)
+                local decompressed = memory_view_decompress(compressed, codec)
+                assert(memory.tostring(decompressed) == memory.tostring(view), "invalid content")
+                return { size, memory_view_decompress(compressed, codec, back) }
+            end
+            function decompress(codec, view)
+                return #memory_view_decompress(view, codec)
+            end
+            )";
+
+            REQUIRE_NOTHROW([&]() { rh.execute(code).wait(); }());
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = rh.call("find_codec", "", {}).wait(); }());
+            auto codec = result.get<std::string>();
+            if(codec.empty()) SKIP("poesie was built without compression libraries");
+
+            std::string data, out(4096, '\0'), back(4096, '\0');
+            while(data.size() < 4096) data += "ABCDEFGHIJKLMNOP";
+
+            poesie::VmHandle::ArgsType args(4);
+            args[0] = codec;
+            args[1] = poesie::MemoryView{
+                engine, data.data(), data.size(),
+                poesie::MemoryView::Intent::IN};
+            args[2] = poesie::MemoryView{
+                engine, out.data(), out.size(),
+                poesie::MemoryView::Intent::OUT};
+            args[3] = poesie::MemoryView{
+                engine, back.data(), back.size(),
+                poesie::MemoryView::Intent::OUT};
+
+            REQUIRE_NOTHROW([&]() { result = rh.call("use_compression", "", args).wait(); }());
+            auto size = result[0].get<size_t>();
+            REQUIRE(size != 0);
+            REQUIRE(size < data.size());
+            REQUIRE(result[1].get<size_t>() == data.size());
+            REQUIRE(back == data);
+
+            // the size of the decompressed data is capped
+            poesie::Provider capped(engine, 43,
+                R"({"memory_views": {"compression": {"max_decompressed_size": 1024}}})");
+            poesie::VmHandle::ArgsType compressed(2);
+            compressed[0] = codec;
+            compressed[1] = poesie::MemoryView{
+                engine, out.data(), size,
+                poesie::MemoryView::Intent::IN};
+            REQUIRE_THROWS_AS(rh.call("decompress", "", compressed).wait(), poesie::Exception);
+        }
     }
 }
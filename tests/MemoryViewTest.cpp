@@ -10,6 +10,10 @@
 #include <poesie/Provider.hpp>
 #include <poesie/Backend.hpp>
 #include <poesie/MemoryView.hpp>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
 
 using json = nlohmann::json;
 
@@ -91,6 +95,10 @@ TEST_CASE("MemoryView test", "[memory-view]") {
             view1.toJson()};
         REQUIRE(view1.size() == view2.size());
         REQUIRE(view1.data() == view2.data());
+        // descriptors with an unknown intent are rejected
+        auto tampered = view1.toJson();
+        tampered.get_binary()[0] = 0x7;
+        REQUIRE_THROWS_AS((poesie::MemoryView{engine, tampered}), poesie::Exception);
     }
 
     SECTION("Serialize MemoryView with dump") {
@@ -189,4 +197,377 @@ TEST_CASE("MemoryView test", "[memory-view]") {
         REQUIRE(std::memcmp(data1.data(), expected.data(), data1.size()) == 0);
         REQUIRE(std::memcmp(data2.data(), expected.data() + data1.size(), data2.size()) == 0);
     }
+
+    SECTION("Send Fragmented InOut MemoryView using the buffer pool") {
+        poesie::Provider provider(engine, 42,
+            R"({"memory_views": {"pool": {"max_pinned_bytes": 65536}}})");
+        for(int iteration = 0; iteration < 2; ++iteration) {
+            std::vector<char> data1(64);
+            std::vector<char> data2(64);
+            std::vector<char> expected(128);
+            for(size_t i = 0; i < expected.size(); ++i) {
+                if(i < data1.size()) {
+                    data1[i] = 'A' + (i%26);
+                } else {
+                    data2[i-data1.size()] = 'A' + (i%26);
+                }
+                expected[i] = 'A' + ((i + 1)%26);
+            }
+            auto bulk = engine.expose({{data1.data(), data1.size()},
+                                       {data2.data(), data2.size()}},
+                                       thallium::bulk_mode::read_write);
+            auto view = poesie::MemoryView{
+                engine, bulk, engine.self(),
+                poesie::MemoryView::Intent::INOUT};
+            auto args = json::object();
+            args["view"] = view;
+            int ret = rpc.on(engine.self())(args.dump());
+            REQUIRE(ret == 0);
+            REQUIRE(std::memcmp(data1.data(), expected.data(), data1.size()) == 0);
+            REQUIRE(std::memcmp(data2.data(), expected.data() + data1.size(), data2.size()) == 0);
+        }
+        auto stats = json::parse(provider.getStatistics());
+        REQUIRE(stats["memory_views"]["pool"]["misses"].get<size_t>() == 1);
+        REQUIRE(stats["memory_views"]["pool"]["hits"].get<size_t>() == 1);
+        // an OUT view borrowing the same buffer does not see the previous data
+        std::vector<char> data1(64, 'x');
+        std::vector<char> data2(64, 'x');
+        auto bulk = engine.expose({{data1.data(), data1.size()},
+                                   {data2.data(), data2.size()}},
+                                   thallium::bulk_mode::read_write);
+        auto view = poesie::MemoryView{
+            engine, bulk, engine.self(),
+            poesie::MemoryView::Intent::OUT};
+        auto data = view.data();
+        REQUIRE(std::all_of(data, data + view.size(), [](char c) { return c == 0; }));
+        stats = json::parse(provider.getStatistics());
+        REQUIRE(stats["memory_views"]["pool"]["hits"].get<size_t>() == 2);
+    }
+
+    SECTION("Stream MemoryView in chunks") {
+        poesie::Provider provider(engine, 42,
+            R"({"memory_views": {"streaming": {"chunk_size": 16, "pipeline_depth": 2}}})");
+        std::vector<char> data1(64);
+        std::vector<char> data2(64);
+        std::vector<char> expected(128);
+        for(size_t i = 0; i < expected.size(); ++i) {
+            if(i < data1.size()) {
+                data1[i] = 'A' + (i%26);
+            } else {
+                data2[i-data1.size()] = 'A' + (i%26);
+            }
+            expected[i] = 'A' + (i%26);
+        }
+        auto bulk = engine.expose({{data1.data(), data1.size()},
+                                   {data2.data(), data2.size()}},
+                                   thallium::bulk_mode::read_only);
+        auto view = poesie::MemoryView{
+            engine, bulk, engine.self(),
+            poesie::MemoryView::Intent::IN};
+        REQUIRE(view.chunkSize() == 16);
+        REQUIRE(view.numChunks() == 8);
+        for(size_t i = 0; i < view.numChunks(); ++i) {
+            auto chunk = view.waitChunk(i);
+            REQUIRE(chunk == view.rawData() + i*16);
+            REQUIRE(std::memcmp(chunk, expected.data() + i*16, 16) == 0);
+            REQUIRE(poesie::MemoryView::FromData(chunk) == view);
+        }
+        REQUIRE(std::memcmp(view.data(), expected.data(), expected.size()) == 0);
+    }
+
+    SECTION("Lazy MemoryView") {
+        poesie::Provider provider(engine, 42,
+            R"({"memory_views": {"lazy": {"page_size": 16}}})");
+        std::vector<char> data1(64);
+        std::vector<char> data2(64);
+        for(size_t i = 0; i < 128; ++i) {
+            if(i < data1.size()) {
+                data1[i] = 'A' + (i%26);
+            } else {
+                data2[i-data1.size()] = 'A' + (i%26);
+            }
+        }
+        auto bulk = engine.expose({{data1.data(), data1.size()},
+                                   {data2.data(), data2.size()}},
+                                   thallium::bulk_mode::read_write);
+        {
+            auto view = poesie::MemoryView{
+                engine, bulk, engine.self(),
+                poesie::MemoryView::Intent::INOUT};
+            REQUIRE(view.isLazy());
+            REQUIRE(view.chunkSize() == 16);
+            auto p = view.access(20, 4);
+            REQUIRE(p == view.rawData() + 20);
+            REQUIRE(std::memcmp(p, "UVWX", 4) == 0);
+            // modify a byte through access and another one without
+            *view.access(40, 1, true) = '#';
+            *(view.rawData() + 100) = '#';
+        }
+        REQUIRE(data1[40] == '#');
+        REQUIRE(data2[100-64] == 'A' + (100%26));
+    }
+
+    SECTION("Push back only the modified ranges") {
+        poesie::Provider provider(engine, 42,
+            R"({"memory_views": {"track_writes": true}})");
+        std::vector<char> data1(64);
+        std::vector<char> data2(64);
+        for(size_t i = 0; i < 128; ++i) {
+            if(i < data1.size()) {
+                data1[i] = 'A' + (i%26);
+            } else {
+                data2[i-data1.size()] = 'A' + (i%26);
+            }
+        }
+        auto bulk = engine.expose({{data1.data(), data1.size()},
+                                   {data2.data(), data2.size()}},
+                                   thallium::bulk_mode::read_write);
+        {
+            auto view = poesie::MemoryView{
+                engine, bulk, engine.self(),
+                poesie::MemoryView::Intent::INOUT};
+            REQUIRE(!view.isLazy());
+            REQUIRE(view.tracksWrites());
+            REQUIRE(poesie::MemoryView::FromData(view.rawData() + 10) == view);
+            // two adjacent writes across the fragments and an isolated one
+            std::memcpy(view.access(60, 4, true), "abcd", 4);
+            std::memcpy(view.access(64, 2, true), "ef", 2);
+            *view.access(100, 1, true) = '#';
+            // a write without access is not pushed back
+            *(view.rawData() + 10) = '#';
+        }
+        REQUIRE(std::memcmp(data1.data() + 60, "abcd", 4) == 0);
+        REQUIRE(std::memcmp(data2.data(), "ef", 2) == 0);
+        REQUIRE(data2[100-64] == '#');
+        REQUIRE(data1[10] == 'A' + 10);
+        REQUIRE(data2[2] == 'A' + (66%26));
+    }
+
+    SECTION("Write back MemoryViews asynchronously") {
+        std::vector<char> data1(64, 'A');
+        std::vector<char> data2(64, 'B');
+        auto bulk = engine.expose({{data1.data(), data1.size()},
+                                   {data2.data(), data2.size()}},
+                                   thallium::bulk_mode::read_write);
+        {
+            auto view1 = poesie::MemoryView{
+                engine, bulk, engine.self(),
+                poesie::MemoryView::Intent::OUT, 0, 96};
+            auto view2 = poesie::MemoryView{
+                engine, bulk, engine.self(),
+                poesie::MemoryView::Intent::INOUT, 96, 32};
+            std::memset(view1.data(), 'x', view1.size());
+            REQUIRE(std::memcmp(view2.data(), std::string(32, 'B').data(), 32) == 0);
+            std::memset(view2.data(), 'y', view2.size());
+            view1.writeBack();
+            view2.writeBack();
+            // a second call has no effect
+            view2.writeBack();
+        }
+        REQUIRE(data1 == std::vector<char>(64, 'x'));
+        REQUIRE(std::equal(data2.begin(), data2.begin() + 32, std::string(32, 'x').begin()));
+        REQUIRE(std::equal(data2.begin() + 32, data2.end(), std::string(32, 'y').begin()));
+    }
+
+    SECTION("Scatter-gather MemoryView") {
+        std::string a = "ABCD", b = "EFGHIJ", c = "KL";
+        auto view = poesie::MemoryView{
+            engine, {{a.data(), a.size()}, {b.data(), b.size()}, {c.data(), c.size()}},
+            poesie::MemoryView::Intent::INOUT};
+        REQUIRE(view.size() == 12);
+        using segments = std::vector<std::pair<size_t, size_t>>;
+        REQUIRE(view.segments() == segments{{0, 4}, {4, 6}, {10, 2}});
+        {
+            // the segments are seen as a single buffer on the provider side
+            auto received = poesie::MemoryView{engine, view.toJson()};
+            REQUIRE(received.segments() == view.segments());
+            REQUIRE(std::string{received.data(), received.size()} == "ABCDEFGHIJKL");
+            REQUIRE(poesie::MemoryView::FromData(received.rawData() + 5) == received);
+            std::memcpy(received.data() + 3, "xyz", 3);
+        }
+        REQUIRE(a == "ABCx");
+        REQUIRE(b == "yzGHIJ");
+        // the segments of a view built from a bulk handle are unknown
+        auto bulk = engine.expose({{a.data(), a.size()}, {b.data(), b.size()}},
+                                  thallium::bulk_mode::read_write);
+        auto other = poesie::MemoryView{engine, bulk, engine.self(),
+                                        poesie::MemoryView::Intent::IN};
+        REQUIRE(other.segments() == segments{{0, 10}});
+    }
+
+    SECTION("Decode MemoryView descriptors through the cache") {
+        poesie::Provider provider(engine, 42,
+            R"({"memory_views": {"descriptor_cache": {"capacity": 2}}})");
+        std::string a = "ABCD", b = "EFGH", c = "IJKL";
+        auto view_a = poesie::MemoryView{engine, a.data(), a.size(), poesie::MemoryView::Intent::IN};
+        auto view_b = poesie::MemoryView{engine, b.data(), b.size(), poesie::MemoryView::Intent::IN};
+        auto view_c = poesie::MemoryView{engine, c.data(), c.size(), poesie::MemoryView::Intent::IN};
+        auto json_a = view_a.toJson();
+        for(int i = 0; i < 3; ++i) {
+            auto received = poesie::MemoryView{engine, json_a};
+            REQUIRE(std::string{received.data(), received.size()} == "ABCD");
+        }
+        // the dumped form decodes to the same descriptor
+        auto dumped = poesie::MemoryView{engine, json::parse(json_a.dump())};
+        REQUIRE(std::string{dumped.data(), dumped.size()} == "ABCD");
+        auto stats = json::parse(provider.getStatistics());
+        REQUIRE(stats["memory_views"]["descriptor_cache"]["misses"].get<size_t>() == 1);
+        REQUIRE(stats["memory_views"]["descriptor_cache"]["hits"].get<size_t>() == 3);
+        // decoding b and c evicts a
+        poesie::MemoryView{engine, view_b.toJson()};
+        poesie::MemoryView{engine, view_c.toJson()};
+        poesie::MemoryView{engine, json_a};
+        stats = json::parse(provider.getStatistics());
+        REQUIRE(stats["memory_views"]["descriptor_cache"]["misses"].get<size_t>() == 4);
+        REQUIRE(stats["memory_views"]["descriptor_cache"]["size"].get<size_t>() == 2);
+    }
+
+    SECTION("Reuse registrations of client buffers") {
+        poesie::Provider provider(engine, 42,
+            R"({"memory_views": {"registration_cache": {"capacity": 1}}})");
+        std::string a = "ABCD", b = "EFGH";
+        auto get_stats = [&]() {
+            return json::parse(provider.getStatistics())["memory_views"]["registration_cache"];
+        };
+        {
+            auto view1 = poesie::MemoryView{engine, a.data(), a.size(), poesie::MemoryView::Intent::IN};
+            auto view2 = poesie::MemoryView{engine, a.data(), a.size(), poesie::MemoryView::Intent::INOUT};
+            REQUIRE(get_stats()["in_use"].get<size_t>() == 1);
+            // registrations in use are never evicted
+            auto view3 = poesie::MemoryView{engine, b.data(), b.size(), poesie::MemoryView::Intent::IN};
+            REQUIRE(get_stats()["size"].get<size_t>() == 2);
+            auto received = poesie::MemoryView{engine, view2.toJson()};
+            std::memcpy(received.access(0, 4, true), "abcd", 4);
+        }
+        REQUIRE(a == "abcd");
+        auto stats = get_stats();
+        REQUIRE(stats["hits"].get<size_t>() == 1);
+        REQUIRE(stats["misses"].get<size_t>() == 2);
+        REQUIRE(stats["in_use"].get<size_t>() == 0);
+        REQUIRE(stats["size"].get<size_t>() == 1);
+        REQUIRE(stats["evictions"].get<size_t>() == 1);
+        // b was released first and evicted, a was kept
+        auto view = poesie::MemoryView{engine, a.data(), a.size(), poesie::MemoryView::Intent::IN};
+        REQUIRE(get_stats()["hits"].get<size_t>() == 2);
+    }
+
+    SECTION("Enable the registration cache from a client") {
+        poesie::Provider provider(engine, 42, "{}");
+        auto get_stats = [&]() {
+            return json::parse(provider.getStatistics())["memory_views"]["registration_cache"];
+        };
+        std::string a = "ABCD";
+        // the cache is disabled by default
+        {
+            auto view1 = poesie::MemoryView{engine, a.data(), a.size(), poesie::MemoryView::Intent::IN};
+            auto view2 = poesie::MemoryView{engine, a.data(), a.size(), poesie::MemoryView::Intent::IN};
+        }
+        REQUIRE(get_stats()["size"].get<size_t>() == 0);
+        REQUIRE(get_stats()["hits"].get<size_t>() == 0);
+        poesie::Client client(engine);
+        client.setRegistrationCacheCapacity(4);
+        REQUIRE(json::parse(client.getConfig())["registration_cache"]["capacity"] == 4);
+        {
+            auto view1 = poesie::MemoryView{engine, a.data(), a.size(), poesie::MemoryView::Intent::IN};
+            auto view2 = poesie::MemoryView{engine, a.data(), a.size(), poesie::MemoryView::Intent::IN};
+        }
+        REQUIRE(get_stats()["size"].get<size_t>() == 1);
+        REQUIRE(get_stats()["hits"].get<size_t>() == 1);
+    }
+
+    SECTION("Slice MemoryView") {
+        poesie::Provider provider(engine, 42,
+            R"({"memory_views": {"track_writes": true}})");
+        std::vector<char> data1(64);
+        std::vector<char> data2(64);
+        for(size_t i = 0; i < 128; ++i) {
+            if(i < data1.size()) {
+                data1[i] = 'A' + (i%26);
+            } else {
+                data2[i-data1.size()] = 'A' + (i%26);
+            }
+        }
+        auto bulk = engine.expose({{data1.data(), data1.size()},
+                                   {data2.data(), data2.size()}},
+                                   thallium::bulk_mode::read_write);
+        {
+            auto view = poesie::MemoryView{
+                engine, bulk, engine.self(),
+                poesie::MemoryView::Intent::INOUT};
+            auto slice = view.slice(60, 8);
+            REQUIRE(slice.size() == 8);
+            REQUIRE(slice.rawData() == view.rawData() + 60);
+            REQUIRE(std::string{slice.access(0, 8), 8} == "IJKLMNOP");
+            auto sub = slice.slice(2, 4);
+            REQUIRE(sub.rawData() == view.rawData() + 62);
+            REQUIRE(sub.tracksWrites());
+            // writes through the slices are tracked by the parent view
+            std::memcpy(sub.access(0, 4, true), "klmn", 4);
+            // the serialized slice refers to the owner's memory
+            auto received = poesie::MemoryView{engine, slice.toJson()};
+            REQUIRE(std::string{received.access(0, 8), 8} == "IJKLMNOP");
+            REQUIRE_THROWS_AS(view.slice(100, 40), poesie::Exception);
+            // ranges whose end overflows are rejected too
+            REQUIRE_THROWS_AS(view.slice(8, SIZE_MAX - 4), poesie::Exception);
+            REQUIRE_THROWS_AS(view.access(8, SIZE_MAX - 4), poesie::Exception);
+        }
+        REQUIRE(std::memcmp(data1.data() + 62, "kl", 2) == 0);
+        REQUIRE(std::memcmp(data2.data(), "mn", 2) == 0);
+        REQUIRE(data2[2] == 'A' + (66%26));
+    }
+
+    SECTION("Allocate MemoryView") {
+        auto view = poesie::MemoryView::Allocate(engine, 16);
+        REQUIRE(view.size() == 16);
+        REQUIRE(view.intent() == poesie::MemoryView::Intent::INOUT);
+        std::memcpy(view.access(0, 16, true), "ABCDEFGHIJKLMNOP", 16);
+        auto received = poesie::MemoryView{engine, view.toJson()};
+        REQUIRE(std::string{received.access(0, 16), 16} == "ABCDEFGHIJKLMNOP");
+        REQUIRE_THROWS_AS(poesie::MemoryView::Allocate(engine, 0), poesie::Exception);
+    }
+
+    SECTION("File-backed MemoryView") {
+        auto path = std::string{"poesie-memory-view-test.dat"};
+        {
+            std::ofstream file{path, std::ios::binary};
+            file << "ABCDEFGHIJKLMNOP";
+        }
+        // no file can be mapped unless allowed by the configuration
+        REQUIRE_THROWS_AS(poesie::MemoryView::FromFile(engine, path), poesie::Exception);
+        poesie::Provider provider(engine, 43, R"({"memory_views": {"files": {"directories": ["."]}}})");
+        // files can only be mapped for reading unless "writable" is set
+        REQUIRE_THROWS_AS(poesie::MemoryView::FromFile(
+            engine, path, 0, std::nullopt, poesie::MemoryView::Intent::INOUT), poesie::Exception);
+        // files outside of the directories can't be mapped
+        REQUIRE_THROWS_AS(poesie::MemoryView::FromFile(engine, "/etc/hostname"), poesie::Exception);
+        REQUIRE_THROWS_AS(poesie::MemoryView::FromFile(engine, "../" + path), poesie::Exception);
+        poesie::Provider writable_provider(engine, 44,
+            R"({"memory_views": {"files": {"directories": ["."], "writable": true}}})");
+        {
+            auto view = poesie::MemoryView::FromFile(engine, path, 3, 5);
+            REQUIRE(view.size() == 5);
+            REQUIRE(std::string{view.access(0, 5), 5} == "DEFGH");
+            // the serialized view refers to the mapped memory
+            auto received = poesie::MemoryView{engine, view.toJson()};
+            REQUIRE(std::string{received.access(0, 5), 5} == "DEFGH");
+            // input mappings are private to the process
+            std::memcpy(view.access(0, 2, true), "de", 2);
+        }
+        {
+            auto view = poesie::MemoryView::FromFile(
+                engine, path, 8, std::nullopt, poesie::MemoryView::Intent::INOUT);
+            REQUIRE(view.size() == 8);
+            std::memcpy(view.access(0, 4, true), "ijkl", 4);
+        }
+        {
+            std::ifstream file{path, std::ios::binary};
+            std::string content{std::istreambuf_iterator<char>{file}, {}};
+            REQUIRE(content == "ABCDEFGHijklMNOP");
+        }
+        REQUIRE_THROWS_AS(poesie::MemoryView::FromFile(engine, path, 12, 8),
+                          poesie::Exception);
+        REQUIRE_THROWS_AS(poesie::MemoryView::FromFile(engine, "nonexistent.dat"),
+                          poesie::Exception);
+        std::remove(path.c_str());
+    }
 }
@@ -0,0 +1,81 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_all.hpp>
+#include "Ensure.hpp"
+#include <poesie/Client.hpp>
+#include <poesie/Provider.hpp>
+#include <poesie/Backend.hpp>
+
+TEST_CASE("Multiple VMs test", "[multi-vm]") {
+    auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
+    ENSURE(engine.finalize());
+    const auto provider_config = R"(
+    {
+        "vm": {
+            "type": "javascript",
+            "config": {
+                "preamble_file": "example-preamble.js"
+            }
+        },
+        "vms": {
+            "tenant_a": {
+                "type": "javascript",
+                "config": {}
+            },
+            "tenant_b": {
+                "type": "javascript",
+                "config": {},
+                "replicas": 2
+            }
+        }
+    }
+    )";
+    poesie::Provider provider(engine, 42, provider_config);
+
+    auto config = nlohmann::json::parse(provider.getConfig());
+    REQUIRE(config["vm"]["type"] == "javascript");
+    REQUIRE(config["vms"]["tenant_a"]["type"] == "javascript");
+    REQUIRE(config["vms"]["tenant_b"]["replicas"] == 2);
+    REQUIRE(provider.getSharedBackend("tenant_a") != nullptr);
+    REQUIRE(provider.getSharedBackend("tenant_a") != provider.getSharedBackend());
+    REQUIRE(provider.getSharedBackend("tenant_c") == nullptr);
+
+    SECTION("Create VmHandles") {
+        poesie::Client client(engine);
+        std::string addr = engine.self();
+
+        auto rh   = client.makeVmHandle(addr, 42);
+        auto rh_a = client.makeVmHandle(addr, 42, "tenant_a");
+        auto rh_b = client.makeVmHandle(addr, 42, "tenant_b");
+        REQUIRE(rh.vmName() == "");
+        REQUIRE(rh_a.vmName() == "tenant_a");
+
+        SECTION("Keep the state of each VM separate") {
+
+            poesie::VmHandle::ReturnType result;
+
+            REQUIRE_NOTHROW(rh_a.execute("var owner = 'a';").wait());
+            REQUIRE_NOTHROW(rh_b.execute("var owner = 'b';").wait());
+
+            REQUIRE_NOTHROW([&]() { result = rh_a.execute("owner").wait(); }());
+            REQUIRE(result.get<std::string>() == "a");
+            REQUIRE_NOTHROW([&]() { result = rh_b.execute("owner").wait(); }());
+            REQUIRE(result.get<std::string>() == "b");
+            REQUIRE_THROWS_AS(rh.execute("owner").wait(), poesie::Exception);
+
+            // only the default VM loaded the preamble
+            REQUIRE_NOTHROW([&]() { result = rh.call("my_add", "", {1,2}).wait(); }());
+            REQUIRE(result.get<int>() == 3);
+            REQUIRE_THROWS_AS(rh_a.call("my_add", "", {1,2}).wait(), poesie::Exception);
+        }
+
+        SECTION("Target a VM that does not exist") {
+            auto rh_c = client.makeVmHandle(addr, 42, "tenant_c");
+            REQUIRE_THROWS_AS(rh_c.execute("1").wait(), poesie::Exception);
+        }
+    }
+}
@@ -10,6 +10,8 @@
 #include <poesie/Provider.hpp>
 #include <poesie/Backend.hpp>
 #include <poesie/MemoryView.hpp>
+#include <vector>
+#include <cstdint>
 
 TEST_CASE("Python vm test", "[python]") {
     auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
@@ -21,16 +23,32 @@ TEST_CASE("Python vm test", "[python]") {
             "config": {
                 "preamble_file": "example-preamble.py"
             }
-        }
+        },
+        "remote_vms": {"enabled": true}
     }
     )";
     poesie::Provider provider(engine, 42, provider_config);
-    provider.getBackend()->install("my_print",
+    provider.getSharedBackend()->install("my_print",
         [](poesie::Backend::ArgsType args) -> poesie::Backend::ReturnType {
             std::cout << "From foreign function: " << args[0].get<std::string>() << std::endl;
             return "Return from foreign function";
         }, 1);
 
+    SECTION("Reject configurations requiring a second interpreter") {
+        REQUIRE_THROWS_AS(poesie::Provider(engine, 43, R"(
+            {"vm": {"type": "python", "isolation": "per_request"}})"), poesie::Exception);
+        REQUIRE_THROWS_AS(poesie::Provider(engine, 43, R"(
+            {"vm": {"type": "python", "replicas": 2}})"), poesie::Exception);
+        REQUIRE_THROWS_AS(poesie::Provider(engine, 43, R"(
+            {"vms": {"a": {"type": "python"}, "b": {"type": "python"}}})"), poesie::Exception);
+        // the interpreter is already held by the VM of provider 42
+        REQUIRE_THROWS_AS(poesie::Provider(engine, 43, R"(
+            {"vm": {"type": "python"}})"), poesie::Exception);
+        poesie::Client client(engine);
+        REQUIRE_THROWS_AS(client.createVm(engine.self(), 42, "job", {{"clone_from", ""}}),
+                          poesie::Exception);
+    }
+
     SECTION("Create VmHandle") {
         poesie::Client client(engine);
         std::string addr = engine.self();
@@ -186,5 +204,119 @@ def use_memory_view(view):
             REQUIRE(data == "abcdefghijklmnop");
         }
 
+        SECTION("Use native kernels, hashing, and compression") {
+
+            auto code = R"(
+def use_native(ints, wrapping, text, out):
+    total = memory_view_reduce(ints, "i64", "sum")
+    assert type(total) is int and total == 9007199254740995, "invalid sum"
+    try:
+        memory_view_reduce(wrapping, "u64", "sum")
+        assert False, "overflow not detected"
+    except ValueError:
+        pass
+    assert memory_view_count(text, ord("l")) == 3, "invalid count"
+    assert memory_view_find(text, b"world") == 16, "invalid find"
+    assert memory_view_hash(text, "crc32c", 0, 9) == "e3069283", "invalid crc32c"
+    for codec in ["zstd", "lz4"]:
+        try:
+            memory_view_compress_bound(codec, 1)
+        except ValueError:
+            continue
+        size = memory_view_compress(text, codec, out)
+        back = memory_view_decompress(out[:size], codec)
+        assert bytes(back) == bytes(text), "invalid decompressed content"
+    return True
+    )";
+
+            REQUIRE_NOTHROW([&]() { rh.execute(code).wait(); }());
+
+            std::vector<int64_t> ints = {(int64_t{1} << 53) + 1, 2};
+            std::vector<uint64_t> wrapping = {uint64_t{1} << 63, uint64_t{1} << 63};
+            std::string text = "123456789 hello world";
+            std::string out(256, '\0');
+
+            poesie::VmHandle::ArgsType args(4);
+            args[0] = poesie::MemoryView{
+                engine, reinterpret_cast<const char*>(ints.data()),
+                ints.size()*sizeof(int64_t), poesie::MemoryView::Intent::IN};
+            args[1] = poesie::MemoryView{
+                engine, reinterpret_cast<const char*>(wrapping.data()),
+                wrapping.size()*sizeof(uint64_t), poesie::MemoryView::Intent::IN};
+            args[2] = poesie::MemoryView{
+                engine, text.data(), text.size(),
+                poesie::MemoryView::Intent::IN};
+            args[3] = poesie::MemoryView{
+                engine, out.data(), out.size(),
+                poesie::MemoryView::Intent::OUT};
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = rh.call("use_native", "", args).wait(); }());
+            REQUIRE(result.get<bool>());
+        }
+
+        SECTION("Use streamed MemoryView") {
+            // streaming is a setting of the engine, shared by its providers
+            poesie::Provider streaming(engine, 43,
+                R"({"memory_views": {"streaming": {"chunk_size": 4, "pipeline_depth": 2}}})");
+
+            // the script reads the view without waiting for its chunks
+            auto code = R"(
+def use_streamed_memory_view(view):
+    content = bytes(view).decode('utf8')
+    for i in range(len(view)):
+        view[i] = 97 + (i % 26)
+    return content
+    )";
+
+            REQUIRE_NOTHROW([&]() { rh.execute(code).wait(); }());
+
+            // a fragmented bulk handle forces the data to be staged
+            std::string data1 = "ABCDEFGH";
+            std::string data2 = "IJKLMNOP";
+            auto bulk = engine.expose({{data1.data(), data1.size()},
+                                       {data2.data(), data2.size()}},
+                                       thallium::bulk_mode::read_write);
+
+            poesie::VmHandle::ArgsType args(1);
+            args[0] = poesie::MemoryView{
+                engine, bulk, engine.self(),
+                poesie::MemoryView::Intent::INOUT};
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&](){ result = rh.call("use_streamed_memory_view", "", args).wait(); }());
+            REQUIRE(result.get<std::string>() == "ABCDEFGHIJKLMNOP");
+            REQUIRE(data1 + data2 == "abcdefghijklmnop");
+        }
+
+        SECTION("Use lazy MemoryView") {
+            poesie::Provider lazy(engine, 43,
+                R"({"memory_views": {"lazy": {"page_size": 4}}})");
+
+            // input views are lazy too, so they are not exposed as memoryviews
+            auto code = R"(
+def use_lazy_memory_view(view):
+    assert type(view).__name__ == 'TrackedMemoryView'
+    return chr(view[9]) + view[12:16].decode('utf8') + view.tobytes().decode('utf8')
+    )";
+
+            REQUIRE_NOTHROW([&]() { rh.execute(code).wait(); }());
+
+            std::string data1 = "ABCDEFGH";
+            std::string data2 = "IJKLMNOP";
+            auto bulk = engine.expose({{data1.data(), data1.size()},
+                                       {data2.data(), data2.size()}},
+                                       thallium::bulk_mode::read_only);
+
+            poesie::VmHandle::ArgsType args(1);
+            args[0] = poesie::MemoryView{
+                engine, bulk, engine.self(),
+                poesie::MemoryView::Intent::IN};
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&](){ result = rh.call("use_lazy_memory_view", "", args).wait(); }());
+            REQUIRE(result.get<std::string>() == "JMNOPABCDEFGHIJKLMNOP");
+        }
+
     }
 }
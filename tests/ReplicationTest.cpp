@@ -0,0 +1,161 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_all.hpp>
+#include "Ensure.hpp"
+#include <poesie/Client.hpp>
+#include <poesie/Provider.hpp>
+#include <poesie/Backend.hpp>
+#include <poesie/MemoryView.hpp>
+#include <chrono>
+
+TEST_CASE("Replicated vm test", "[replication]") {
+    auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
+    ENSURE(engine.finalize());
+    const auto provider_config = R"(
+    {
+        "vm": {
+            "type": "javascript",
+            "config": {
+                "preamble_file": "example-preamble.js"
+            },
+            "replicas": 3,
+            "read_only": ["get_counter"]
+        }
+    }
+    )";
+    poesie::Provider provider(engine, 42, provider_config);
+    provider.getSharedBackend()->install("my_mult",
+        [](poesie::Backend::ArgsType args) -> poesie::Backend::ReturnType {
+            return args[0].get<int>() * args[1].get<int>();
+        }, 2);
+
+    auto config = nlohmann::json::parse(provider.getConfig());
+    REQUIRE(config["vm"]["type"] == "javascript");
+    REQUIRE(config["vm"]["replicas"] == 3);
+    REQUIRE(config["vm"]["read_only"] == nlohmann::json::array({"get_counter"}));
+
+    SECTION("Create VmHandle") {
+        poesie::Client client(engine);
+        std::string addr = engine.self();
+
+        auto rh = client.makeVmHandle(addr, 42);
+
+        SECTION("Propagate changes to all the replicas") {
+
+            auto code = R"(
+            var counter = 0;
+            function increment(x) { counter += x; return counter; }
+            function get_counter() { return counter; }
+            function get_product() { return my_mult(counter, 2); }
+            )";
+            REQUIRE_NOTHROW(rh.execute(code).wait());
+
+            poesie::VmHandle::ReturnType result;
+            for(int i = 1; i <= 3; ++i) {
+                REQUIRE_NOTHROW([&]() { result = rh.call("increment", "", {i}).wait(); }());
+                REQUIRE(result.get<int>() == i*(i+1)/2);
+            }
+
+            // read-only by configuration
+            for(int i = 0; i < 3; ++i) {
+                REQUIRE_NOTHROW([&]() { result = rh.call("get_counter", "", {}).wait(); }());
+                REQUIRE(result.get<int>() == 6);
+            }
+
+            // read-only by request, using a foreign function installed on all replicas
+            for(int i = 0; i < 3; ++i) {
+                REQUIRE_NOTHROW([&]() { result = rh.call("get_product", "", {}, true).wait(); }());
+                REQUIRE(result.get<int>() == 12);
+            }
+
+            // concurrent read-only calls
+            std::vector<poesie::VmHandle::FutureType> futures;
+            for(int i = 0; i < 8; ++i)
+                futures.push_back(rh.call("get_counter", "", {}));
+            for(auto& future : futures) {
+                REQUIRE_NOTHROW([&]() { result = future.wait(); }());
+                REQUIRE(result.get<int>() == 6);
+            }
+
+            auto stats = nlohmann::json::parse(provider.getStatistics());
+            REQUIRE(stats["vm"]["writes"].get<size_t>() == 5);
+            REQUIRE(stats["vm"]["replicas"].size() == 3);
+            size_t reads = 0;
+            for(auto& replica : stats["vm"]["replicas"]) {
+                REQUIRE(replica["reads"].get<size_t>() > 0);
+                REQUIRE(replica["diverged"].get<bool>() == false);
+                reads += replica["reads"].get<size_t>();
+            }
+            REQUIRE(reads == 14);
+        }
+
+        SECTION("Pass MemoryViews to mutating operations") {
+
+            auto code = R"(
+            var counter = 0;
+            function increment(view) {
+                for(var i = 0; i < view.length; i++) {
+                    counter += view[i] - 48;
+                    view[i] += 1;
+                }
+                return counter;
+            }
+            function get_counter() { return counter; }
+            )";
+            REQUIRE_NOTHROW(rh.execute(code).wait());
+
+            std::string data = "0123";
+            poesie::VmHandle::ArgsType args(1);
+            args[0] = poesie::MemoryView{
+                engine, data.data(), data.size(),
+                poesie::MemoryView::Intent::INOUT};
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = rh.call("increment", "", args).wait(); }());
+            REQUIRE(result.get<int>() == 6);
+            // the view is modified once, not once per replica
+            REQUIRE(data == "1234");
+
+            // every replica saw the original content of the view
+            for(int i = 0; i < 6; ++i) {
+                REQUIRE_NOTHROW([&]() { result = rh.call("get_counter", "", {}).wait(); }());
+                REQUIRE(result.get<int>() == 6);
+            }
+
+            auto stats = nlohmann::json::parse(provider.getStatistics());
+            for(auto& replica : stats["vm"]["replicas"])
+                REQUIRE(replica["diverged"].get<bool>() == false);
+        }
+
+        SECTION("Run started mutating operations to completion") {
+
+            using namespace std::chrono_literals;
+
+            auto code = R"(
+            var counter = 0;
+            function spin(n) { for(var i = 0; i < n; i++) counter += 1; return counter; }
+            function get_counter() { return counter; }
+            )";
+            REQUIRE_NOTHROW(rh.execute(code).wait());
+
+            // the deadline passes while the operation runs,
+            // interrupting it would make the replicas diverge
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = rh.call("spin", "", {2000000}, false, 20ms).wait(); }());
+            REQUIRE(result.get<int>() == 2000000);
+
+            for(int i = 0; i < 6; ++i) {
+                REQUIRE_NOTHROW([&]() { result = rh.call("get_counter", "", {}).wait(); }());
+                REQUIRE(result.get<int>() == 2000000);
+            }
+
+            auto stats = nlohmann::json::parse(provider.getStatistics());
+            for(auto& replica : stats["vm"]["replicas"])
+                REQUIRE(replica["diverged"].get<bool>() == false);
+        }
+    }
+}
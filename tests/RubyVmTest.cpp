@@ -10,6 +10,8 @@
 #include <poesie/Provider.hpp>
 #include <poesie/Backend.hpp>
 #include <poesie/MemoryView.hpp>
+#include <vector>
+#include <cstdint>
 
 TEST_CASE("Ruby vm test", "[ruby]") {
     auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
@@ -25,7 +27,7 @@ TEST_CASE("Ruby vm test", "[ruby]") {
     }
     )";
     poesie::Provider provider(engine, 42, provider_config);
-    provider.getBackend()->install("my_mult",
+    provider.getSharedBackend()->install("my_mult",
         [](poesie::Backend::ArgsType args) -> poesie::Backend::ReturnType {
             return args[0].get<int>() * args[1].get<int>();
         }, 2);
@@ -224,5 +226,63 @@ TEST_CASE("Ruby vm test", "[ruby]") {
             REQUIRE(result.get<bool>());
             REQUIRE(data == "abcdefghijklmnop");
         }
+
+        SECTION("Use native kernels, hashing, and compression") {
+
+            auto code = R"(
+              def use_native(ints, wrapping, text, out)
+                  total = ints.reduce("i64", "sum")
+                  raise "invalid sum" unless total.is_a?(Integer) && total == 9007199254740995
+                  overflow = begin
+                      wrapping.reduce("u64", "sum")
+                      false
+                  rescue ArgumentError
+                      true
+                  end
+                  raise "overflow not detected" unless overflow
+                  raise "invalid count" unless text.count(108) == 3
+                  raise "invalid find" unless text.find("world") == 16
+                  raise "invalid crc32c" unless text.digest("crc32c", 0, 9) == "e3069283"
+                  ["zstd", "lz4"].each do |codec|
+                      available = begin
+                          MemoryView.compress_bound(codec, 1)
+                          true
+                      rescue ArgumentError
+                          false
+                      end
+                      next unless available
+                      size = text.compress(codec, out)
+                      back = out.slice(0, size).decompress(codec)
+                      raise "invalid decompressed content" unless back.to_s == text.to_s
+                  end
+                  return true
+              end
+              )";
+
+            REQUIRE_NOTHROW([&]() { rh.execute(code).wait(); }());
+
+            std::vector<int64_t> ints = {(int64_t{1} << 53) + 1, 2};
+            std::vector<uint64_t> wrapping = {uint64_t{1} << 63, uint64_t{1} << 63};
+            std::string text = "123456789 hello world";
+            std::string out(256, '\0');
+
+            poesie::VmHandle::ArgsType args(4);
+            args[0] = poesie::MemoryView{
+                engine, reinterpret_cast<const char*>(ints.data()),
+                ints.size()*sizeof(int64_t), poesie::MemoryView::Intent::IN};
+            args[1] = poesie::MemoryView{
+                engine, reinterpret_cast<const char*>(wrapping.data()),
+                wrapping.size()*sizeof(uint64_t), poesie::MemoryView::Intent::IN};
+            args[2] = poesie::MemoryView{
+                engine, text.data(), text.size(),
+                poesie::MemoryView::Intent::IN};
+            args[3] = poesie::MemoryView{
+                engine, out.data(), out.size(),
+                poesie::MemoryView::Intent::OUT};
+
+            poesie::VmHandle::ReturnType result;
+            REQUIRE_NOTHROW([&]() { result = rh.call("use_native", "", args).wait(); }());
+            REQUIRE(result.get<bool>());
+        }
     }
 }
@@ -0,0 +1,88 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_all.hpp>
+#include "Ensure.hpp"
+#include <poesie/Client.hpp>
+#include <poesie/Provider.hpp>
+#include <poesie/Backend.hpp>
+
+TEST_CASE("Scheduler test", "[scheduler]") {
+    auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
+    ENSURE(engine.finalize());
+    const auto provider_config = R"(
+    {
+        "vm": {
+            "type": "javascript",
+            "config": {
+                "preamble_file": "example-preamble.js"
+            }
+        },
+        "scheduler": {
+            "classes": {
+                "interactive": { "weight": 4 },
+                "batch": { "weight": 1 }
+            },
+            "default_class": "batch",
+            "rules": {
+                "my_add": "interactive"
+            }
+        }
+    }
+    )";
+    poesie::Provider provider(engine, 42, provider_config);
+
+    auto config = nlohmann::json::parse(provider.getConfig());
+    REQUIRE(config["scheduler"]["concurrency"] == 1);
+    REQUIRE(config["scheduler"]["default_class"] == "batch");
+    REQUIRE(config["scheduler"]["rules"]["my_add"] == "interactive");
+
+    SECTION("Create VmHandle") {
+        poesie::Client client(engine);
+        std::string addr = engine.self();
+
+        auto rh = client.makeVmHandle(addr, 42);
+
+        SECTION("Schedule requests by priority class") {
+
+            poesie::VmHandle::ReturnType result;
+
+            // default class
+            REQUIRE_NOTHROW([&]() { result = rh.execute("my_add(1,2)").wait(); }());
+            REQUIRE(result.get<int>() == 3);
+
+            // class chosen by a rule
+            REQUIRE_NOTHROW([&]() { result = rh.call("my_add", "", {1,2}).wait(); }());
+            REQUIRE(result.get<int>() == 3);
+
+            // class requested by the client
+            auto interactive = rh;
+            interactive.setPriorityClass("interactive");
+            REQUIRE(interactive.priorityClass() == "interactive");
+            REQUIRE(rh.priorityClass() == "");
+            std::vector<poesie::VmHandle::FutureType> futures;
+            for(int i = 0; i < 4; ++i) {
+                futures.push_back(interactive.execute("my_add(1,2)"));
+                futures.push_back(rh.execute("my_add(1,2)"));
+            }
+            for(auto& future : futures) {
+                REQUIRE_NOTHROW([&]() { result = future.wait(); }());
+                REQUIRE(result.get<int>() == 3);
+            }
+
+            // unknown class
+            auto unknown = rh;
+            unknown.setPriorityClass("unknown");
+            REQUIRE_THROWS_AS(unknown.execute("my_add(1,2)").wait(), poesie::Exception);
+
+            auto stats = nlohmann::json::parse(provider.getStatistics());
+            REQUIRE(stats["scheduler"]["interactive"]["completed"] == 5);
+            REQUIRE(stats["scheduler"]["batch"]["completed"] == 5);
+            REQUIRE(stats["scheduler"]["batch"]["queued"] == 0);
+            REQUIRE(stats["scheduler"]["batch"]["running"] == 0);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_all.hpp>
+#include "Ensure.hpp"
+#include <poesie/Client.hpp>
+#include <poesie/Provider.hpp>
+#include <poesie/Backend.hpp>
+
+TEST_CASE("Yield test", "[yield]") {
+    // a single execution stream runs the RPCs and the progress loop
+    auto engine = thallium::engine("na+sm", THALLIUM_SERVER_MODE);
+    ENSURE(engine.finalize());
+    const auto yielding_config = R"(
+    {
+        "vm": {
+            "type": "javascript",
+            "config": { "yield_interval": 10000 }
+        }
+    }
+    )";
+    const auto explicit_config = R"(
+    {
+        "vm": {
+            "type": "javascript",
+            "config": { "yield_interval": 0 }
+        }
+    }
+    )";
+    const auto other_config = R"(
+    {
+        "vm": {
+            "type": "javascript",
+            "config": {
+                "preamble_file": "example-preamble.js"
+            }
+        }
+    }
+    )";
+    poesie::Provider yielding(engine, 42, yielding_config);
+    poesie::Provider explicit_yield(engine, 43, explicit_config);
+    poesie::Provider other(engine, 44, other_config);
+
+    auto config = nlohmann::json::parse(explicit_yield.getConfig());
+    REQUIRE(config["vm"]["config"]["yield_interval"] == 0);
+
+    SECTION("Create VmHandles") {
+        poesie::Client client(engine);
+        std::string addr = engine.self();
+
+        auto other_rh = client.makeVmHandle(addr, 44);
+        poesie::VmHandle::ReturnType result;
+
+        SECTION("Yield every N instructions") {
+            auto rh = client.makeVmHandle(addr, 42);
+            auto busy = rh.execute(
+                "var t = Date.now(); while(Date.now() - t < 1000) {}");
+            // served while the busy script runs
+            REQUIRE_NOTHROW([&]() { result = other_rh.call("my_add", "", {1,2}).wait(); }());
+            REQUIRE(result.get<int>() == 3);
+            REQUIRE(!busy.completed());
+            REQUIRE_NOTHROW(busy.wait());
+        }
+
+        SECTION("Yield explicitly") {
+            auto rh = client.makeVmHandle(addr, 43);
+            auto busy = rh.execute(
+                "var t = Date.now(); while(Date.now() - t < 1000) { poesie_yield(); }");
+            REQUIRE_NOTHROW([&]() { result = other_rh.call("my_add", "", {1,2}).wait(); }());
+            REQUIRE(result.get<int>() == 3);
+            REQUIRE(!busy.completed());
+            REQUIRE_NOTHROW(busy.wait());
+        }
+    }
+}
@@ -0,0 +1,11 @@
+/*
+ * (C) 2024 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <poesie/Backend.hpp>
+
+extern "C" poesie::Backend::ReturnType
+example_plugin_mult(const poesie::Backend::ArgsType& args) {
+    return args[0].get<int>() * args[1].get<int>();
+}